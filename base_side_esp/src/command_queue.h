@@ -0,0 +1,185 @@
+#pragma once
+
+#include <Arduino.h>
+#include "protocol.h"
+
+// Outgoing queue configuration
+#define COMMAND_QUEUE_DEPTH 16  // Room for a few fragmented frames
+#define COMMAND_MAX_SIZE 250  // One ESP-NOW payload
+
+// Priority classes for outgoing ESP-NOW commands (lower value = sent first)
+enum class CommandPriority : uint8_t {
+    CRITICAL = 0,   // EMERGENCY - preempts everything queued
+    STATE,          // Flight state changes
+    STREAM,         // Cosmetic / streaming updates (e.g. BRAINWAVE parameters)
+    COUNT
+};
+
+constexpr uint8_t NUM_PRIORITY_CLASSES = static_cast<uint8_t>(CommandPriority::COUNT);
+
+// Maximum queueing delay before a frame is dropped instead of sent late (0 = never stale)
+constexpr unsigned long PRIORITY_STALE_US[NUM_PRIORITY_CLASSES] = {
+    0,          // CRITICAL: always delivered
+    1000000,    // STATE: 1 s
+    100000      // STREAM: 100 ms, a newer sample will follow
+};
+
+inline const char* priorityToString(CommandPriority priority) {
+    switch (priority) {
+        case CommandPriority::CRITICAL: return "CRITICAL";
+        case CommandPriority::STATE: return "STATE";
+        case CommandPriority::STREAM: return "STREAM";
+        default: return "UNKNOWN";
+    }
+}
+
+struct QueuedCommand {
+    uint8_t data[COMMAND_MAX_SIZE];
+    size_t len;
+    unsigned long enqueuedAt;  // micros()
+    uint8_t framesLeft;        // Frames of its message from this one on (1 = last or only frame)
+};
+
+// Per-class queue statistics
+struct PriorityClassStats {
+    uint32_t enqueued;
+    uint32_t dequeued;
+    uint32_t droppedStale;       // Too old to be worth sending
+    uint32_t droppedOverflow;    // Oldest entry evicted by a newer one
+    uint32_t droppedSuperseded;  // STATE flushed by a CRITICAL command
+    uint64_t latencySumUs;       // Enqueue -> dequeue
+    uint32_t latencyMaxUs;
+};
+
+// Fixed-size, allocation-free outgoing command queue with one FIFO per priority class.
+// Always dequeues from the highest non-empty class, so a CRITICAL command never
+// waits behind queued STATE or STREAM frames.
+//
+// Messages larger than one ESP-NOW frame are queued as consecutive FRAGMENT
+// frames. Eviction and stale dropping always take a whole message, so the drone
+// is never sent part of a message it cannot reassemble. Statistics count frames.
+class CommandQueue {
+public:
+    CommandQueue() : nextMessageId(0) {
+        memset(heads, 0, sizeof(heads));
+        memset(counts, 0, sizeof(counts));
+        memset(stats, 0, sizeof(stats));
+    }
+
+    // Enqueue a message of up to FRAGMENT_MAX_MESSAGE_SIZE bytes, split into
+    // FRAGMENT frames when it does not fit in one. When the class is full its
+    // oldest messages are evicted, since the newest command always supersedes
+    // older ones of the same class. A CRITICAL command also flushes queued STATE
+    // commands, which would otherwise override it once sent.
+    bool push(CommandPriority priority, const uint8_t* data, size_t len, unsigned long nowUs) {
+        if (len == 0 || len > FRAGMENT_MAX_MESSAGE_SIZE) {
+            return false;
+        }
+
+        uint8_t cls = static_cast<uint8_t>(priority);
+        uint8_t frames = len <= COMMAND_MAX_SIZE ? 1 : (len + FRAGMENT_PAYLOAD_SIZE - 1) / FRAGMENT_PAYLOAD_SIZE;
+        while (COMMAND_QUEUE_DEPTH - counts[cls] < frames) {
+            stats[cls].droppedOverflow += dropMessage(cls);
+        }
+        if (priority == CommandPriority::CRITICAL) {
+            uint8_t state = static_cast<uint8_t>(CommandPriority::STATE);
+            while (counts[state] > 0) {
+                stats[state].droppedSuperseded += dropMessage(state);
+            }
+        }
+
+        if (frames == 1) {
+            append(cls, data, len, 1, nowUs);
+            return true;
+        }
+
+        FragmentHeader header;
+        header.header.magic = PROTOCOL_MAGIC;
+        header.header.type = MessageType::FRAGMENT;
+        header.messageId = nextMessageId++;
+        header.fragmentCount = frames;
+        header.totalLength = len;
+        for (uint8_t i = 0; i < frames; i++) {
+            size_t offset = i * FRAGMENT_PAYLOAD_SIZE;
+            size_t chunk = len - offset < FRAGMENT_PAYLOAD_SIZE ? len - offset : FRAGMENT_PAYLOAD_SIZE;
+            header.fragmentIndex = i;
+            QueuedCommand& slot = append(cls, nullptr, sizeof(header) + chunk, frames - i, nowUs);
+            memcpy(slot.data, &header, sizeof(header));
+            memcpy(slot.data + sizeof(header), data + offset, chunk);
+        }
+        return true;
+    }
+
+    // Return the next frame to send (highest priority first), discarding stale
+    // messages on the way. The pointer stays valid until the next push().
+    const QueuedCommand* pop(unsigned long nowUs, CommandPriority& outPriority) {
+        for (uint8_t cls = 0; cls < NUM_PRIORITY_CLASSES; cls++) {
+            while (counts[cls] > 0) {
+                const QueuedCommand& cmd = slots[cls][heads[cls]];
+                unsigned long waited = nowUs - cmd.enqueuedAt;
+                if (PRIORITY_STALE_US[cls] != 0 && waited > PRIORITY_STALE_US[cls]) {
+                    stats[cls].droppedStale += dropMessage(cls);
+                    continue;
+                }
+                heads[cls] = (heads[cls] + 1) % COMMAND_QUEUE_DEPTH;
+                counts[cls]--;
+
+                stats[cls].dequeued++;
+                stats[cls].latencySumUs += waited;
+                if (waited > stats[cls].latencyMaxUs) {
+                    stats[cls].latencyMaxUs = waited;
+                }
+                outPriority = static_cast<CommandPriority>(cls);
+                return &cmd;
+            }
+        }
+        return nullptr;
+    }
+
+    bool isEmpty() const {
+        for (uint8_t cls = 0; cls < NUM_PRIORITY_CLASSES; cls++) {
+            if (counts[cls] > 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint8_t depth(CommandPriority priority) const {
+        return counts[static_cast<uint8_t>(priority)];
+    }
+
+    const PriorityClassStats& getStats(CommandPriority priority) const {
+        return stats[static_cast<uint8_t>(priority)];
+    }
+
+private:
+    QueuedCommand slots[NUM_PRIORITY_CLASSES][COMMAND_QUEUE_DEPTH];
+    uint8_t heads[NUM_PRIORITY_CLASSES];
+    uint8_t counts[NUM_PRIORITY_CLASSES];
+    PriorityClassStats stats[NUM_PRIORITY_CLASSES];
+    uint16_t nextMessageId;
+
+    // Add a frame at the tail of a class with room for it; copies data when given
+    QueuedCommand& append(uint8_t cls, const uint8_t* data, size_t len, uint8_t framesLeft, unsigned long nowUs) {
+        QueuedCommand& slot = slots[cls][(heads[cls] + counts[cls]) % COMMAND_QUEUE_DEPTH];
+        if (data) {
+            memcpy(slot.data, data, len);
+        }
+        slot.len = len;
+        slot.enqueuedAt = nowUs;
+        slot.framesLeft = framesLeft;
+        counts[cls]++;
+        stats[cls].enqueued++;
+        return slot;
+    }
+
+    // Remove the message at the head of a class (what is left of it, if its
+    // first fragments were already sent). Returns the frames removed.
+    uint8_t dropMessage(uint8_t cls) {
+        uint8_t frames = slots[cls][heads[cls]].framesLeft;
+        heads[cls] = (heads[cls] + frames) % COMMAND_QUEUE_DEPTH;
+        counts[cls] -= frames;
+        return frames;
+    }
+};
@@ -2,11 +2,15 @@
 #include <esp_now.h>
 #include <WiFi.h>
 #include <ArduinoJson.h>
+#include "command_queue.h"
+#include "protocol.h"
+#include "frame_encoder.h"
+#include "log_ring.h"
+#include "trace_ring.h"
 
 // Configuration
 #define ESPNOW_CHANNEL 1
-#define MAX_MESSAGE_SIZE 250
-#define SERIAL_BUFFER_SIZE 512
+#define SERIAL_BUFFER_SIZE 2048  // Fits a hex FRAME of FRAME_MAX_PIXELS pixels
 
 // Drone ESP32 MAC address (must be configured)
 // Format: {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF}
@@ -19,18 +23,31 @@ uint32_t sendErrors = 0;
 unsigned long lastStatsTime = 0;
 const unsigned long STATS_INTERVAL = 10000; // 10 seconds
 
+// Outgoing command queue (one ESP-NOW frame in flight at a time)
+CommandQueue commandQueue;
+volatile bool sendInFlight = false;
+unsigned long sendStartTime = 0;
+const unsigned long SEND_TIMEOUT_MS = 50;  // Give up waiting for onDataSent
+
+// Parameter streaming
+uint16_t paramSequence = 0;
+uint16_t frameSequence = 0;
+FrameEncoder frameEncoder;
+
 // Serial buffer for incoming JSON commands
 String serialBuffer = "";
 
 // ESP-NOW send callback
 void onDataSent(const uint8_t* mac, esp_now_send_status_t status) {
+    TRACE_INSTANT(SEND_CALLBACK, status == ESP_NOW_SEND_SUCCESS);
     if (status == ESP_NOW_SEND_SUCCESS) {
-        Serial.println("[ESP-NOW] Message sent successfully");
+        LOG_DEBUG("ESP-NOW", "Message sent successfully");
         messagesSent++;
     } else {
-        Serial.println("[ESP-NOW] Message send failed");
+        LOG_WARN("ESP-NOW", "Message send failed");
         sendErrors++;
     }
+    sendInFlight = false;
 }
 
 bool initEspNow() {
@@ -91,44 +108,188 @@ bool registerDronePeer() {
     return true;
 }
 
+// Queue a message for sending. The queue splits messages that do not fit in a
+// single ESP-NOW frame into FRAGMENT messages; the drone reassembles them.
+bool enqueueMessage(CommandPriority priority, const uint8_t* data, size_t len) {
+    if (!commandQueue.push(priority, data, len, micros())) {
+        LOG_ERROR("ERROR", "Message too large (%u bytes)", (unsigned)len);
+        return false;
+    }
+    return true;
+}
+
+// Map a validated LED command onto its outgoing priority class
+CommandPriority classifyCommand(const StaticJsonDocument<FRAGMENT_MAX_MESSAGE_SIZE>& doc) {
+    const char* pattern = doc["data"]["pattern"];
+    if (doc["data"]["clear"].as<bool>()) {
+        return CommandPriority::STATE;  // Ends a preemption: keep it in order with flight states
+    }
+    if (pattern && strcmp(pattern, "EMERGENCY") == 0) {
+        return CommandPriority::CRITICAL;
+    }
+    if (pattern && strcmp(pattern, "BRAINWAVE") == 0) {
+        return CommandPriority::STREAM;
+    }
+    return CommandPriority::STATE;
+}
+
 void sendLedCommand(const String& jsonCommand) {
     if (!peerRegistered) {
-        Serial.println("[ESP-NOW] Cannot send: peer not registered");
+        LOG_WARN("ESP-NOW", "Cannot send: peer not registered");
         return;
     }
 
-    // Validate JSON
-    StaticJsonDocument<MAX_MESSAGE_SIZE> doc;
+    // Validate JSON; commands larger than one frame are fragmented on send
+    StaticJsonDocument<FRAGMENT_MAX_MESSAGE_SIZE> doc;
     DeserializationError error = deserializeJson(doc, jsonCommand);
 
     if (error) {
-        Serial.printf("[ERROR] Invalid JSON: %s\n", error.c_str());
+        LOG_ERROR("ERROR", "Invalid JSON: %s", error.c_str());
         return;
     }
 
     // Validate message structure
     if (!doc.containsKey("type") || !doc.containsKey("data")) {
-        Serial.println("[ERROR] Missing required fields (type, data)");
+        LOG_ERROR("ERROR", "Missing required fields (type, data)");
         return;
     }
 
     // Serialize and send
-    char buffer[MAX_MESSAGE_SIZE];
+    char buffer[FRAGMENT_MAX_MESSAGE_SIZE];
+    if (measureJson(doc) >= sizeof(buffer)) {
+        LOG_ERROR("ERROR", "Command too large (max %u bytes)", (unsigned)sizeof(buffer) - 1);
+        return;
+    }
     size_t len = serializeJson(doc, buffer, sizeof(buffer));
 
-    if (len == 0) {
-        Serial.println("[ERROR] Failed to serialize JSON");
+    if (len == 0 || len >= sizeof(buffer)) {
+        LOG_ERROR("ERROR", "Failed to serialize JSON");
+        return;
+    }
+
+    // Queue for sending; higher priority classes go out first
+    enqueueMessage(classifyCommand(doc), (const uint8_t*)buffer, len);
+}
+
+// Stream a BRAINWAVE parameter sample: PARAM:<hueShift>,<intensity>,<speed>
+void sendParamSample(const char* args) {
+    if (!peerRegistered) {
+        return;
+    }
+
+    int hueShift, intensity, speed;
+    if (sscanf(args, "%d,%d,%d", &hueShift, &intensity, &speed) != 3) {
+        LOG_ERROR("ERROR", "Invalid PARAM format. Use: PARAM:<hueShift>,<intensity>,<speed>");
+        return;
+    }
+
+    ParamSampleMessage msg;
+    msg.header.magic = PROTOCOL_MAGIC;
+    msg.header.type = MessageType::PARAM_SAMPLE;
+    msg.sequence = paramSequence++;
+    msg.sampleTimeUs = micros();
+    msg.hueShift = (uint8_t)hueShift;
+    msg.intensity = (uint8_t)constrain(intensity, 0, 255);
+    msg.speed = (uint16_t)constrain(speed, 0, 65535);
+
+    enqueueMessage(CommandPriority::STREAM, (const uint8_t*)&msg, sizeof(msg));
+}
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Stream a pixel frame: FRAME:<RRGGBB...> (hex, up to FRAME_MAX_PIXELS pixels)
+void sendFrame(const char* hex) {
+    if (!peerRegistered) {
+        return;
+    }
+
+    size_t hexLen = strlen(hex);
+    if (hexLen == 0 || hexLen % 6 != 0 || hexLen / 6 > FRAME_MAX_PIXELS) {
+        LOG_ERROR("ERROR", "Invalid FRAME: need 1-%u RRGGBB pixels", (unsigned)FRAME_MAX_PIXELS);
         return;
     }
 
-    // Send via ESP-NOW
-    esp_err_t result = esp_now_send(droneMacAddress, (uint8_t*)buffer, len);
+    static uint8_t rgb[FRAME_MAX_PIXELS * 3];
+    for (size_t i = 0; i < hexLen / 2; i++) {
+        int hi = hexNibble(hex[2 * i]);
+        int lo = hexNibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            LOG_ERROR("ERROR", "Invalid FRAME: non-hex character");
+            return;
+        }
+        rgb[i] = (uint8_t)((hi << 4) | lo);
+    }
+
+    static uint8_t buffer[FRAGMENT_MAX_MESSAGE_SIZE];
+    FrameMessageHeader msg;
+    msg.header.magic = PROTOCOL_MAGIC;
+    msg.header.type = MessageType::FRAME;
+    msg.frameNumber = frameSequence++;
+    msg.sampleTimeUs = micros();
+    msg.pixelCount = hexLen / 6;
+
+    // Delta/RLE encode against the previous frame to save airtime
+    size_t payloadLen = frameEncoder.encode(rgb, msg.pixelCount, buffer + sizeof(msg),
+                                            sizeof(buffer) - sizeof(msg), msg.encoding, msg.sampleTimeUs);
+    memcpy(buffer, &msg, sizeof(msg));
+
+    enqueueMessage(CommandPriority::STREAM, buffer, sizeof(msg) + payloadLen);
+}
+
+// Send the next queued command once the previous frame has completed
+void pumpCommandQueue() {
+    if (!peerRegistered) {
+        return;
+    }
+
+    if (sendInFlight) {
+        if (millis() - sendStartTime < SEND_TIMEOUT_MS) {
+            return;
+        }
+        LOG_WARN("ESP-NOW", "Send callback timeout");
+        sendInFlight = false;
+    }
+
+    CommandPriority priority;
+    const QueuedCommand* cmd = commandQueue.pop(micros(), priority);
+    if (!cmd) {
+        return;
+    }
+
+    sendInFlight = true;
+    sendStartTime = millis();
+    TRACE_BEGIN(SEND);
+    esp_err_t result = esp_now_send(droneMacAddress, cmd->data, cmd->len);
+    TRACE_END(SEND, cmd->len);
 
     if (result == ESP_OK) {
-        Serial.printf("[ESP-NOW] Sending command (%d bytes): %s\n", len, buffer);
+        // Binary stream frames are sent at high rate and are not logged
+        if (cmd->data[0] != PROTOCOL_MAGIC) {
+            LOG_INFO("ESP-NOW", "Sending %s command (%d bytes): %.*s",
+                     priorityToString(priority), cmd->len, (int)cmd->len, (const char*)cmd->data);
+        }
     } else {
-        Serial.println("[ESP-NOW] Send error");
+        LOG_WARN("ESP-NOW", "Send error");
         sendErrors++;
+        sendInFlight = false;
+    }
+}
+
+void printQueueStats() {
+    for (uint8_t cls = 0; cls < NUM_PRIORITY_CLASSES; cls++) {
+        CommandPriority priority = static_cast<CommandPriority>(cls);
+        const PriorityClassStats& stats = commandQueue.getStats(priority);
+        unsigned long avgUs = stats.dequeued ? (unsigned long)(stats.latencySumUs / stats.dequeued) : 0;
+        Serial.printf("Queue %-9s depth %u, sent %u, stale %u, overflow %u, superseded %u, "
+                      "latency avg %lu us / max %u us\n",
+                      priorityToString(priority), commandQueue.depth(priority), stats.dequeued,
+                      stats.droppedStale, stats.droppedOverflow, stats.droppedSuperseded, avgUs,
+                      stats.latencyMaxUs);
     }
 }
 
@@ -140,8 +301,20 @@ void processSerialCommand(const String& command) {
     if (trimmed.length() == 0) {
         return;
     }
+    TRACE_INSTANT(SERIAL_IN, trimmed.length());
+
+    // High-rate streams: handled before logging
+    if (trimmed.startsWith("PARAM:")) {
+        sendParamSample(trimmed.c_str() + 6);
+        return;
+    }
+
+    if (trimmed.startsWith("FRAME:")) {
+        sendFrame(trimmed.c_str() + 6);
+        return;
+    }
 
-    Serial.printf("[SERIAL] Received: %s\n", trimmed.c_str());
+    LOG_INFO("SERIAL", "Received: %s", trimmed.c_str());
 
     // Check for special commands
     if (trimmed.startsWith("MAC:")) {
@@ -162,6 +335,11 @@ void processSerialCommand(const String& command) {
         return;
     }
 
+    if (trimmed == "TRACE") {
+        traceRing().dump(Serial, "base");
+        return;
+    }
+
     if (trimmed == "STATUS") {
         // Print status
         Serial.println("========================================");
@@ -171,10 +349,18 @@ void processSerialCommand(const String& command) {
         Serial.printf("Free heap:      %u bytes\n", ESP.getFreeHeap());
         Serial.printf("Messages sent:  %u\n", messagesSent);
         Serial.printf("Send errors:    %u\n", sendErrors);
+        Serial.printf("Log:            Lines: %u, Dropped: %u\n",
+                      logRing().getLinesWritten(), logRing().getLinesDropped());
+        Serial.printf("Trace events:   %u\n", traceRing().getEventsRecorded());
         Serial.printf("Peer status:    %s\n", peerRegistered ? "REGISTERED" : "NOT REGISTERED");
         Serial.printf("Drone MAC:      %02X:%02X:%02X:%02X:%02X:%02X\n",
                       droneMacAddress[0], droneMacAddress[1], droneMacAddress[2],
                       droneMacAddress[3], droneMacAddress[4], droneMacAddress[5]);
+        printQueueStats();
+        uint32_t ratio = frameEncoder.getCompressionRatioX100();
+        Serial.printf("Frames encoded: %u (%u keyframes), compression %u.%02ux\n",
+                      frameEncoder.getFramesEncoded(), frameEncoder.getKeyframes(),
+                      ratio / 100, ratio % 100);
         Serial.println("========================================\n");
         return;
     }
@@ -191,6 +377,9 @@ void printHelp() {
     Serial.println("Commands:");
     Serial.println("  MAC:AA:BB:CC:DD:EE:FF - Set drone MAC address");
     Serial.println("  STATUS - Print system status");
+    Serial.println("  TRACE - Dump the event trace (tools/trace_to_chrome.py)");
+    Serial.println("  PARAM:<hue>,<intensity>,<speed> - Stream BRAINWAVE parameters");
+    Serial.println("  FRAME:<RRGGBB...> - Stream a raw pixel frame (hex)");
     Serial.println("  {JSON} - Send LED command (see below)\n");
     Serial.println("LED Command Format:");
     Serial.println("{");
@@ -205,6 +394,11 @@ void printHelp() {
     Serial.println("}\n");
     Serial.println("Patterns: IDLE, TAKING_OFF, HOVERING, FLYING,");
     Serial.println("          LANDING, EMERGENCY, LOW_BATTERY");
+    Serial.println("Optional data fields:");
+    Serial.println("  \"priority\": NORMAL, HIGH or CRITICAL (EMERGENCY defaults to CRITICAL)");
+    Serial.println("  \"ttl\": ms until a HIGH/CRITICAL pattern expires (0 = until cleared)");
+    Serial.println("  \"clear\": true removes the pattern at that priority");
+    Serial.println("A command without a priority ends an EMERGENCY sent without one.");
     Serial.println("========================================\n");
 }
 
@@ -212,6 +406,7 @@ void setup() {
     // Initialize serial
     Serial.begin(115200);
     delay(1000);
+    logRing().begin();
 
     printHelp();
 
@@ -242,18 +437,21 @@ void loop() {
 
             // Prevent buffer overflow
             if (serialBuffer.length() >= SERIAL_BUFFER_SIZE) {
-                Serial.println("[ERROR] Serial buffer overflow - command too long");
+                LOG_ERROR("ERROR", "Serial buffer overflow - command too long");
                 serialBuffer = "";
             }
         }
     }
 
+    // Send queued commands (highest priority first)
+    pumpCommandQueue();
+
     // Print periodic stats
     unsigned long now = millis();
     if (now - lastStatsTime >= STATS_INTERVAL) {
         lastStatsTime = now;
-        Serial.printf("[STATS] Uptime: %lu s, Sent: %u, Errors: %u\n",
-                      now / 1000, messagesSent, sendErrors);
+        LOG_INFO("STATS", "Uptime: %lu s, Sent: %u, Errors: %u, Log dropped: %u",
+                 now / 1000, messagesSent, sendErrors, logRing().getLinesDropped());
     }
 
     delay(1);
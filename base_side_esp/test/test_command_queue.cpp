@@ -0,0 +1,204 @@
+/**
+ * @file test_command_queue.cpp
+ * @brief Unit tests for the priority-ordered outgoing command queue
+ *
+ * Verifies that:
+ * 1. Commands come out highest class first, in FIFO order within a class
+ * 2. Stale STATE/STREAM commands are dropped while CRITICAL never goes stale
+ * 3. A full class evicts its oldest command and counts the overflow
+ * 4. Oversized and empty commands are rejected
+ * 5. Large messages are fragmented, and evicted or dropped as stale only as a whole
+ * 6. A CRITICAL command flushes the STATE commands it supersedes
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "command_queue.h"
+
+static bool pushByte(CommandQueue& queue, CommandPriority priority, uint8_t value, unsigned long nowUs) {
+    return queue.push(priority, &value, 1, nowUs);
+}
+
+// Test CRITICAL preempts STATE and STREAM, and each class stays in order
+void test_priority_order() {
+    static CommandQueue queue;
+    pushByte(queue, CommandPriority::STREAM, 30, 0);
+    pushByte(queue, CommandPriority::CRITICAL, 10, 0);  // Before the STATE commands, which it would flush
+    pushByte(queue, CommandPriority::STATE, 20, 0);
+    pushByte(queue, CommandPriority::STREAM, 31, 0);
+    pushByte(queue, CommandPriority::STATE, 21, 0);
+
+    const uint8_t expected[] = {10, 20, 21, 30, 31};
+    const CommandPriority expectedClass[] = {CommandPriority::CRITICAL, CommandPriority::STATE,
+                                             CommandPriority::STATE, CommandPriority::STREAM,
+                                             CommandPriority::STREAM};
+    for (uint8_t i = 0; i < sizeof(expected); i++) {
+        CommandPriority priority;
+        const QueuedCommand* cmd = queue.pop(1000, priority);
+        TEST_ASSERT_NOT_NULL(cmd);
+        TEST_ASSERT_EQUAL_UINT8(expected[i], cmd->data[0]);
+        TEST_ASSERT_TRUE(priority == expectedClass[i]);
+    }
+
+    CommandPriority priority;
+    TEST_ASSERT_NULL(queue.pop(1000, priority));
+    TEST_ASSERT_TRUE(queue.isEmpty());
+    TEST_ASSERT_EQUAL_UINT32(2, queue.getStats(CommandPriority::STREAM).dequeued);
+    TEST_ASSERT_EQUAL_UINT32(1000, queue.getStats(CommandPriority::CRITICAL).latencyMaxUs);
+}
+
+// Test commands older than their class limit are dropped on the way out
+void test_stale_dropping() {
+    static CommandQueue queue;
+    const unsigned long streamStale = PRIORITY_STALE_US[(uint8_t)CommandPriority::STREAM];
+    pushByte(queue, CommandPriority::CRITICAL, 1, 0);
+    pushByte(queue, CommandPriority::STATE, 2, 0);
+    pushByte(queue, CommandPriority::STREAM, 3, 0);
+    pushByte(queue, CommandPriority::STREAM, 4, streamStale);
+
+    // STREAM 3 is one microsecond past its limit, STATE is still fresh
+    unsigned long nowUs = streamStale + 1;
+    CommandPriority priority;
+    TEST_ASSERT_EQUAL_UINT8(1, queue.pop(nowUs, priority)->data[0]);
+    TEST_ASSERT_EQUAL_UINT8(2, queue.pop(nowUs, priority)->data[0]);
+    TEST_ASSERT_EQUAL_UINT8(4, queue.pop(nowUs, priority)->data[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, queue.getStats(CommandPriority::STREAM).droppedStale);
+
+    // CRITICAL is delivered however long it waited; STATE is not
+    pushByte(queue, CommandPriority::CRITICAL, 5, 0);
+    pushByte(queue, CommandPriority::STATE, 6, 0);
+    nowUs = PRIORITY_STALE_US[(uint8_t)CommandPriority::STATE] * 10;
+    const QueuedCommand* cmd = queue.pop(nowUs, priority);
+    TEST_ASSERT_NOT_NULL(cmd);
+    TEST_ASSERT_EQUAL_UINT8(5, cmd->data[0]);
+    TEST_ASSERT_NULL(queue.pop(nowUs, priority));
+    TEST_ASSERT_EQUAL_UINT32(1, queue.getStats(CommandPriority::STATE).droppedStale);
+    TEST_ASSERT_EQUAL_UINT32(0, queue.getStats(CommandPriority::CRITICAL).droppedStale);
+}
+
+// Test a full class keeps its newest commands and counts the evictions
+void test_overflow_counting() {
+    static CommandQueue queue;
+    for (uint8_t i = 0; i < COMMAND_QUEUE_DEPTH + 3; i++) {
+        TEST_ASSERT_TRUE(pushByte(queue, CommandPriority::STATE, i, 0));
+    }
+    TEST_ASSERT_EQUAL_UINT8(COMMAND_QUEUE_DEPTH, queue.depth(CommandPriority::STATE));
+    TEST_ASSERT_EQUAL_UINT32(3, queue.getStats(CommandPriority::STATE).droppedOverflow);
+    TEST_ASSERT_EQUAL_UINT32(COMMAND_QUEUE_DEPTH + 3, queue.getStats(CommandPriority::STATE).enqueued);
+
+    // Other classes keep their own room
+    TEST_ASSERT_TRUE(pushByte(queue, CommandPriority::STREAM, 99, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, queue.getStats(CommandPriority::STREAM).droppedOverflow);
+
+    CommandPriority priority;
+    for (uint8_t i = 3; i < COMMAND_QUEUE_DEPTH + 3; i++) {
+        TEST_ASSERT_EQUAL_UINT8(i, queue.pop(0, priority)->data[0]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(99, queue.pop(0, priority)->data[0]);
+    TEST_ASSERT_TRUE(queue.isEmpty());
+}
+
+// Test messages too large to reassemble are refused without touching the queue
+void test_rejects_bad_length() {
+    static CommandQueue queue;
+    static uint8_t big[FRAGMENT_MAX_MESSAGE_SIZE + 1];
+    TEST_ASSERT_FALSE(queue.push(CommandPriority::STATE, big, sizeof(big), 0));
+    TEST_ASSERT_FALSE(queue.push(CommandPriority::STATE, big, 0, 0));
+    TEST_ASSERT_TRUE(queue.push(CommandPriority::STATE, big, COMMAND_MAX_SIZE, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, queue.getStats(CommandPriority::STATE).enqueued);
+}
+
+// Push a message of len bytes, each byte its offset plus seed
+static void pushMessage(CommandQueue& queue, CommandPriority priority, size_t len, uint8_t seed,
+                        unsigned long nowUs) {
+    static uint8_t message[FRAGMENT_MAX_MESSAGE_SIZE];
+    for (size_t i = 0; i < len; i++) {
+        message[i] = (uint8_t)(i + seed);
+    }
+    TEST_ASSERT_TRUE(queue.push(priority, message, len, nowUs));
+}
+
+// Test a large message goes out as complete fragments and leaves the queue only whole
+void test_fragmented_messages() {
+    static CommandQueue queue;
+    const size_t len = FRAGMENT_MAX_MESSAGE_SIZE;  // Five fragments
+    const uint8_t fragments = (len + FRAGMENT_PAYLOAD_SIZE - 1) / FRAGMENT_PAYLOAD_SIZE;
+    pushMessage(queue, CommandPriority::STREAM, len, 0, 0);
+    TEST_ASSERT_EQUAL_UINT8(fragments, queue.depth(CommandPriority::STREAM));
+
+    // Fragment headers describe the message, and the payloads rebuild it
+    CommandPriority priority;
+    size_t offset = 0;
+    for (uint8_t i = 0; i < fragments; i++) {
+        const QueuedCommand* cmd = queue.pop(0, priority);
+        FragmentHeader header;
+        memcpy(&header, cmd->data, sizeof(header));
+        TEST_ASSERT_TRUE(header.header.type == MessageType::FRAGMENT);
+        TEST_ASSERT_EQUAL_UINT8(i, header.fragmentIndex);
+        TEST_ASSERT_EQUAL_UINT8(fragments, header.fragmentCount);
+        TEST_ASSERT_EQUAL_UINT16(len, header.totalLength);
+        for (size_t j = sizeof(header); j < cmd->len; j++) {
+            TEST_ASSERT_EQUAL_UINT8((uint8_t)offset++, cmd->data[j]);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(len, offset);
+
+    // Three messages of five fragments fill 15 of 16 slots; a fourth evicts the whole first one
+    for (uint8_t m = 0; m < 4; m++) {
+        pushMessage(queue, CommandPriority::STREAM, len, m, 0);
+    }
+    TEST_ASSERT_EQUAL_UINT32(fragments, queue.getStats(CommandPriority::STREAM).droppedOverflow);
+    TEST_ASSERT_EQUAL_UINT8(3 * fragments, queue.depth(CommandPriority::STREAM));
+    FragmentHeader first;
+    memcpy(&first, queue.pop(0, priority)->data, sizeof(first));
+    TEST_ASSERT_EQUAL_UINT8(0, first.fragmentIndex);
+
+    // Stale messages are dropped whole, including the rest of the one being sent
+    const unsigned long stale = PRIORITY_STALE_US[(uint8_t)CommandPriority::STREAM] + 1;
+    pushMessage(queue, CommandPriority::STREAM, 10, 0, stale);
+    TEST_ASSERT_EQUAL_UINT32(10, queue.pop(stale, priority)->len);
+    TEST_ASSERT_EQUAL_UINT32(3 * fragments - 1, queue.getStats(CommandPriority::STREAM).droppedStale);
+    TEST_ASSERT_TRUE(queue.isEmpty());
+}
+
+// Test an EMERGENCY flushes the flight states queued before it, but not streams
+void test_critical_flushes_state() {
+    static CommandQueue queue;
+    pushByte(queue, CommandPriority::STATE, 20, 0);
+    pushMessage(queue, CommandPriority::STATE, FRAGMENT_MAX_MESSAGE_SIZE, 0, 0);
+    pushByte(queue, CommandPriority::STREAM, 30, 0);
+    pushByte(queue, CommandPriority::CRITICAL, 10, 0);
+    TEST_ASSERT_EQUAL_UINT8(0, queue.depth(CommandPriority::STATE));
+    TEST_ASSERT_EQUAL_UINT32(6, queue.getStats(CommandPriority::STATE).droppedSuperseded);
+
+    // State changes after the EMERGENCY still go out, after it
+    pushByte(queue, CommandPriority::STATE, 21, 0);
+    const uint8_t expected[] = {10, 21, 30};
+    CommandPriority priority;
+    for (uint8_t i = 0; i < sizeof(expected); i++) {
+        TEST_ASSERT_EQUAL_UINT8(expected[i], queue.pop(0, priority)->data[0]);
+    }
+    TEST_ASSERT_TRUE(queue.isEmpty());
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Ordering and dropping
+    RUN_TEST(test_priority_order);
+    RUN_TEST(test_stale_dropping);
+    RUN_TEST(test_overflow_counting);
+    RUN_TEST(test_rejects_bad_length);
+
+    // Fragmented messages and supersession
+    RUN_TEST(test_fragmented_messages);
+    RUN_TEST(test_critical_flushes_state);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
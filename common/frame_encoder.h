@@ -0,0 +1,135 @@
+#pragma once
+
+#include <Arduino.h>
+#include "protocol.h"
+
+// Encoder configuration
+#define FRAME_KEYFRAME_INTERVAL 30  // Force a keyframe every 30 frames (0.5 s at 60 fps) for loss recovery
+#define FRAME_IDLE_KEYFRAME_US 250000  // Force a keyframe after a pause: the drone may have fallen back to its patterns
+
+// Encodes streamed frames as DELTA against the previously encoded frame, with
+// periodic RLE/RAW keyframes. A lost DELTA frame is recovered at the next keyframe.
+// The first frame after a pause of FRAME_IDLE_KEYFRAME_US is a keyframe too: by
+// then the drone may have timed the stream out and drawn its own pattern over the
+// frame the next DELTA would build on.
+class FrameEncoder {
+public:
+    FrameEncoder() : previousCount(0), hasPrevious(false), framesSinceKeyframe(0), lastEncodeUs(0),
+                     framesEncoded(0), keyframes(0), rawBytes(0), encodedBytes(0) {}
+
+    // Encode pixelCount RGB triplets into out, for a frame sent at nowUs.
+    // Returns the payload length.
+    size_t encode(const uint8_t* rgb, uint16_t pixelCount, uint8_t* out, size_t outCapacity,
+                  FrameEncoding& encoding, uint32_t nowUs) {
+        size_t rawLen = (size_t)pixelCount * 3;
+        size_t len = 0;
+
+        bool keyframeDue = !hasPrevious || pixelCount != previousCount ||
+                           framesSinceKeyframe + 1 >= FRAME_KEYFRAME_INTERVAL ||
+                           nowUs - lastEncodeUs >= FRAME_IDLE_KEYFRAME_US;
+        lastEncodeUs = nowUs;
+        if (!keyframeDue) {
+            len = encodeOps(rgb, previous, pixelCount, out, outCapacity);
+            encoding = FrameEncoding::DELTA;
+        }
+
+        // Keyframe when due, or whenever it is no larger than the delta
+        size_t rleLen = encodeOps(rgb, nullptr, pixelCount, scratch, sizeof(scratch));
+        size_t keyLen = (rleLen != 0 && rleLen < rawLen) ? rleLen : rawLen;
+        if (len == 0 || keyLen <= len) {
+            if (keyLen == rleLen) {
+                memcpy(out, scratch, rleLen);
+                encoding = FrameEncoding::RLE;
+            } else {
+                memcpy(out, rgb, rawLen);
+                encoding = FrameEncoding::RAW;
+            }
+            len = keyLen;
+            framesSinceKeyframe = 0;
+            keyframes++;
+        } else {
+            framesSinceKeyframe++;
+        }
+
+        memcpy(previous, rgb, rawLen);
+        previousCount = pixelCount;
+        hasPrevious = true;
+
+        framesEncoded++;
+        rawBytes += rawLen;
+        encodedBytes += len;
+        return len;
+    }
+
+    uint32_t getFramesEncoded() const { return framesEncoded; }
+    uint32_t getKeyframes() const { return keyframes; }
+
+    // Raw bytes per encoded byte, x100
+    uint32_t getCompressionRatioX100() const {
+        return encodedBytes ? (uint32_t)(rawBytes * 100 / encodedBytes) : 0;
+    }
+
+private:
+    uint8_t previous[FRAME_MAX_PIXELS * 3];
+    uint8_t scratch[FRAME_MAX_PAYLOAD];
+    uint16_t previousCount;
+    bool hasPrevious;
+    uint16_t framesSinceKeyframe;
+    uint32_t lastEncodeUs;
+
+    uint32_t framesEncoded;
+    uint32_t keyframes;
+    uint64_t rawBytes;
+    uint64_t encodedBytes;
+
+    static bool samePixel(const uint8_t* a, uint16_t i, const uint8_t* b, uint16_t j) {
+        return memcmp(a + i * 3, b + j * 3, 3) == 0;
+    }
+
+    // Emit LITERAL/RUN ops, plus SKIP ops against prev when given.
+    // Returns 0 if the result does not fit in capacity.
+    static size_t encodeOps(const uint8_t* cur, const uint8_t* prev, uint16_t count,
+                            uint8_t* out, size_t capacity) {
+        size_t pos = 0;
+        uint16_t i = 0;
+
+        while (i < count) {
+            uint16_t n = 1;
+
+            if (prev && samePixel(cur, i, prev, i)) {
+                while (i + n < count && n < FRAME_MAX_RUN && samePixel(cur, i + n, prev, i + n)) {
+                    n++;
+                }
+                if (pos + 1 > capacity) {
+                    return 0;
+                }
+                out[pos++] = FRAME_OP_SKIP | (n - 1);
+            } else if (i + 1 < count && samePixel(cur, i, cur, i + 1)) {
+                while (i + n < count && n < FRAME_MAX_RUN && samePixel(cur, i, cur, i + n)) {
+                    n++;
+                }
+                if (pos + 4 > capacity) {
+                    return 0;
+                }
+                out[pos++] = FRAME_OP_RUN | (n - 1);
+                memcpy(out + pos, cur + i * 3, 3);
+                pos += 3;
+            } else {
+                // Literal until a run or an unchanged pixel starts
+                while (i + n < count && n < FRAME_MAX_LITERAL &&
+                       !(i + n + 1 < count && samePixel(cur, i + n, cur, i + n + 1)) &&
+                       !(prev && samePixel(cur, i + n, prev, i + n))) {
+                    n++;
+                }
+                if (pos + 1 + n * 3 > capacity) {
+                    return 0;
+                }
+                out[pos++] = FRAME_OP_LITERAL | (n - 1);
+                memcpy(out + pos, cur + i * 3, n * 3);
+                pos += n * 3;
+            }
+            i += n;
+        }
+        return pos;
+    }
+};
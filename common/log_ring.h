@@ -0,0 +1,157 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <stdarg.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Asynchronous logging shared by base and drone firmware.
+//
+// LOG_* macros format a line into a lock-free ring buffer and return; a
+// low-priority task drains the ring to Serial. A full ring drops the line (and
+// counts it) rather than blocking, so logging never stalls the WiFi callback or
+// the render loop. Lines above LOG_LEVEL compile to nothing, arguments included.
+
+// Log levels
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO  // Override with -DLOG_LEVEL=... in build_flags
+#endif
+
+// Ring configuration
+#define LOG_RING_SLOTS 32  // Power of two
+#define LOG_LINE_MAX 160   // Longer lines are truncated
+#define LOG_DRAIN_INTERVAL_MS 10
+#define LOG_DRAIN_TASK_PRIORITY 1  // Same as loop(), below the WiFi task
+#define LOG_DRAIN_TASK_STACK 3072
+
+static_assert((LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) == 0, "LOG_RING_SLOTS must be a power of two");
+
+#define LOG_AT(level, tag, fmt, ...)                                          \
+    do {                                                                      \
+        if ((level) <= LOG_LEVEL) {                                           \
+            logRing().printf("[" tag "] " fmt "\n", ##__VA_ARGS__);           \
+        }                                                                     \
+    } while (0)
+
+#define LOG_ERROR(tag, fmt, ...) LOG_AT(LOG_LEVEL_ERROR, tag, fmt, ##__VA_ARGS__)
+#define LOG_WARN(tag, fmt, ...) LOG_AT(LOG_LEVEL_WARN, tag, fmt, ##__VA_ARGS__)
+#define LOG_INFO(tag, fmt, ...) LOG_AT(LOG_LEVEL_INFO, tag, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(tag, fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, tag, fmt, ##__VA_ARGS__)
+
+// Bounded multi-producer, single-consumer ring of formatted lines. Each slot has
+// a sequence number: producers claim a slot by advancing head with a CAS, format
+// in place and publish by bumping the sequence; the consumer frees the slot the
+// same way. No locks, and no allocation after construction.
+class LogRing {
+public:
+    LogRing() : head(0), tail(0), linesWritten(0), linesDropped(0) {
+        for (uint32_t i = 0; i < LOG_RING_SLOTS; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Start the task that drains the ring to Serial
+    void begin() {
+        xTaskCreatePinnedToCore(drainTask, "log", LOG_DRAIN_TASK_STACK, this, LOG_DRAIN_TASK_PRIORITY,
+                                nullptr, tskNO_AFFINITY);
+    }
+
+    // Format a line into the ring. Returns false (and counts a drop) if it is full.
+    bool printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        uint32_t pos = head.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[pos & (LOG_RING_SLOTS - 1)];
+            int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                linesDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+
+        va_list args;
+        va_start(args, fmt);
+        int len = vsnprintf(slot->text, LOG_LINE_MAX, fmt, args);
+        va_end(args);
+        if (len >= LOG_LINE_MAX) {
+            // Keep the line break of a truncated line
+            slot->text[LOG_LINE_MAX - 2] = '\n';
+            len = LOG_LINE_MAX - 1;
+        }
+        slot->len = len < 0 ? 0 : len;
+
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        linesWritten.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Take the oldest line, if any (single consumer). The pointer is valid until release().
+    const char* peek(size_t& len) {
+        Slot& slot = slots[tail & (LOG_RING_SLOTS - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != tail + 1) {
+            return nullptr;
+        }
+        len = slot.len;
+        return slot.text;
+    }
+
+    void release() {
+        slots[tail & (LOG_RING_SLOTS - 1)].sequence.store(tail + LOG_RING_SLOTS, std::memory_order_release);
+        tail++;
+    }
+
+    // Write every pending line to Serial (drain task, or synchronously before a reset)
+    void flush() {
+        size_t len;
+        const char* text;
+        while ((text = peek(len)) != nullptr) {
+            Serial.write((const uint8_t*)text, len);
+            release();
+        }
+    }
+
+    uint32_t getLinesWritten() const { return linesWritten.load(std::memory_order_relaxed); }
+    uint32_t getLinesDropped() const { return linesDropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        uint16_t len;
+        char text[LOG_LINE_MAX];
+    };
+
+    Slot slots[LOG_RING_SLOTS];
+    std::atomic<uint32_t> head;  // Next slot to claim (producers)
+    uint32_t tail;               // Next slot to drain (consumer only)
+
+    // Statistics
+    std::atomic<uint32_t> linesWritten;
+    std::atomic<uint32_t> linesDropped;
+
+    static void drainTask(void* arg) {
+        LogRing* ring = static_cast<LogRing*>(arg);
+        for (;;) {
+            ring->flush();
+            vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+        }
+    }
+};
+
+// Process-wide log ring
+inline LogRing& logRing() {
+    static LogRing ring;
+    return ring;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+
+// Binary ESP-NOW message definitions shared by base and drone firmware.
+//
+// JSON led_command messages start with '{', possibly after JSON whitespace.
+// Binary messages start with PROTOCOL_MAGIC followed by a MessageType, so the
+// two never collide.
+
+#define PROTOCOL_MAGIC 0xA5
+#define ESPNOW_MAX_PAYLOAD 250          // Single ESP-NOW frame
+#define FRAGMENT_MAX_MESSAGE_SIZE 1024  // Largest message after reassembly
+
+enum class MessageType : uint8_t {
+    PARAM_SAMPLE = 0x01,    // Continuous BRAINWAVE parameter sample
+    FRAME = 0x02,           // Raw RGB pixel frame rendered on the ground
+    FRAGMENT = 0x03,        // Part of a message larger than one ESP-NOW frame
+};
+
+struct __attribute__((packed)) MessageHeader {
+    uint8_t magic;          // PROTOCOL_MAGIC
+    MessageType type;
+};
+
+// BRAINWAVE parameters streamed from the BCI at 50-200 Hz
+struct __attribute__((packed)) ParamSampleMessage {
+    MessageHeader header;
+    uint16_t sequence;      // Incremented per sample, used for loss detection
+    uint32_t sampleTimeUs;  // Base micros() when the sample was taken
+    uint8_t hueShift;       // Gradient offset (0-255, wraps)
+    uint8_t intensity;      // Brightness scale (0-255)
+    uint16_t speed;         // Milliseconds per gradient step
+};
+
+// Pixel frame encodings
+enum class FrameEncoding : uint8_t {
+    RAW = 0,    // pixelCount RGB triplets (keyframe)
+    RLE = 1,    // Run-length encoded full frame (keyframe)
+    DELTA = 2,  // Runs/literals/skips against frame (frameNumber - 1)
+};
+
+// RLE and DELTA opcodes, each followed by its pixel data
+#define FRAME_OP_LITERAL 0x00   // 0x00-0x7F: (op + 1) RGB pixels follow
+#define FRAME_OP_RUN 0x80       // 0x80-0xBF: ((op & 0x3F) + 1) copies of the following RGB pixel
+#define FRAME_OP_SKIP 0xC0      // 0xC0-0xFF: ((op & 0x3F) + 1) pixels unchanged (DELTA only)
+#define FRAME_MAX_LITERAL 128
+#define FRAME_MAX_RUN 64
+
+// Pixel frame, followed by the encoded pixel data
+struct __attribute__((packed)) FrameMessageHeader {
+    MessageHeader header;
+    uint16_t frameNumber;   // Incremented per frame
+    uint32_t sampleTimeUs;  // Base micros() when the frame was produced
+    uint16_t pixelCount;    // Decoded frame length
+    FrameEncoding encoding;
+};
+
+#define FRAME_MAX_PAYLOAD (FRAGMENT_MAX_MESSAGE_SIZE - sizeof(FrameMessageHeader))
+#define FRAME_MAX_PIXELS (FRAME_MAX_PAYLOAD / 3)  // 337 LEDs as a RAW frame
+
+// Fragment of a larger message, followed by up to FRAGMENT_PAYLOAD_SIZE bytes.
+// Fragment i carries bytes [i * FRAGMENT_PAYLOAD_SIZE, ...) of the original message,
+// which is any JSON or binary message once reassembled.
+struct __attribute__((packed)) FragmentHeader {
+    MessageHeader header;
+    uint16_t messageId;     // Shared by all fragments of one message
+    uint8_t fragmentIndex;
+    uint8_t fragmentCount;
+    uint16_t totalLength;   // Reassembled message length
+};
+
+#define FRAGMENT_PAYLOAD_SIZE (ESPNOW_MAX_PAYLOAD - sizeof(FragmentHeader))  // 242 bytes
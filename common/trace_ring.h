@@ -0,0 +1,128 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// Binary event tracing shared by base and drone firmware.
+//
+// TRACE_* macros record an 8-byte event (micros() timestamp, event id, phase,
+// argument) into a fixed ring that always holds the most recent events. A
+// record is one atomic increment and a few stores, cheap enough to leave
+// enabled in production; build with -DTRACE_ENABLED=0 to compile it out.
+// dump() prints the ring as hex for tools/trace_to_chrome.py, which converts it
+// to Chrome trace / Perfetto JSON.
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+// Ring configuration
+#define TRACE_RING_EVENTS 512     // Power of two (4 KB)
+#define TRACE_DUMP_EVENTS_PER_LINE 8
+
+static_assert((TRACE_RING_EVENTS & (TRACE_RING_EVENTS - 1)) == 0, "TRACE_RING_EVENTS must be a power of two");
+
+// Traced points. Keep in sync with EVENT_NAMES in tools/trace_to_chrome.py.
+enum class TraceEventId : uint8_t {
+    // Drone
+    RX_CALLBACK = 1,    // ESP-NOW packet received (arg: length)
+    PARSE = 2,          // led_command parse (arg: pattern on END)
+    APPLY = 3,          // Command applied to the LED controller
+    RENDER = 4,         // Frame render and composite
+    SHOW = 5,           // FastLED.show()
+    // Base
+    SERIAL_IN = 16,     // Serial command line received (arg: length)
+    SEND = 17,          // esp_now_send() (arg: length)
+    SEND_CALLBACK = 18  // onDataSent (arg: 1 = success)
+};
+
+enum class TracePhase : uint8_t {
+    BEGIN = 'B',
+    END = 'E',
+    INSTANT = 'i'
+};
+
+struct __attribute__((packed)) TraceEvent {
+    uint32_t timestampUs;
+    TraceEventId id;
+    TracePhase phase;
+    uint16_t arg;
+};
+
+static_assert(sizeof(TraceEvent) == 8, "TraceEvent must stay 8 bytes");
+
+#if TRACE_ENABLED
+#define TRACE_EVENT(id, phase, arg) traceRing().record(TraceEventId::id, TracePhase::phase, (arg))
+#else
+#define TRACE_EVENT(id, phase, arg) do {} while (0)
+#endif
+
+#define TRACE_BEGIN(id) TRACE_EVENT(id, BEGIN, 0)
+#define TRACE_END(id, arg) TRACE_EVENT(id, END, arg)
+#define TRACE_INSTANT(id, arg) TRACE_EVENT(id, INSTANT, arg)
+
+// Overwriting ring of the most recent trace events. Any task or callback may
+// record concurrently: each claims its own slot with one atomic increment. A
+// dump taken while events are being recorded may show the slot being written
+// as garbage; the host tool drops events with unknown ids or phases.
+class TraceRing {
+public:
+    TraceRing() : head(0) {
+        memset(events, 0, sizeof(events));
+    }
+
+    void record(TraceEventId id, TracePhase phase, uint16_t arg) {
+        uint32_t index = head.fetch_add(1, std::memory_order_relaxed) & (TRACE_RING_EVENTS - 1);
+        TraceEvent& event = events[index];
+        event.timestampUs = micros();
+        event.id = id;
+        event.phase = phase;
+        event.arg = arg;
+    }
+
+    // Events recorded since boot (including overwritten ones)
+    uint32_t getEventsRecorded() const {
+        return head.load(std::memory_order_relaxed);
+    }
+
+    // Copy out up to maxEvents of the most recent events, oldest first
+    uint32_t snapshot(TraceEvent* out, uint32_t maxEvents) const {
+        uint32_t end = head.load(std::memory_order_acquire);
+        uint32_t count = end < TRACE_RING_EVENTS ? end : TRACE_RING_EVENTS;
+        if (count > maxEvents) {
+            count = maxEvents;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            out[i] = events[(end - count + i) & (TRACE_RING_EVENTS - 1)];
+        }
+        return count;
+    }
+
+    // Print the ring as hex lines between TRACE BEGIN/END markers
+    void dump(Print& out, const char* device) const {
+        static TraceEvent copy[TRACE_RING_EVENTS];
+        uint32_t count = snapshot(copy, TRACE_RING_EVENTS);
+
+        out.printf("[TRACE] BEGIN %s %u %lu\n", device, count, (unsigned long)micros());
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(copy);
+        for (uint32_t i = 0; i < count; i += TRACE_DUMP_EVENTS_PER_LINE) {
+            uint32_t lineEvents = count - i < TRACE_DUMP_EVENTS_PER_LINE ? count - i : TRACE_DUMP_EVENTS_PER_LINE;
+            char line[TRACE_DUMP_EVENTS_PER_LINE * sizeof(TraceEvent) * 2 + 1];
+            for (uint32_t b = 0; b < lineEvents * sizeof(TraceEvent); b++) {
+                snprintf(line + 2 * b, 3, "%02x", bytes[i * sizeof(TraceEvent) + b]);
+            }
+            out.printf("[TRACE] %s\n", line);
+        }
+        out.printf("[TRACE] END %s\n", device);
+    }
+
+private:
+    TraceEvent events[TRACE_RING_EVENTS];
+    std::atomic<uint32_t> head;  // Next slot to write
+};
+
+// Process-wide trace ring
+inline TraceRing& traceRing() {
+    static TraceRing ring;
+    return ring;
+}
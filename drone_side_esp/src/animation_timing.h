@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Microsecond clock source (micros() on hardware, injectable for tests)
+typedef unsigned long (*MicrosClock)();
+
+// Frame-rate independent animation phase.
+// Tracks the microseconds elapsed within the current animation cycle and derives
+// a 32-bit phase from it (2^32 = one full cycle). Because the remainder is kept
+// exactly, the animation advances at exactly one cycle per period however often
+// (or irregularly) it is sampled, and never accumulates drift.
+class PhaseAccumulator {
+public:
+    PhaseAccumulator() : periodUs(0), cycleUs(0), cycles(0), lastUs(0) {}
+
+    // Restart at phase 0
+    void reset(uint32_t nowUs) {
+        cycleUs = 0;
+        cycles = 0;
+        lastUs = nowUs;
+    }
+
+    // Continue from the current phase at nowUs, skipping the time since the
+    // last advance (e.g. while the pattern was hidden)
+    void resume(uint32_t nowUs) {
+        lastUs = nowUs;
+    }
+
+    // Change the cycle length while keeping the current phase, so speed changes
+    // do not make the animation jump. A period of 0 freezes the phase.
+    void setPeriod(uint32_t newPeriodUs) {
+        if (newPeriodUs == periodUs) {
+            return;
+        }
+        if (periodUs != 0 && newPeriodUs != 0) {
+            cycleUs = (uint32_t)((uint64_t)cycleUs * newPeriodUs / periodUs);
+        } else {
+            cycleUs = 0;
+        }
+        periodUs = newPeriodUs;
+    }
+
+    // Advance to nowUs and return the current phase
+    uint32_t advance(uint32_t nowUs) {
+        uint32_t elapsed = nowUs - lastUs;  // Wraps correctly across micros() overflow
+        lastUs = nowUs;
+
+        if (periodUs == 0) {
+            return phase();
+        }
+
+        uint64_t total = (uint64_t)cycleUs + elapsed;
+        if (total >= periodUs) {
+            cycles += total / periodUs;
+            total %= periodUs;
+        }
+        cycleUs = (uint32_t)total;
+        return phase();
+    }
+
+    // Fraction of the current cycle, 0 .. 2^32-1
+    uint32_t phase() const {
+        return periodUs ? (uint32_t)(((uint64_t)cycleUs << 32) / periodUs) : 0;
+    }
+
+    // Current phase scaled to [0, steps)
+    uint32_t step(uint32_t steps) const {
+        return (uint32_t)(((uint64_t)phase() * steps) >> 32);
+    }
+
+    // Current phase scaled to [0, steps) with 8 fractional bits, for sub-step positioning
+    uint32_t subStep(uint32_t steps) const {
+        return (uint32_t)(((uint64_t)phase() * steps) >> 24);
+    }
+
+    uint32_t getPeriodUs() const { return periodUs; }
+    uint32_t getCycles() const { return cycles; }
+
+private:
+    uint32_t periodUs;
+    uint32_t cycleUs;  // Microseconds into the current cycle
+    uint32_t cycles;   // Completed cycles since reset
+    uint32_t lastUs;
+};
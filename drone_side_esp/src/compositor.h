@@ -0,0 +1,196 @@
+#pragma once
+
+#include <FastLED.h>
+#include "patterns.h"
+#include "animation_timing.h"
+#include "pixel_kernels.h"
+#include "output_stage.h"
+
+// Layer stack, bottom to top
+#define LAYER_COUNT 3
+#define COMPOSITE_CHUNK_LEDS 32  // Scratch size for layers composited with the pixel kernels
+enum class LayerId : uint8_t {
+    BASE,     // Flight state pattern (always on)
+    OVERLAY,  // Status shown on top of the flight state, e.g. LOW_BATTERY
+    ALERT     // Highest layer
+};
+
+// How a layer combines with the layers below it
+enum class BlendMode : uint8_t {
+    NORMAL,   // Lit pixels cover the layers below, black pixels are transparent
+    ADD,      // Saturating add
+    LIGHTEN   // Per-channel maximum
+};
+
+// Where and how an LED command is displayed
+struct LayerSettings {
+    LayerId layer;
+    BlendMode blend;
+    uint8_t opacity;  // 0 turns an overlay layer off
+    uint8_t segment;  // Strip zone for the pattern (0 = the whole strip, see segments.h)
+};
+
+// Pattern state of one overlay layer (the base layer is the controller's current pattern)
+struct Layer {
+    PatternConfig config;
+    PhaseAccumulator animation;
+    BlendMode blend;
+    uint8_t opacity;
+};
+
+// One rendered layer as input to compositeLayers()
+struct LayerSource {
+    const CRGB* pixels;
+    uint8_t brightness;
+    BlendMode blend;
+    uint8_t opacity;
+};
+
+// A range of the base layer drawn by a segment, at the segment's pattern brightness
+struct BrightnessSpan {
+    uint16_t start;
+    uint16_t length;
+    uint8_t brightness;
+};
+
+// Composite rendered layers into out, one layer at a time.
+// Each layer's pattern brightness is applied here, so layers with different
+// brightness can be shown together; spans (sorted, not overlapping) give parts
+// of the base their own brightness. out may alias base.
+inline void compositeLayers(CRGB* out, const CRGB* base, uint8_t baseBrightness,
+                            const LayerSource* layers, uint8_t layerCount, uint16_t numLeds,
+                            const BrightnessSpan* spans = nullptr, uint8_t spanCount = 0) {
+    uint16_t pos = 0;
+    for (uint8_t s = 0; s < spanCount; s++) {
+        const BrightnessSpan& span = spans[s];
+        pixelScale(out + pos, base + pos, baseBrightness, span.start - pos);
+        pixelScale(out + span.start, base + span.start, span.brightness, span.length);
+        pos = span.start + span.length;
+    }
+    pixelScale(out + pos, base + pos, baseBrightness, numLeds - pos);
+
+    for (uint8_t l = 0; l < layerCount; l++) {
+        const LayerSource& layer = layers[l];
+
+        // Black adds nothing, so ADD layers run through the kernels in chunks
+        if (layer.blend == BlendMode::ADD) {
+            CRGB scaled[COMPOSITE_CHUNK_LEDS];
+            for (uint16_t start = 0; start < numLeds; start += COMPOSITE_CHUNK_LEDS) {
+                uint16_t count = numLeds - start < COMPOSITE_CHUNK_LEDS ? numLeds - start : COMPOSITE_CHUNK_LEDS;
+                pixelScale(scaled, layer.pixels + start, layer.brightness, count);
+                pixelScale(scaled, scaled, layer.opacity, count);
+                pixelAdd(out + start, out + start, scaled, count);
+            }
+            continue;
+        }
+
+        for (uint16_t i = 0; i < numLeds; i++) {
+            CRGB src = layer.pixels[i];
+            if (!src) {
+                continue;  // Black is transparent in every mode
+            }
+            src.nscale8(layer.brightness);
+
+            if (layer.blend == BlendMode::NORMAL) {
+                out[i] = blend(out[i], src, layer.opacity);
+            } else {  // LIGHTEN
+                src.nscale8(layer.opacity);
+                out[i].r = max(out[i].r, src.r);
+                out[i].g = max(out[i].g, src.g);
+                out[i].b = max(out[i].b, src.b);
+            }
+        }
+    }
+}
+
+// compositeLayers16() over LEDs [from, to) at one base scale
+inline void compositeRange16(CRGB16* out, CRGB* out8, const CRGB* base, uint32_t baseScale,
+                             const LayerSource* layers, uint8_t layerCount, uint16_t from, uint16_t to) {
+    for (uint16_t i = from; i < to; i++) {
+        uint32_t pixel[3];
+        for (uint8_t c = 0; c < 3; c++) {
+            pixel[c] = (base[i].raw[c] * baseScale) >> 8;
+        }
+
+        for (uint8_t l = 0; l < layerCount; l++) {
+            const LayerSource& layer = layers[l];
+            const CRGB& src = layer.pixels[i];
+            if (!src) {
+                continue;  // Black is transparent in every mode
+            }
+            for (uint8_t c = 0; c < 3; c++) {
+                uint32_t value = (uint32_t)src.raw[c] * (layer.brightness + 1);
+                switch (layer.blend) {
+                    case BlendMode::NORMAL:
+                        pixel[c] = (pixel[c] * (256 - layer.opacity) + value * (1 + layer.opacity)) >> 8;
+                        break;
+                    case BlendMode::ADD:
+                        pixel[c] += (value * (layer.opacity + 1)) >> 8;
+                        break;
+                    case BlendMode::LIGHTEN:
+                        value = (value * (layer.opacity + 1)) >> 8;
+                        pixel[c] = max(pixel[c], value);
+                        break;
+                }
+                if (pixel[c] > COLOR16_MAX) {
+                    pixel[c] = COLOR16_MAX;
+                }
+            }
+        }
+
+        out[i] = {(uint16_t)pixel[0], (uint16_t)pixel[1], (uint16_t)pixel[2]};
+        out8[i] = CRGB(pixel[0] >> 8, pixel[1] >> 8, pixel[2] >> 8);
+    }
+}
+
+// 16-bit compositeLayers() for the dithered output stage: same blending, with
+// 8 fractional bits kept per channel. baseScale is (base brightness + 1) in 8.8
+// fixed point, so brightness fades keep their fractional steps. The 8-bit view
+// of the result goes to out8 (may alias base).
+inline void compositeLayers16(CRGB16* out, CRGB* out8, const CRGB* base, uint32_t baseScale,
+                              const LayerSource* layers, uint8_t layerCount, uint16_t numLeds,
+                              const BrightnessSpan* spans = nullptr, uint8_t spanCount = 0) {
+    uint16_t pos = 0;
+    for (uint8_t s = 0; s < spanCount; s++) {
+        const BrightnessSpan& span = spans[s];
+        uint16_t end = span.start + span.length;
+        compositeRange16(out, out8, base, baseScale, layers, layerCount, pos, span.start);
+        compositeRange16(out, out8, base, ((uint32_t)span.brightness + 1) << 8, layers, layerCount, span.start, end);
+        pos = end;
+    }
+    compositeRange16(out, out8, base, baseScale, layers, layerCount, pos, numLeds);
+}
+
+// Convert string to LayerId (unknown names select the base layer)
+inline LayerId stringToLayer(const char* str) {
+    if (str && strcmp(str, "OVERLAY") == 0) return LayerId::OVERLAY;
+    if (str && strcmp(str, "ALERT") == 0) return LayerId::ALERT;
+    return LayerId::BASE;
+}
+
+// Convert string to BlendMode (unknown names select NORMAL)
+inline BlendMode stringToBlendMode(const char* str) {
+    if (str && strcmp(str, "ADD") == 0) return BlendMode::ADD;
+    if (str && strcmp(str, "LIGHTEN") == 0) return BlendMode::LIGHTEN;
+    return BlendMode::NORMAL;
+}
+
+// Convert LayerId to string
+inline const char* layerToString(LayerId layer) {
+    switch (layer) {
+        case LayerId::BASE: return "BASE";
+        case LayerId::OVERLAY: return "OVERLAY";
+        case LayerId::ALERT: return "ALERT";
+        default: return "UNKNOWN";
+    }
+}
+
+// Convert BlendMode to string
+inline const char* blendModeToString(BlendMode mode) {
+    switch (mode) {
+        case BlendMode::NORMAL: return "NORMAL";
+        case BlendMode::ADD: return "ADD";
+        case BlendMode::LIGHTEN: return "LIGHTEN";
+        default: return "UNKNOWN";
+    }
+}
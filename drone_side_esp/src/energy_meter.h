@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Supply voltage of the strip, for converting charge to energy
+#define POWER_SUPPLY_MV 5000
+
+// Estimated strip charge and energy, integrated frame by frame.
+// Each frame's current counts for the time until the next frame.
+class EnergyMeter {
+public:
+    EnergyMeter() : chargeMaUs(0), timeUs(0) {}
+
+    void record(uint32_t currentMa, uint32_t durationUs) {
+        chargeMaUs += (uint64_t)currentMa * durationUs;
+        timeUs += durationUs;
+    }
+
+    void reset() {
+        chargeMaUs = 0;
+        timeUs = 0;
+    }
+
+    // Mean current over the recorded time
+    uint32_t getAverageMa() const {
+        return timeUs ? (uint32_t)(chargeMaUs / timeUs) : 0;
+    }
+
+    // Energy in microwatt-hours at POWER_SUPPLY_MV
+    uint64_t getEnergyUwh() const {
+        return chargeMaUs * POWER_SUPPLY_MV / 3600000000ULL;
+    }
+
+    uint32_t getTimeMs() const {
+        return (uint32_t)(timeUs / 1000);
+    }
+
+private:
+    uint64_t chargeMaUs;
+    uint64_t timeUs;
+};
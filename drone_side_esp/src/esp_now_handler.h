@@ -2,23 +2,36 @@
 
 #include <esp_now.h>
 #include <WiFi.h>
-#include <ArduinoJson.h>
-#include "patterns.h"
+#include "led_command_parser.h"
+#include "param_stream.h"
+#include "protocol.h"
+#include "fragmentation.h"
+#include "receive_filter.h"
+#include "log_ring.h"
+#include "trace_ring.h"
+#include "histogram.h"
 
 // ESP-NOW Configuration
 #define ESPNOW_CHANNEL 1
 #define ESPNOW_WIFI_MODE WIFI_MODE_STA
 #define MAX_MESSAGE_SIZE 250
 
-// Callback function type
-typedef void (*LedCommandCallback)(const PatternConfig& config);
+// Callback function types
+typedef void (*LedCommandCallback)(const PatternConfig& config, const LayerSettings& layer,
+                                   const PrioritySettings& priority);
+typedef void (*ParamSampleCallback)(const StreamParams& params, uint16_t sequence, uint32_t sampleTimeUs);
+typedef void (*FrameCallback)(const FrameMessageHeader& frame, const uint8_t* payload, size_t payloadLen);
 
 class EspNowHandler {
 public:
-    EspNowHandler() : commandCallback(nullptr), lastMessageTime(0), messageCount(0) {}
+    EspNowHandler() : commandCallback(nullptr), paramCallback(nullptr), frameCallback(nullptr),
+                      lastReceiveUs(0) {}
 
-    void begin(LedCommandCallback callback) {
+    void begin(LedCommandCallback callback, ParamSampleCallback paramSampleCallback = nullptr,
+               FrameCallback frameStreamCallback = nullptr) {
         commandCallback = callback;
+        paramCallback = paramSampleCallback;
+        frameCallback = frameStreamCallback;
 
         // Initialize WiFi in station mode
         WiFi.mode(ESPNOW_WIFI_MODE);
@@ -48,19 +61,46 @@ public:
     }
 
     unsigned long getLastMessageTime() const {
-        return lastMessageTime;
+        return lastMessageTime.get();
+    }
+
+    const Reassembler& getReassembler() const {
+        return reassembler;
+    }
+
+    // Only accept packets from this sender (any sender while the list is empty)
+    bool allowSender(const uint8_t* mac) {
+        return filter.allowSender(mac);
+    }
+
+    const ReceiveFilter& getFilter() const {
+        return filter;
+    }
+
+    // Time from receiving an LED command to the callback having handed it on
+    // (queued for the next frame; see LedController::getCommandLatency())
+    const LogHistogram& getApplyLatency() const {
+        return applyLatency;
     }
 
     bool isConnected() const {
         // Consider connected if we received a message in the last 5 seconds
-        return (millis() - lastMessageTime) < 5000;
+        return (millis() - lastMessageTime.get()) < 5000;
     }
 
 private:
     static EspNowHandler* instance;
     LedCommandCallback commandCallback;
-    unsigned long lastMessageTime;
-    uint32_t messageCount;
+    ParamSampleCallback paramCallback;
+    FrameCallback frameCallback;
+    // Written by the WiFi task, read from loop()
+    MetricGauge lastMessageTime;
+    MetricCounter messageCount;
+    uint32_t lastReceiveUs;
+    LogHistogram applyLatency;
+    Reassembler reassembler;
+    ReceiveFilter filter;
+    LedCommandScanner commandScanner;
 
     // ESP-NOW receive callback (must be static)
     static void onDataRecv(const uint8_t* mac, const uint8_t* data, int len) {
@@ -69,80 +109,96 @@ private:
         }
     }
 
-    void handleReceivedData(const uint8_t* mac, const uint8_t* data, int len) {
-        lastMessageTime = millis();
-        messageCount++;
-
-        // Log received message
-        Serial.printf("[ESP-NOW] Received %d bytes from %02X:%02X:%02X:%02X:%02X:%02X\n",
-                      len, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-
-        // Parse JSON
-        StaticJsonDocument<MAX_MESSAGE_SIZE> doc;
-        DeserializationError error = deserializeJson(doc, data, len);
-
-        if (error) {
-            Serial.printf("[ESP-NOW] JSON parse error: %s\n", error.c_str());
-            return;
-        }
-
-        // Validate message type
-        const char* type = doc["type"];
-        if (!type || strcmp(type, "led_command") != 0) {
-            Serial.println("[ESP-NOW] Invalid message type");
-            return;
-        }
-
-        // Parse command data
-        JsonObject dataObj = doc["data"];
-        if (!dataObj) {
-            Serial.println("[ESP-NOW] Missing data object");
-            return;
+    void handleBinaryMessage(const uint8_t* mac, const uint8_t* data, int len) {
+        MessageType type = static_cast<MessageType>(data[1]);
+
+        switch (type) {
+            case MessageType::PARAM_SAMPLE: {
+                if (len != sizeof(ParamSampleMessage)) {
+                    return;
+                }
+                ParamSampleMessage msg;
+                memcpy(&msg, data, sizeof(msg));
+                StreamParams params = {msg.hueShift, msg.intensity, msg.speed};
+                if (paramCallback) {
+                    paramCallback(params, msg.sequence, msg.sampleTimeUs);
+                }
+                break;
+            }
+            case MessageType::FRAME: {
+                if (len < (int)sizeof(FrameMessageHeader)) {
+                    return;
+                }
+                FrameMessageHeader msg;
+                memcpy(&msg, data, sizeof(msg));
+                if (frameCallback) {
+                    frameCallback(msg, data + sizeof(FrameMessageHeader), len - sizeof(FrameMessageHeader));
+                }
+                break;
+            }
+            case MessageType::FRAGMENT: {
+                size_t messageLen = 0;
+                const uint8_t* message = reassembler.accept(data, len, micros(), messageLen);
+                // Reassembled messages are dispatched as if received whole (never nested)
+                if (message && !(message[0] == PROTOCOL_MAGIC && messageLen >= sizeof(MessageHeader) &&
+                                 static_cast<MessageType>(message[1]) == MessageType::FRAGMENT)) {
+                    handleMessage(mac, message, messageLen);
+                }
+                break;
+            }
+            default:
+                break;
         }
+    }
 
-        // Extract pattern
-        const char* patternStr = dataObj["pattern"];
-        if (!patternStr) {
-            Serial.println("[ESP-NOW] Missing pattern field");
+    void handleReceivedData(const uint8_t* mac, const uint8_t* data, int len) {
+        // Shed foreign and malformed traffic before logging or parsing
+        if (!filter.accept(mac, data, len)) {
             return;
         }
+        TRACE_INSTANT(RX_CALLBACK, len);
+        lastReceiveUs = micros();
 
-        LedPattern pattern = stringToPattern(patternStr);
-
-        // Get default config and override with received values
-        PatternConfig config = PatternDefaults::getDefault(pattern);
+        lastMessageTime.set(millis());
+        messageCount++;
 
-        // Override color if provided
-        if (dataObj.containsKey("color")) {
-            JsonArray colorArray = dataObj["color"];
-            if (colorArray.size() >= 3) {
-                config.color = CRGB(
-                    colorArray[0].as<uint8_t>(),
-                    colorArray[1].as<uint8_t>(),
-                    colorArray[2].as<uint8_t>()
-                );
-            }
-        }
+        handleMessage(mac, data, len);
+    }
 
-        // Override brightness if provided
-        if (dataObj.containsKey("brightness")) {
-            config.brightness = dataObj["brightness"].as<uint8_t>();
+    void handleMessage(const uint8_t* mac, const uint8_t* data, int len) {
+        // Binary messages are high-rate streams: dispatch without logging
+        if (len >= (int)sizeof(MessageHeader) && data[0] == PROTOCOL_MAGIC) {
+            handleBinaryMessage(mac, data, len);
+            return;
         }
 
-        // Override speed if provided
-        if (dataObj.containsKey("speed")) {
-            config.speed = dataObj["speed"].as<uint16_t>();
+        // Log received message
+        LOG_DEBUG("ESP-NOW", "Received %d bytes from %02X:%02X:%02X:%02X:%02X:%02X",
+                  len, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+        // Parse JSON straight into a command, without a JsonDocument
+        LedCommand command;
+        TRACE_BEGIN(PARSE);
+        bool parsed = commandScanner.parse(reinterpret_cast<const char*>(data), len, command);
+        TRACE_END(PARSE, parsed ? (uint16_t)command.config.pattern : 0xFFFF);
+        if (!parsed) {
+            LOG_WARN("ESP-NOW", "%s", ledCommandErrorToString(commandScanner.getError()));
+            return;
         }
+        const PatternConfig& config = command.config;
+        const LayerSettings& layer = command.layer;
+        const PrioritySettings& priority = command.priority;
 
         // Log parsed command
-        uint64_t timestamp = doc["timestamp"].as<uint64_t>();
-        Serial.printf("[ESP-NOW] Command: %s, RGB: [%d,%d,%d], Brightness: %d, Speed: %d, Timestamp: %llu\n",
-                      patternStr, config.color.r, config.color.g, config.color.b,
-                      config.brightness, config.speed, timestamp);
+        LOG_INFO("ESP-NOW", "Command: %s, RGB: [%d,%d,%d], Brightness: %d, Speed: %d, Layer: %s, Segment: %d, Priority: %s, Timestamp: %llu",
+                 patternToString(config.pattern), config.color.r, config.color.g, config.color.b,
+                 config.brightness, config.speed, layerToString(layer.layer), layer.segment,
+                 priorityToString(priority.priority), command.timestamp);
 
         // Execute callback
         if (commandCallback) {
-            commandCallback(config);
+            commandCallback(config, layer, priority);
+            applyLatency.record(micros() - lastReceiveUs);
         }
     }
 };
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <FastLED.h>
+#include "led_layout.h"
+
+// Draw a comet whose head sits at a fractional LED position.
+// head8 is the head position in 1/256 LED units, measured from the start of the
+// sweep (LED 0, or the last LED when reverse is set). The tail fades linearly over
+// tailLength LEDs and the head's leading edge is split between the two adjacent
+// LEDs, so motion is smooth at any frame rate. Only the comet's LEDs are written;
+// the caller clears the strip.
+inline void renderComet(CRGB* leds, uint16_t numLeds, const CRGB& color,
+                        uint32_t head8, uint8_t tailLength, bool reverse) {
+    const int32_t tail256 = (int32_t)tailLength * 256;
+    int32_t headLed = head8 >> 8;
+    int32_t frac = head8 & 0xFF;
+
+    // k = 0 is the partially lit LED ahead of the head, k = tailLength the faintest
+    for (int32_t k = 0; k <= tailLength; k++) {
+        int32_t pos = headLed + 1 - k;
+        if (pos < 0 || pos >= numLeds) {
+            continue;
+        }
+
+        // Distance behind the head in 1/256 LED (negative = ahead of it)
+        int32_t d256 = (k - 1) * 256 + frac;
+        uint8_t brightness;
+        if (d256 < 0) {
+            brightness = (uint8_t)(((256 + d256) * 255) >> 8);
+        } else if (d256 < tail256) {
+            brightness = (uint8_t)(255 * (tail256 - d256) / tail256);
+        } else {
+            continue;
+        }
+        if (brightness == 0) {
+            continue;
+        }
+
+        int32_t ledIndex = reverse ? (numLeds - 1) - pos : pos;
+        leds[ledIndex] = color;
+        leds[ledIndex].nscale8(brightness);
+    }
+}
+
+// Draw a comet sweeping through space along the y axis of the layout, so LEDs
+// at the same height light together whichever arm or ring they are on.
+// head8 is the head height in 1/256 coordinate units, measured from the bottom
+// (the top when reverse is set); the tail fades over tailSpan coordinate units.
+// The head's leading edge fades in over pitch256 (1/256 coordinate units), the
+// height between neighbouring LEDs, so the head passes smoothly from one LED to
+// the next as in renderComet. Only the comet's LEDs are written; the caller
+// clears the strip.
+inline void renderSweep(CRGB* leds, uint16_t numLeds, const LedPoint* points, const CRGB& color,
+                        uint32_t head8, uint8_t tailSpan, uint16_t pitch256, bool reverse) {
+    const int32_t tail256 = (int32_t)tailSpan * 256;
+    const int32_t edge256 = pitch256 ? pitch256 : 256;
+    for (uint16_t i = 0; i < numLeds; i++) {
+        int32_t height = reverse ? 255 - points[i].y : points[i].y;
+
+        // Distance behind the head in 1/256 coordinate units (negative = ahead of it)
+        int32_t d256 = (int32_t)head8 - height * 256;
+        uint8_t brightness;
+        if (d256 < -edge256) {
+            continue;
+        } else if (d256 < 0) {
+            brightness = (uint8_t)((edge256 + d256) * 255 / edge256);
+        } else if (d256 < tail256) {
+            brightness = (uint8_t)(255 * (tail256 - d256) / tail256);
+        } else {
+            continue;
+        }
+        if (brightness == 0) {
+            continue;
+        }
+
+        leds[i] = color;
+        leds[i].nscale8(brightness);
+    }
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <Arduino.h>
+#include "protocol.h"
+#include "metrics.h"
+
+// Reassembly configuration
+#define REASSEMBLY_SLOTS 4              // Messages reassembled concurrently
+#define REASSEMBLY_TIMEOUT_US 100000    // Drop incomplete messages after 100 ms
+#define REASSEMBLY_MAX_FRAGMENTS ((FRAGMENT_MAX_MESSAGE_SIZE + FRAGMENT_PAYLOAD_SIZE - 1) / FRAGMENT_PAYLOAD_SIZE)
+
+static_assert(REASSEMBLY_MAX_FRAGMENTS <= 32, "Fragment bitmask is 32 bits");
+
+// Reassembles fragmented messages from a fixed pool of buffers (no heap allocation).
+// Runs entirely in the ESP-NOW receive callback.
+class Reassembler {
+public:
+    Reassembler() {
+        for (uint8_t i = 0; i < REASSEMBLY_SLOTS; i++) {
+            slots[i].inUse = false;
+        }
+    }
+
+    // Accept one fragment. Returns the reassembled message once all fragments have
+    // arrived; the pointer is valid until the next call.
+    const uint8_t* accept(const uint8_t* data, int len, uint32_t nowUs, size_t& outLen) {
+        expire(nowUs);
+
+        if (len < (int)sizeof(FragmentHeader)) {
+            fragmentsInvalid++;
+            return nullptr;
+        }
+
+        FragmentHeader frag;
+        memcpy(&frag, data, sizeof(frag));
+        const uint8_t* payload = data + sizeof(FragmentHeader);
+        size_t payloadLen = len - sizeof(FragmentHeader);
+
+        if (!isValid(frag, payloadLen)) {
+            fragmentsInvalid++;
+            return nullptr;
+        }
+
+        Slot* slot = findSlot(frag);
+        if (!slot) {
+            slot = allocateSlot(frag, nowUs);
+        } else if (slot->receivedMask & (1UL << frag.fragmentIndex)) {
+            fragmentsDuplicate++;
+            return nullptr;
+        }
+
+        memcpy(slot->data + frag.fragmentIndex * FRAGMENT_PAYLOAD_SIZE, payload, payloadLen);
+        slot->receivedMask |= 1UL << frag.fragmentIndex;
+
+        uint32_t completeMask = (frag.fragmentCount == 32) ? 0xFFFFFFFFUL : ((1UL << frag.fragmentCount) - 1);
+        if (slot->receivedMask != completeMask) {
+            return nullptr;
+        }
+
+        slot->inUse = false;
+        messagesCompleted++;
+        outLen = slot->totalLength;
+        return slot->data;
+    }
+
+    uint32_t getMessagesCompleted() const { return messagesCompleted; }
+    uint32_t getMessagesIncomplete() const { return messagesIncomplete; }
+    uint32_t getMessagesEvicted() const { return messagesEvicted; }
+    uint32_t getFragmentsInvalid() const { return fragmentsInvalid; }
+    uint32_t getFragmentsDuplicate() const { return fragmentsDuplicate; }
+
+private:
+    struct Slot {
+        uint8_t data[FRAGMENT_MAX_MESSAGE_SIZE];
+        bool inUse;
+        uint16_t messageId;
+        uint8_t fragmentCount;
+        uint16_t totalLength;
+        uint32_t receivedMask;
+        uint32_t startUs;
+    };
+
+    Slot slots[REASSEMBLY_SLOTS];
+
+    MetricCounter messagesCompleted;
+    MetricCounter messagesIncomplete;  // Timed out waiting for missing fragments
+    MetricCounter messagesEvicted;     // Pushed out of a full pool by a newer message
+    MetricCounter fragmentsInvalid;
+    MetricCounter fragmentsDuplicate;
+
+    static bool isValid(const FragmentHeader& frag, size_t payloadLen) {
+        if (frag.totalLength == 0 || frag.totalLength > FRAGMENT_MAX_MESSAGE_SIZE) {
+            return false;
+        }
+        uint8_t expectedCount = (frag.totalLength + FRAGMENT_PAYLOAD_SIZE - 1) / FRAGMENT_PAYLOAD_SIZE;
+        if (frag.fragmentCount != expectedCount || frag.fragmentIndex >= frag.fragmentCount) {
+            return false;
+        }
+        size_t offset = frag.fragmentIndex * FRAGMENT_PAYLOAD_SIZE;
+        size_t expectedLen = frag.totalLength - offset;
+        if (expectedLen > FRAGMENT_PAYLOAD_SIZE) {
+            expectedLen = FRAGMENT_PAYLOAD_SIZE;
+        }
+        return payloadLen == expectedLen;
+    }
+
+    Slot* findSlot(const FragmentHeader& frag) {
+        for (uint8_t i = 0; i < REASSEMBLY_SLOTS; i++) {
+            Slot& slot = slots[i];
+            if (slot.inUse && slot.messageId == frag.messageId &&
+                slot.totalLength == frag.totalLength) {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+
+    Slot* allocateSlot(const FragmentHeader& frag, uint32_t nowUs) {
+        Slot* slot = nullptr;
+        for (uint8_t i = 0; i < REASSEMBLY_SLOTS; i++) {
+            if (!slots[i].inUse) {
+                slot = &slots[i];
+                break;
+            }
+        }
+
+        if (!slot) {
+            // Pool full: evict the oldest partial message
+            slot = &slots[0];
+            for (uint8_t i = 1; i < REASSEMBLY_SLOTS; i++) {
+                if ((int32_t)(slots[i].startUs - slot->startUs) < 0) {
+                    slot = &slots[i];
+                }
+            }
+            messagesEvicted++;
+        }
+
+        slot->inUse = true;
+        slot->messageId = frag.messageId;
+        slot->fragmentCount = frag.fragmentCount;
+        slot->totalLength = frag.totalLength;
+        slot->receivedMask = 0;
+        slot->startUs = nowUs;
+        return slot;
+    }
+
+    void expire(uint32_t nowUs) {
+        for (uint8_t i = 0; i < REASSEMBLY_SLOTS; i++) {
+            Slot& slot = slots[i];
+            if (slot.inUse && (nowUs - slot.startUs) > REASSEMBLY_TIMEOUT_US) {
+                slot.inUse = false;
+                messagesIncomplete++;
+            }
+        }
+    }
+};
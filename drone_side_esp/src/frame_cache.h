@@ -0,0 +1,145 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include "patterns.h"
+
+// Frame cache configuration
+#define FRAME_CACHE_BYTES (24 * 1024)  // Pixel memory for cached frames (one BRAINWAVE cycle at 30 LEDs)
+#define FRAME_CACHE_WAYS 4             // Entries a frame may occupy; the least recently used is evicted
+
+// Everything a cacheable frame depends on
+struct FrameCacheKey {
+    LedPattern pattern;
+    CRGB color;
+    uint8_t hueShift;
+    uint8_t intensity;
+    uint16_t frame;  // Index of the distinct frame within the cycle
+
+    bool operator==(const FrameCacheKey& other) const {
+        return pattern == other.pattern && color == other.color && hueShift == other.hueShift &&
+               intensity == other.intensity && frame == other.frame;
+    }
+};
+
+// Index of the distinct frame a periodic pattern shows at this phase. Patterns
+// with few distinct frames per cycle are cacheable: STATIC has one, BLINK two
+// (on, off) and GRADIENT 256 (one per step). SWEEP moves the comet in 1/256 LED
+// steps, so its frames rarely repeat and are always rendered.
+// Must match what the renderers in pattern_renderers.h read from the phase.
+inline bool patternFrameIndex(PatternTiming timing, uint32_t phase, uint16_t& frame) {
+    switch (timing) {
+        case PatternTiming::STATIC:
+            frame = 0;
+            return true;
+        case PatternTiming::BLINK:
+            frame = phase >> 31;
+            return true;
+        case PatternTiming::GRADIENT:
+            frame = phase >> 24;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Rendered frames of periodic patterns, so a pattern's frames are drawn once and
+// then replayed with a memcpy. Set-associative within a fixed memory budget: a
+// key maps to one set of FRAME_CACHE_WAYS entries and evicts the least recently
+// used of them. Keys hold every input of the frame, so entries never go stale.
+template <uint16_t NumLeds, size_t BudgetBytes = FRAME_CACHE_BYTES>
+class FrameCache {
+public:
+    static constexpr size_t FRAME_BYTES = NumLeds * sizeof(CRGB);
+    static constexpr uint16_t SETS = BudgetBytes / FRAME_BYTES / FRAME_CACHE_WAYS;
+    static constexpr uint16_t SLOTS = SETS * FRAME_CACHE_WAYS;
+    static_assert(SETS > 0, "FRAME_CACHE_BYTES is too small to cache a frame of this strip");
+
+    FrameCache() : tick(0), framesCached(0), hits(0), misses(0), evictions(0) {
+        clear();
+    }
+
+    // Copy the cached frame for key into out. Returns false on a miss.
+    bool fetch(const FrameCacheKey& key, CRGB* out) {
+        uint16_t first = setFor(key) * FRAME_CACHE_WAYS;
+        for (uint16_t i = first; i < first + FRAME_CACHE_WAYS; i++) {
+            if (entries[i].valid && entries[i].key == key) {
+                entries[i].lastUsed = ++tick;
+                memcpy(out, frames[i], FRAME_BYTES);
+                hits++;
+                return true;
+            }
+        }
+        misses++;
+        return false;
+    }
+
+    // Cache a rendered frame, evicting the least recently used entry of its set if full
+    void store(const FrameCacheKey& key, const CRGB* frame) {
+        uint16_t first = setFor(key) * FRAME_CACHE_WAYS;
+        uint16_t victim = first;
+        for (uint16_t i = first; i < first + FRAME_CACHE_WAYS; i++) {
+            if (!entries[i].valid) {
+                victim = i;
+                break;
+            }
+            if (entries[i].lastUsed < entries[victim].lastUsed) {
+                victim = i;
+            }
+        }
+
+        if (entries[victim].valid) {
+            evictions++;
+        } else {
+            framesCached++;
+        }
+        entries[victim].key = key;
+        entries[victim].lastUsed = ++tick;
+        entries[victim].valid = true;
+        memcpy(frames[victim], frame, FRAME_BYTES);
+    }
+
+    void clear() {
+        for (uint16_t i = 0; i < SLOTS; i++) {
+            entries[i].valid = false;
+            entries[i].lastUsed = 0;
+        }
+        framesCached = 0;
+    }
+
+    // Statistics
+    uint32_t getHits() const { return hits; }
+    uint32_t getMisses() const { return misses; }
+    uint32_t getEvictions() const { return evictions; }
+    uint16_t getFramesCached() const { return framesCached; }
+    uint32_t getBytesUsed() const { return (uint32_t)framesCached * FRAME_BYTES; }
+    uint32_t getBudgetBytes() const { return (uint32_t)SLOTS * FRAME_BYTES; }
+
+    uint8_t getHitRatePercent() const {
+        uint32_t lookups = hits + misses;
+        return lookups ? (uint8_t)((uint64_t)hits * 100 / lookups) : 0;
+    }
+
+private:
+    struct Entry {
+        FrameCacheKey key;
+        uint32_t lastUsed;
+        bool valid;
+    };
+
+    Entry entries[SLOTS];
+    CRGB frames[SLOTS][NumLeds];
+    uint32_t tick;
+    uint16_t framesCached;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+
+    // Frames of one pattern land in consecutive sets, so a whole cycle spreads evenly
+    static uint16_t setFor(const FrameCacheKey& key) {
+        uint32_t hash = (uint32_t)key.pattern * 2654435761UL;
+        hash ^= ((uint32_t)key.color.r << 16 | (uint32_t)key.color.g << 8 | key.color.b) * 40503UL;
+        hash ^= ((uint32_t)key.hueShift << 8 | key.intensity) * 2246822519UL;
+        return (uint16_t)((hash + key.frame) % SETS);
+    }
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <FastLED.h>
+#include "protocol.h"
+
+// Decode an encoded frame payload directly into a framebuffer of numLeds pixels.
+// For DELTA frames the framebuffer must hold the previous frame; skipped pixels
+// are left untouched. Pixels beyond numLeds are ignored and, for keyframes,
+// framebuffer pixels beyond pixelCount are cleared.
+// Returns false on malformed data (the framebuffer may then be partially updated).
+inline bool decodeFrame(FrameEncoding encoding, const uint8_t* src, size_t len,
+                        uint16_t pixelCount, CRGB* leds, uint16_t numLeds) {
+    uint16_t limit = pixelCount < numLeds ? pixelCount : numLeds;
+
+    if (encoding == FrameEncoding::RAW) {
+        if (len != (size_t)pixelCount * 3) {
+            return false;
+        }
+        memcpy(leds, src, limit * sizeof(CRGB));
+        if (limit < numLeds) {
+            memset(leds + limit, 0, (numLeds - limit) * sizeof(CRGB));
+        }
+        return true;
+    }
+
+    bool allowSkip = (encoding == FrameEncoding::DELTA);
+    if (!allowSkip && encoding != FrameEncoding::RLE) {
+        return false;
+    }
+
+    size_t pos = 0;
+    uint16_t px = 0;
+    while (pos < len) {
+        uint8_t op = src[pos++];
+        uint16_t count;
+
+        if (op < FRAME_OP_RUN) {
+            count = op + 1;
+            if (pos + count * 3 > len || px + count > pixelCount) {
+                return false;
+            }
+            if (px < limit) {
+                uint16_t n = (px + count <= limit) ? count : limit - px;
+                memcpy(leds + px, src + pos, n * sizeof(CRGB));
+            }
+            pos += count * 3;
+        } else if (op < FRAME_OP_SKIP) {
+            count = (op & 0x3F) + 1;
+            if (pos + 3 > len || px + count > pixelCount) {
+                return false;
+            }
+            CRGB color(src[pos], src[pos + 1], src[pos + 2]);
+            for (uint16_t i = px; i < px + count && i < limit; i++) {
+                leds[i] = color;
+            }
+            pos += 3;
+        } else {
+            count = (op & 0x3F) + 1;
+            if (!allowSkip || px + count > pixelCount) {
+                return false;
+            }
+        }
+        px += count;
+    }
+
+    if (px != pixelCount) {
+        return false;
+    }
+    if (!allowSkip && limit < numLeds) {
+        memset(leds + limit, 0, (numLeds - limit) * sizeof(CRGB));
+    }
+    return true;
+}
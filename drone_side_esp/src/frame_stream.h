@@ -0,0 +1,242 @@
+#pragma once
+
+#include <atomic>
+#include <FastLED.h>
+#include "frame_codec.h"
+#include "protocol.h"
+#include "metrics.h"
+
+// Frame streaming configuration
+#define FRAME_JITTER_SLOTS 4             // Frames buffered ahead of playout
+#define FRAME_JITTER_DELAY_US 30000      // Playout delay absorbing radio jitter (~2 frames at 60 fps)
+#define FRAME_STREAM_TIMEOUT_US 500000   // Fall back to the pattern engine after 500 ms without frames
+#define FRAME_REANCHOR_LATE 3            // Consecutive late frames before the playout clock is re-anchored
+
+// Jitter buffer for pixel frames rendered on the ground.
+// Frames are scheduled at their sender timestamp plus a fixed playout offset, so
+// they are shown at the rate they were produced regardless of arrival jitter.
+// Slots hold the encoded payload; at playout it is decoded straight into the
+// framebuffer, which also holds the reference for the next DELTA frame.
+// push() runs in the WiFi task and render() in the main loop; each slot is owned
+// by exactly one side at a time through its atomic state. What loop() reads of
+// the receive side (isActive() and the receive counters) is atomic too.
+// After a timeout the controller draws its patterns into the framebuffer, so the
+// first frame of a resumed stream is flagged as a restart and render() waits for
+// a keyframe rather than applying a DELTA on top of pattern pixels.
+template <uint16_t NumLeds>
+class FrameStream {
+public:
+    FrameStream() : hasFrames(false), needsReanchor(false), restartPending(false),
+                    playoutOffsetUs(0), consecutiveLate(0), hasPlayed(false), lastPlayedFrame(0),
+                    framesPlayed(0), framesSkipped(0), framesUndecodable(0),
+                    latencySumUs(0), latencyMaxUs(0), decodedBytes(0), encodedBytes(0),
+                    decodeSumUs(0), decodeMaxUs(0) {
+        for (uint8_t i = 0; i < FRAME_JITTER_SLOTS; i++) {
+            slots[i].state.store(SLOT_FREE);
+        }
+    }
+
+    void push(uint16_t frameNumber, uint32_t sampleTimeUs, FrameEncoding encoding,
+              uint16_t pixelCount, const uint8_t* payload, size_t payloadLen, uint32_t nowUs) {
+        framesReceived++;
+
+        if (payloadLen > FRAME_MAX_PAYLOAD) {
+            framesOverflow++;
+            return;
+        }
+
+        if (!isActive(nowUs) || needsReanchor) {
+            // (Re)start the playout clock relative to this frame. After a timeout
+            // the framebuffer no longer holds the last streamed frame.
+            restartPending |= !isActive(nowUs);
+            playoutOffsetUs = nowUs + FRAME_JITTER_DELAY_US - sampleTimeUs;
+            needsReanchor = false;
+            consecutiveLate = 0;
+        } else {
+            int16_t delta = (int16_t)(frameNumber - lastFrameNumber.get());
+            if (delta <= 0) {
+                framesLate++;  // Duplicate or reordered
+                return;
+            }
+            if (delta > 1) {
+                framesMissing += delta - 1;
+            }
+        }
+
+        lastFrameNumber.set(frameNumber);
+        lastArrivalUs.set(nowUs);
+        hasFrames.store(true, std::memory_order_release);  // After lastArrivalUs
+
+        uint32_t playAtUs = sampleTimeUs + playoutOffsetUs;
+        if ((int32_t)(playAtUs - nowUs) < 0) {
+            framesLate++;
+            if (++consecutiveLate >= FRAME_REANCHOR_LATE) {
+                needsReanchor = true;  // Sender clock drifted away from ours
+            }
+            return;
+        }
+        consecutiveLate = 0;
+
+        Slot* slot = nullptr;
+        for (uint8_t i = 0; i < FRAME_JITTER_SLOTS; i++) {
+            uint8_t expected = SLOT_FREE;
+            if (slots[i].state.compare_exchange_strong(expected, SLOT_WRITING)) {
+                slot = &slots[i];
+                break;
+            }
+        }
+        if (!slot) {
+            framesOverflow++;
+            return;
+        }
+
+        memcpy(slot->payload, payload, payloadLen);
+        slot->payloadLen = payloadLen;
+        slot->encoding = encoding;
+        slot->pixelCount = pixelCount;
+        slot->frameNumber = frameNumber;
+        slot->playAtUs = playAtUs;
+        slot->arrivalUs = nowUs;
+        slot->restart = restartPending;
+        restartPending = false;
+        slot->state.store(SLOT_READY, std::memory_order_release);
+    }
+
+    // Decode all due frames, oldest first, into leds. Returns false if no frame
+    // was due, in which case leds keeps the previously played frame.
+    bool render(CRGB* leds, uint32_t nowUs) {
+        bool played = false;
+
+        while (Slot* slot = nextDue(nowUs)) {
+            if (played) {
+                framesSkipped++;  // Decoded but superseded before being shown
+            }
+
+            // A DELTA frame only applies on top of its immediate predecessor,
+            // played since the stream last restarted
+            if (slot->restart) {
+                hasPlayed = false;
+            }
+            bool isDelta = (slot->encoding == FrameEncoding::DELTA);
+            if (isDelta && (!hasPlayed || (uint16_t)(slot->frameNumber - 1) != lastPlayedFrame)) {
+                framesUndecodable++;
+                slot->state.store(SLOT_FREE, std::memory_order_release);
+                continue;
+            }
+
+            uint32_t decodeStart = micros();
+            bool ok = decodeFrame(slot->encoding, slot->payload, slot->payloadLen,
+                                  slot->pixelCount, leds, NumLeds);
+            uint32_t decodeUs = micros() - decodeStart;
+
+            if (ok) {
+                hasPlayed = true;
+                lastPlayedFrame = slot->frameNumber;
+                played = true;
+                framesPlayed++;
+
+                decodedBytes += slot->pixelCount * 3;
+                encodedBytes += slot->payloadLen;
+                decodeSumUs += decodeUs;
+                if (decodeUs > decodeMaxUs) {
+                    decodeMaxUs = decodeUs;
+                }
+
+                uint32_t latency = nowUs - slot->arrivalUs;
+                latencySumUs += latency;
+                if (latency > latencyMaxUs) {
+                    latencyMaxUs = latency;
+                }
+            } else {
+                // Framebuffer may be partially written: wait for the next keyframe
+                framesUndecodable++;
+                hasPlayed = false;
+            }
+            slot->state.store(SLOT_FREE, std::memory_order_release);
+        }
+
+        return played;
+    }
+
+    bool isActive(uint32_t nowUs) const {
+        return hasFrames.load(std::memory_order_acquire) &&
+               (nowUs - lastArrivalUs.get()) < FRAME_STREAM_TIMEOUT_US;
+    }
+
+    uint32_t getFramesReceived() const { return framesReceived; }
+    uint32_t getFramesPlayed() const { return framesPlayed; }
+    uint32_t getFramesLate() const { return framesLate; }
+    uint32_t getFramesSkipped() const { return framesSkipped; }
+    uint32_t getFramesMissing() const { return framesMissing; }
+    uint32_t getFramesOverflow() const { return framesOverflow; }
+    uint32_t getFramesUndecodable() const { return framesUndecodable; }
+    uint32_t getLatencyAvgUs() const { return framesPlayed ? (uint32_t)(latencySumUs / framesPlayed) : 0; }
+    uint32_t getLatencyMaxUs() const { return latencyMaxUs; }
+    uint32_t getDecodeAvgUs() const { return framesPlayed ? (uint32_t)(decodeSumUs / framesPlayed) : 0; }
+    uint32_t getDecodeMaxUs() const { return decodeMaxUs; }
+    uint16_t getLastFrameNumber() const { return lastFrameNumber.get(); }
+
+    // Decoded bytes per transmitted payload byte, x100
+    uint32_t getCompressionRatioX100() const {
+        return encodedBytes ? (uint32_t)(decodedBytes * 100 / encodedBytes) : 0;
+    }
+
+private:
+    enum : uint8_t { SLOT_FREE, SLOT_WRITING, SLOT_READY };
+
+    struct Slot {
+        uint8_t payload[FRAME_MAX_PAYLOAD];
+        size_t payloadLen;
+        FrameEncoding encoding;
+        uint16_t pixelCount;
+        uint16_t frameNumber;
+        uint32_t playAtUs;
+        uint32_t arrivalUs;
+        bool restart;  // First frame after the stream timed out
+        std::atomic<uint8_t> state;
+    };
+
+    Slot slots[FRAME_JITTER_SLOTS];
+
+    // Written by push() (WiFi task); the atomics and metrics are also read by loop()
+    std::atomic<bool> hasFrames;
+    bool needsReanchor;
+    bool restartPending;  // Stream timed out; flag the next buffered frame
+    MetricGauge lastFrameNumber;
+    MetricGauge lastArrivalUs;
+    uint32_t playoutOffsetUs;
+    uint8_t consecutiveLate;
+    MetricCounter framesReceived;
+    MetricCounter framesLate;      // Arrived after their playout time, or reordered
+    MetricCounter framesMissing;   // Gaps in the frame counter
+    MetricCounter framesOverflow;  // Jitter buffer full or payload too large
+
+    // Written by render() (main loop)
+    bool hasPlayed;
+    uint16_t lastPlayedFrame;
+    uint32_t framesPlayed;
+    uint32_t framesSkipped;     // Superseded by a newer due frame
+    uint32_t framesUndecodable; // Malformed, or DELTA without its reference frame
+    uint64_t latencySumUs;      // Arrival -> display
+    uint32_t latencyMaxUs;
+    uint64_t decodedBytes;
+    uint64_t encodedBytes;
+    uint64_t decodeSumUs;
+    uint32_t decodeMaxUs;
+
+    // Oldest ready slot whose playout time has come
+    Slot* nextDue(uint32_t nowUs) {
+        Slot* due = nullptr;
+        for (uint8_t i = 0; i < FRAME_JITTER_SLOTS; i++) {
+            Slot& slot = slots[i];
+            if (slot.state.load(std::memory_order_acquire) != SLOT_READY ||
+                (int32_t)(slot.playAtUs - nowUs) > 0) {
+                continue;
+            }
+            if (!due || (int16_t)(slot.frameNumber - due->frameNumber) < 0) {
+                due = &slot;
+            }
+        }
+        return due;
+    }
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// Log-scale histogram configuration
+#define HISTOGRAM_BUCKETS 16  // Bucket i counts [2^(i-1), 2^i) us; the last also holds anything larger
+
+// Always-on latency histogram with power-of-two buckets (1 us .. 16 ms and up).
+// Recording is a count-leading-zeros and a few relaxed atomic adds, so it can be
+// fed from the render loop and the WiFi callback at the same time without locks.
+class LogHistogram {
+public:
+    LogHistogram() {
+        reset();
+    }
+
+    void record(uint32_t valueUs) {
+        buckets[bucketFor(valueUs)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        uint32_t previous = maxUs.load(std::memory_order_relaxed);
+        while (valueUs > previous && !maxUs.compare_exchange_weak(previous, valueUs, std::memory_order_relaxed)) {
+        }
+    }
+
+    void reset() {
+        for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+            buckets[i].store(0, std::memory_order_relaxed);
+        }
+        count.store(0, std::memory_order_relaxed);
+        maxUs.store(0, std::memory_order_relaxed);
+    }
+
+    // Bucket index for a value: 0 for 0 us, otherwise 1 + floor(log2(value)), capped
+    static uint8_t bucketFor(uint32_t valueUs) {
+        if (valueUs == 0) {
+            return 0;
+        }
+        uint8_t bucket = 32 - __builtin_clz(valueUs);
+        return bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1;
+    }
+
+    // Exclusive upper bound of a bucket in us (0 = unbounded)
+    static uint32_t bucketLimitUs(uint8_t bucket) {
+        return bucket < HISTOGRAM_BUCKETS - 1 ? (1UL << bucket) : 0;
+    }
+
+    // Upper bound of the bucket holding the given percentile (0-100), in us.
+    // Values in the last bucket report the maximum seen.
+    uint32_t percentileUs(uint8_t percentile) const {
+        uint32_t total = getCount();
+        if (total == 0) {
+            return 0;
+        }
+        uint32_t target = (uint32_t)(((uint64_t)total * percentile + 99) / 100);
+        uint32_t seen = 0;
+        for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+            seen += getBucket(i);
+            if (seen >= target) {
+                uint32_t limit = bucketLimitUs(i);
+                return limit == 0 || limit > getMaxUs() ? getMaxUs() : limit;
+            }
+        }
+        return getMaxUs();
+    }
+
+    uint32_t getBucket(uint8_t bucket) const { return buckets[bucket].load(std::memory_order_relaxed); }
+    uint32_t getCount() const { return count.load(std::memory_order_relaxed); }
+    uint32_t getMaxUs() const { return maxUs.load(std::memory_order_relaxed); }
+
+    // One machine-parseable line: [HIST] <name> <count> <max> <bucket 0> ... <bucket N-1>
+    void dump(Print& out, const char* name) const {
+        out.printf("[HIST] %s %u %u", name, getCount(), getMaxUs());
+        for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+            out.printf(" %u", getBucket(i));
+        }
+        out.printf("\n");
+    }
+
+private:
+    std::atomic<uint32_t> buckets[HISTOGRAM_BUCKETS];
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> maxUs;
+};
@@ -0,0 +1,539 @@
+#pragma once
+
+#include <Arduino.h>
+#include "patterns.h"
+#include "compositor.h"
+#include "pattern_stack.h"
+#include "segments.h"
+
+// Scanner limits
+#define LED_COMMAND_MAX_DEPTH 10   // Same nesting limit as ArduinoJson
+#define LED_COMMAND_MAX_STRING 24  // Longer strings cannot match any known name or key
+
+// Decoded led_command message
+struct LedCommand {
+    PatternConfig config;
+    LayerSettings layer;
+    PrioritySettings priority;
+    uint64_t timestamp;
+};
+
+// Why a message was rejected
+enum class LedCommandError : uint8_t {
+    NONE,
+    SYNTAX,           // Not valid JSON
+    INVALID_TYPE,     // "type" is missing or not "led_command"
+    MISSING_DATA,     // "data" is missing or not an object
+    MISSING_PATTERN   // "data.pattern" is missing or not a string
+};
+
+// Single-pass, zero-allocation parser for the led_command message.
+// Walks the JSON text once, validating its syntax and decoding only the known
+// fields straight into a LedCommand; everything else is skipped. Accepts and
+// rejects the same messages as the ArduinoJson-based parser it replaces, and
+// converts values the same way (out-of-range numbers read as 0, the last of
+// duplicate keys wins, text after the root object is ignored), but needs no
+// JsonDocument: the only state is a few bytes of cursor and the output.
+class LedCommandScanner {
+public:
+    LedCommandScanner() : cursor(nullptr), end(nullptr), depth(0), error(LedCommandError::NONE) {}
+
+    // Parse len bytes of JSON. On success fills out and returns true.
+    bool parse(const char* json, size_t len, LedCommand& out) {
+        error = LedCommandError::SYNTAX;
+        if (!json) {
+            return false;
+        }
+        cursor = json;
+        end = json + len;
+        depth = 0;
+
+        Root root;
+        skipWhitespace();
+        if (atEnd()) {
+            return false;
+        }
+        if (peek() == '{') {
+            if (!parseRoot(root)) {
+                return false;
+            }
+        } else {
+            // Valid JSON that is not an object has no "type"
+            if (!skipValue()) {
+                return false;
+            }
+            error = LedCommandError::INVALID_TYPE;
+            return false;
+        }
+
+        if (!root.isCommand) {
+            error = LedCommandError::INVALID_TYPE;
+            return false;
+        }
+        if (!root.hasData) {
+            error = LedCommandError::MISSING_DATA;
+            return false;
+        }
+        const Data& data = root.data;
+        if (data.pattern.kind != Value::STRING) {
+            error = LedCommandError::MISSING_PATTERN;
+            return false;
+        }
+
+        // Default config for the pattern, overridden by the fields present
+        LedPattern pattern = data.pattern.truncated ? LedPattern::IDLE : stringToPattern(data.pattern.str);
+        out.config = PatternDefaults::getDefault(pattern);
+        if (data.colorCount >= 3) {
+            out.config.color = CRGB(toUnsigned(data.color[0], 255), toUnsigned(data.color[1], 255),
+                                    toUnsigned(data.color[2], 255));
+        }
+        if (data.brightness.kind != Value::ABSENT) {
+            out.config.brightness = toUnsigned(data.brightness, 255);
+        }
+        if (data.speed.kind != Value::ABSENT) {
+            out.config.speed = toUnsigned(data.speed, 65535);
+        }
+
+        out.layer.layer = stringToLayer(asString(data.layer));
+        out.layer.blend = stringToBlendMode(asString(data.blend));
+        out.layer.opacity = data.opacity.kind != Value::ABSENT ? toUnsigned(data.opacity, 255) : 255;
+        out.layer.segment = toUnsigned(data.segment, 255);
+
+        out.priority.priority = data.priority.kind != Value::ABSENT ? stringToPriority(asString(data.priority))
+                                                                    : defaultPriority(pattern);
+        out.priority.ttlMs = toUnsigned(data.ttl, UINT32_MAX);
+        out.priority.clear = toBool(data.clear);
+        out.priority.implicit = data.priority.kind == Value::ABSENT;
+
+        out.timestamp = toUnsigned(root.timestamp, UINT64_MAX);
+
+        error = LedCommandError::NONE;
+        return true;
+    }
+
+    LedCommandError getError() const {
+        return error;
+    }
+
+private:
+    // A scalar JSON value, decoded just enough to convert it like ArduinoJson
+    struct Value {
+        enum Kind : uint8_t { ABSENT, NUL, BOOLEAN, INTEGER, REAL, STRING, COMPOUND };
+        Kind kind = ABSENT;
+        bool boolean = false;
+        bool negative = false;
+        uint64_t integer = 0;
+        double real = 0;
+        bool truncated = false;
+        char str[LED_COMMAND_MAX_STRING + 1];
+    };
+
+    // Fields of the "data" object
+    struct Data {
+        Value pattern;
+        Value color[3];
+        uint16_t colorCount = 0;  // Elements in the color array (0 if not an array)
+        Value brightness;
+        Value speed;
+        Value layer;
+        Value blend;
+        Value opacity;
+        Value segment;
+        Value priority;
+        Value ttl;
+        Value clear;
+    };
+
+    // Fields of the root object
+    struct Root {
+        bool isCommand = false;
+        bool hasData = false;
+        Data data;
+        Value timestamp;
+    };
+
+    const char* cursor;
+    const char* end;
+    uint8_t depth;
+    LedCommandError error;
+
+    bool atEnd() const { return cursor >= end; }
+    char peek() const { return atEnd() ? '\0' : *cursor; }
+
+    void skipWhitespace() {
+        while (!atEnd() && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')) {
+            cursor++;
+        }
+    }
+
+    bool consume(char c) {
+        skipWhitespace();
+        if (peek() != c) {
+            return false;
+        }
+        cursor++;
+        return true;
+    }
+
+    // Read an object key (quoted, or unquoted as ArduinoJson allows) into key
+    bool parseKey(char* key, size_t keySize) {
+        skipWhitespace();
+        char c = peek();
+        if (c == '"' || c == '\'') {
+            Value value;
+            if (!parseString(value)) {
+                return false;
+            }
+            strncpy(key, value.truncated ? "" : value.str, keySize);
+            key[keySize - 1] = '\0';
+        } else {
+            size_t n = 0;
+            while (!atEnd() && (isalnum((unsigned char)*cursor) || *cursor == '_' || *cursor == '-' ||
+                                *cursor == '+' || *cursor == '.')) {
+                if (n < keySize - 1) {
+                    key[n] = *cursor;
+                }
+                n++;
+                cursor++;
+            }
+            if (n == 0) {
+                return false;
+            }
+            key[n < keySize - 1 ? n : 0] = '\0';  // Over-long keys match nothing
+        }
+        return consume(':');
+    }
+
+    // Iterate the members of an object, calling member(key) to parse each value
+    template <typename MemberFn>
+    bool parseObject(MemberFn member) {
+        if (!consume('{') || ++depth > LED_COMMAND_MAX_DEPTH) {
+            return false;
+        }
+        if (consume('}')) {
+            depth--;
+            return true;
+        }
+        do {
+            char key[16];
+            if (!parseKey(key, sizeof(key)) || !member(key)) {
+                return false;
+            }
+        } while (consume(','));
+        depth--;
+        return consume('}');
+    }
+
+    bool parseRoot(Root& root) {
+        return parseObject([&](const char* key) {
+            if (strcmp(key, "type") == 0) {
+                Value type;
+                if (!parseScalar(type)) {
+                    return false;
+                }
+                root.isCommand = (type.kind == Value::STRING && !type.truncated &&
+                                  strcmp(type.str, "led_command") == 0);
+                return true;
+            }
+            if (strcmp(key, "data") == 0) {
+                skipWhitespace();
+                root.hasData = (peek() == '{');
+                root.data = Data();
+                return root.hasData ? parseData(root.data) : skipValue();
+            }
+            if (strcmp(key, "timestamp") == 0) {
+                return parseScalar(root.timestamp);
+            }
+            return skipValue();
+        });
+    }
+
+    bool parseData(Data& data) {
+        return parseObject([&](const char* key) {
+            if (strcmp(key, "color") == 0) {
+                return parseColor(data);
+            }
+            Value* field = nullptr;
+            if (strcmp(key, "pattern") == 0) field = &data.pattern;
+            else if (strcmp(key, "brightness") == 0) field = &data.brightness;
+            else if (strcmp(key, "speed") == 0) field = &data.speed;
+            else if (strcmp(key, "layer") == 0) field = &data.layer;
+            else if (strcmp(key, "blend") == 0) field = &data.blend;
+            else if (strcmp(key, "opacity") == 0) field = &data.opacity;
+            else if (strcmp(key, "segment") == 0) field = &data.segment;
+            else if (strcmp(key, "priority") == 0) field = &data.priority;
+            else if (strcmp(key, "ttl") == 0) field = &data.ttl;
+            else if (strcmp(key, "clear") == 0) field = &data.clear;
+            return field ? parseScalar(*field) : skipValue();
+        });
+    }
+
+    // Color array: the first three elements are kept, the rest only counted
+    bool parseColor(Data& data) {
+        data.colorCount = 0;
+        skipWhitespace();
+        if (peek() != '[') {
+            return skipValue();
+        }
+        cursor++;
+        if (++depth > LED_COMMAND_MAX_DEPTH) {
+            return false;
+        }
+        if (consume(']')) {
+            depth--;
+            return true;
+        }
+        do {
+            if (data.colorCount < 3) {
+                data.color[data.colorCount] = Value();
+                if (!parseScalar(data.color[data.colorCount])) {
+                    return false;
+                }
+            } else if (!skipValue()) {
+                return false;
+            }
+            data.colorCount++;
+        } while (consume(','));
+        depth--;
+        return consume(']');
+    }
+
+    // Parse any value; objects and arrays are validated and marked COMPOUND
+    bool parseScalar(Value& value) {
+        skipWhitespace();
+        char c = peek();
+        if (c == '"' || c == '\'') {
+            return parseString(value);
+        }
+        if (c == '{' || c == '[') {
+            value.kind = Value::COMPOUND;
+            return skipValue();
+        }
+        if (c == '-' || c == '+' || (c >= '0' && c <= '9')) {
+            return parseNumber(value);
+        }
+        return parseLiteral(value);
+    }
+
+    bool parseLiteral(Value& value) {
+        static const struct { const char* text; Value::Kind kind; bool boolean; } literals[] = {
+            {"true", Value::BOOLEAN, true}, {"false", Value::BOOLEAN, false}, {"null", Value::NUL, false}
+        };
+        for (const auto& literal : literals) {
+            size_t n = strlen(literal.text);
+            if ((size_t)(end - cursor) >= n && memcmp(cursor, literal.text, n) == 0) {
+                cursor += n;
+                value.kind = literal.kind;
+                value.boolean = literal.boolean;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // String with escapes decoded; longer strings are marked truncated
+    bool parseString(Value& value) {
+        char quote = *cursor++;
+        size_t n = 0;
+        value.kind = Value::STRING;
+        value.truncated = false;
+        while (!atEnd()) {
+            char c = *cursor++;
+            if (c == quote) {
+                value.str[n < LED_COMMAND_MAX_STRING ? n : LED_COMMAND_MAX_STRING] = '\0';
+                return true;
+            }
+            if (c == '\\') {
+                if (atEnd()) {
+                    return false;
+                }
+                c = *cursor++;
+                switch (c) {
+                    case '"': case '\'': case '\\': case '/': break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'n': c = '\n'; break;
+                    case 'r': c = '\r'; break;
+                    case 't': c = '\t'; break;
+                    case 'u': {
+                        // Only ASCII code points can match a name; others just need to be well-formed
+                        if (end - cursor < 4) {
+                            return false;
+                        }
+                        uint16_t code = 0;
+                        for (int i = 0; i < 4; i++) {
+                            char h = *cursor++;
+                            if (!isxdigit((unsigned char)h)) {
+                                return false;
+                            }
+                            code = code * 16 + (h <= '9' ? h - '0' : (h | 0x20) - 'a' + 10);
+                        }
+                        c = code < 0x80 ? (char)code : '\x80';
+                        break;
+                    }
+                    default:
+                        return false;
+                }
+            }
+            if (n < LED_COMMAND_MAX_STRING) {
+                value.str[n] = c;
+            } else {
+                value.truncated = true;
+            }
+            n++;
+        }
+        return false;  // Unterminated
+    }
+
+    bool parseNumber(Value& value) {
+        const char* start = cursor;
+        value.negative = (*cursor == '-');
+        if (*cursor == '-' || *cursor == '+') {
+            cursor++;
+        }
+
+        bool isInteger = true;
+        bool overflow = false;
+        uint64_t integer = 0;
+        size_t digits = 0;
+        while (!atEnd() && *cursor >= '0' && *cursor <= '9') {
+            uint8_t d = *cursor++ - '0';
+            if (integer > (UINT64_MAX - d) / 10) {
+                overflow = true;
+            }
+            integer = integer * 10 + d;
+            digits++;
+        }
+        if (!atEnd() && *cursor == '.') {
+            isInteger = false;
+            cursor++;
+            while (!atEnd() && *cursor >= '0' && *cursor <= '9') {
+                cursor++;
+                digits++;
+            }
+        }
+        if (digits == 0) {
+            return false;
+        }
+        if (!atEnd() && (*cursor == 'e' || *cursor == 'E')) {
+            isInteger = false;
+            cursor++;
+            if (!atEnd() && (*cursor == '-' || *cursor == '+')) {
+                cursor++;
+            }
+            if (atEnd() || *cursor < '0' || *cursor > '9') {
+                return false;
+            }
+            while (!atEnd() && *cursor >= '0' && *cursor <= '9') {
+                cursor++;
+            }
+        }
+
+        if (isInteger && !overflow) {
+            value.kind = Value::INTEGER;
+            value.integer = integer;
+        } else {
+            // Too long for 64 bits, or fractional: parse as a double
+            char text[40];
+            size_t n = min((size_t)(cursor - start), sizeof(text) - 1);
+            memcpy(text, start, n);
+            text[n] = '\0';
+            value.kind = Value::REAL;
+            value.real = strtod(text, nullptr);
+        }
+        return true;
+    }
+
+    // Validate and skip any value
+    bool skipValue() {
+        skipWhitespace();
+        char c = peek();
+        if (c == '{') {
+            return parseObject([&](const char*) { return skipValue(); });
+        }
+        if (c == '[') {
+            cursor++;
+            if (++depth > LED_COMMAND_MAX_DEPTH) {
+                return false;
+            }
+            if (consume(']')) {
+                depth--;
+                return true;
+            }
+            do {
+                if (!skipValue()) {
+                    return false;
+                }
+            } while (consume(','));
+            depth--;
+            return consume(']');
+        }
+        Value ignored;
+        return parseScalar(ignored);
+    }
+
+    static const char* asString(const Value& value) {
+        if (value.kind != Value::STRING) {
+            return nullptr;
+        }
+        return value.truncated ? "" : value.str;
+    }
+
+    // Convert like ArduinoJson's as<unsigned T>(): out-of-range and non-numeric values give 0
+    static uint64_t toUnsigned(const Value& value, uint64_t max) {
+        switch (value.kind) {
+            case Value::BOOLEAN:
+                return value.boolean ? 1 : 0;
+            case Value::INTEGER:
+                return (value.negative && value.integer != 0) || value.integer > max ? 0 : value.integer;
+            case Value::REAL:
+                return value.real >= 0 && value.real <= (double)max ? (uint64_t)value.real : 0;
+            case Value::STRING: {
+                // Numeric strings are converted as numbers
+                if (value.truncated || value.str[0] == '\0') {
+                    return 0;
+                }
+                LedCommandScanner inner;
+                inner.cursor = value.str;
+                inner.end = value.str + strlen(value.str);
+                Value number;
+                char c = value.str[0];
+                if (!(c == '-' || c == '+' || (c >= '0' && c <= '9')) || !inner.parseNumber(number)) {
+                    return 0;
+                }
+                return toUnsigned(number, max);
+            }
+            default:
+                return 0;
+        }
+    }
+
+    // Convert like ArduinoJson's as<bool>()
+    static bool toBool(const Value& value) {
+        switch (value.kind) {
+            case Value::ABSENT:
+            case Value::NUL:
+                return false;
+            case Value::BOOLEAN:
+                return value.boolean;
+            case Value::INTEGER:
+                return value.integer != 0;
+            case Value::REAL:
+                return value.real != 0;
+            default:
+                return true;
+        }
+    }
+};
+
+// Log text for a parse error
+inline const char* ledCommandErrorToString(LedCommandError error) {
+    switch (error) {
+        case LedCommandError::NONE: return "OK";
+        case LedCommandError::SYNTAX: return "JSON parse error";
+        case LedCommandError::INVALID_TYPE: return "Invalid message type";
+        case LedCommandError::MISSING_DATA: return "Missing data object";
+        case LedCommandError::MISSING_PATTERN: return "Missing pattern field";
+        default: return "UNKNOWN";
+    }
+}
@@ -2,24 +2,74 @@
 
 #include <FastLED.h>
 #include "patterns.h"
+#include "animation_timing.h"
+#include "transition.h"
+#include "compositor.h"
+#include "pattern_stack.h"
+#include "param_stream.h"
+#include "frame_stream.h"
+#include "log_ring.h"
+#include "trace_ring.h"
+#include "histogram.h"
+#include "metrics.h"
+#include "frame_cache.h"
+#include "output_stage.h"
+#include "energy_meter.h"
+#include "led_layout.h"
+#include "segments.h"
 
 // LED Configuration
 #define LED_PIN 2           // XIAO ESP32S3 GPIO2 for data line
 #define NUM_LEDS 30         // Default 30 LEDs (adjustable for 60 LED/m)
 #define LED_TYPE WS2813     // WS2813 LED strip with signal line redundancy
-#define COLOR_ORDER GRB     // Color order for WS2813
+#define COLOR_ORDER GRB     // Color order for WS2813 (applied by the output stage)
+
+// LED commands queued from the WiFi task until the next frame
+#define COMMAND_QUEUE_SLOTS 8  // Power of two
+#define COMMAND_QUEUE_CRITICAL_SLOTS 2  // Kept free for CRITICAL commands
+
+// Render time histograms: one per base pattern, plus streamed frames
+#define RENDER_SLOT_FRAMES PATTERN_COUNT
+#define RENDER_SLOTS (PATTERN_COUNT + 1)
+
+// One received led_command, applied by update()
+struct QueuedLedCommand {
+    PatternConfig config;
+    LayerSettings layer;
+    PrioritySettings priority;
+    uint32_t queuedUs;
+};
 
 class LedController {
 public:
-    LedController() : currentConfig(PatternDefaults::getDefault(LedPattern::IDLE)),
-                      cycleStart(0), currentStep(0) {
-        FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS);
-        FastLED.setBrightness(PatternDefaults::DEFAULT_BRIGHTNESS);
-        FastLED.clear();
-        FastLED.show();
+    explicit LedController(MicrosClock clockSource = micros)
+        : clock(clockSource), displayedLevel(0),
+          previousConfig(PatternDefaults::getDefault(LedPattern::IDLE)),
+          transitionType(TransitionType::CROSSFADE), transitionMs(TRANSITION_DEFAULT_MS),
+          segmentLeds(0), frameCacheEnabled(true), shownConfig(PatternDefaults::getDefault(LedPattern::IDLE)),
+          lastFrameUs(0), lastIntervalUs(0), lastFrameMa(0), lastRenderSlot(0) {
+        memset(output, 0, sizeof(output));
+        OutputStage::seedResidue(ditherResidue, NUM_LEDS);
+        for (uint8_t i = 0; i < LAYER_COUNT - 1; i++) {
+            overlays[i].config = PatternDefaults::getDefault(LedPattern::IDLE);
+            overlays[i].blend = BlendMode::NORMAL;
+            overlays[i].opacity = 0;
+        }
+        for (uint8_t i = 0; i < SEGMENT_COUNT - 1; i++) {
+            segments[i].range = {0, 0};
+            segments[i].config = PatternDefaults::getDefault(LedPattern::IDLE);
+        }
     }
 
+    // Register the output with FastLED and blank the strip. Only the controller
+    // driving the strip calls this; tests can build controllers without it.
     void begin() {
+        // The output stage writes wire-order bytes with brightness and gamma applied,
+        // so FastLED passes them through unchanged
+        FastLED.addLeds<LED_TYPE, LED_PIN, RGB>(output, NUM_LEDS);
+        FastLED.setBrightness(255);
+        FastLED.setDither(DISABLE_DITHER);
+        FastLED.show();
         Serial.println("[LED] Controller initialized");
         setPattern(LedPattern::IDLE);
     }
@@ -28,179 +78,531 @@ public:
         setPattern(PatternDefaults::getDefault(pattern));
     }
 
-    void setPattern(const PatternConfig& config) {
-        currentConfig = config;
-        FastLED.setBrightness(config.brightness);
-        cycleStart = millis();
-        currentStep = 0;
-        Serial.printf("[LED] Pattern set: %s, Brightness: %d, Speed: %d ms\n",
-                      patternToString(config.pattern), config.brightness, config.speed);
+    // Set a pattern at its default priority (EMERGENCY preempts, others are flight
+    // state). As before priorities existed, a flight state set this way also ends
+    // an EMERGENCY that was set this way; one set at an explicit priority stays
+    // until it is cleared or expires.
+    void setPattern(const PatternConfig& config, uint32_t ttlMs = 0) {
+        PatternPriority priority = defaultPriority(config.pattern);
+        const PatternSlot& critical = patterns.slot((uint8_t)PatternPriority::CRITICAL);
+        if (priority == PatternPriority::NORMAL && critical.active && critical.implicit) {
+            snapshotDisplayed();
+            patterns.clear(PatternPriority::CRITICAL);
+        }
+        placePattern(config, priority, ttlMs, true);
+    }
+
+    // Set the pattern at a priority level. Higher levels preempt lower ones,
+    // for ttlMs if non-zero; patterns set below the displayed level wait
+    // underneath. A change of displayed pattern takes effect at the next frame
+    // using the configured transition, and EMERGENCY always cuts in immediately.
+    void setPattern(const PatternConfig& config, PatternPriority priority, uint32_t ttlMs = 0) {
+        placePattern(config, priority, ttlMs, false);
+    }
+
+    // Remove the pattern at a priority level; the next one down resumes where it left off
+    void clearPattern(PatternPriority priority) {
+        snapshotDisplayed();
+        patterns.clear(priority);
+        showTopPattern(NO_LEVEL, clock());
+    }
+
+    // Queue a received command for the next update(). Safe to call from the
+    // WiFi task: only loop() touches pattern, layer and segment state.
+    // Other commands cannot fill the last slots, so a burst of them never
+    // drops an EMERGENCY (or its clear).
+    bool queueCommand(const PatternConfig& config, const LayerSettings& layer, const PrioritySettings& priority) {
+        uint32_t reserve = priority.priority == PatternPriority::CRITICAL ? 0 : COMMAND_QUEUE_CRITICAL_SLOTS;
+        return commands.push({config, layer, priority, (uint32_t)clock()}, reserve);
     }
 
     void update() {
-        unsigned long now = millis();
-
-        switch (currentConfig.pattern) {
-            case LedPattern::IDLE:
-                updateStatic();
-                break;
-            case LedPattern::TAKING_OFF:
-                updateFlowUp(now);
-                break;
-            case LedPattern::HOVERING:
-                updateBlink(now);
-                break;
-            case LedPattern::FLYING:
-                updateBlink(now);
-                break;
-            case LedPattern::LANDING:
-                updateFlowDown(now);
-                break;
-            case LedPattern::EMERGENCY:
-                updateBlink(now);
-                break;
-            case LedPattern::LOW_BATTERY:
-                updateBlink(now);
-                break;
-            case LedPattern::BRAINWAVE:
-                updateBrainwave(now);
-                break;
+        applyQueuedCommands();
+
+        TRACE_BEGIN(RENDER);
+        uint32_t nowUs = clock();
+
+        // Restore the pattern below an expired preemption
+        if (patterns.topLevel() != (uint8_t)PatternPriority::NORMAL) {
+            snapshotDisplayed();
+            patterns.expire(nowUs);
+            showTopPattern(NO_LEVEL, nowUs);
+        }
+        PatternSlot& shown = patterns.slot(displayedLevel);
+
+        // Streamed ground-rendered frames replace the base pattern (overlay and
+        // alert layers stay on top). When the stream stops, the last commanded
+        // pattern resumes.
+        uint8_t baseBrightness = outputStage.patternScale(shown.config.brightness);
+        uint32_t baseScale = ((uint32_t)baseBrightness + 1) << 8;  // 8.8, for the 16-bit composite
+        uint8_t renderSlot = (uint8_t)shown.config.pattern;
+        BrightnessSpan spans[SEGMENT_COUNT - 1];
+        uint8_t spanCount = 0;
+        if (frameStream.isActive(nowUs)) {
+            renderSlot = RENDER_SLOT_FRAMES;
+            frameStream.render(baseLeds, nowUs);
+        } else {
+            // Segments draw over their ranges of the base pattern, except under
+            // CRITICAL patterns. The base is skipped when segments cover it all.
+            bool segmentsShown = segmentLeds > 0 && displayedLevel != (uint8_t)PatternPriority::CRITICAL;
+            bool baseShown = !segmentsShown || segmentLeds < NUM_LEDS;
+            if (baseShown) {
+                renderPattern(baseLeds, shown.config, shown.animation, nowUs);
+            }
+
+            // Blend from the outgoing pattern, fading brightness between the two
+            if (baseShown && transition.isActive()) {
+                uint8_t amount = transition.progress(nowUs);
+                if (transition.isActive()) {
+                    uint32_t blendStartUs = clock();
+                    renderPattern(transitionBuffer, previousConfig, previousAnimation, nowUs);
+                    transition.blendFrames(baseLeds, transitionBuffer, baseLeds, NUM_LEDS, amount);
+                    uint8_t fromBrightness = outputStage.patternScale(previousConfig.brightness);
+                    baseScale = (((uint32_t)fromBrightness + 1) << 8) +
+                                ((int32_t)baseBrightness - fromBrightness) * amount;
+                    baseBrightness = lerp8by8(fromBrightness, baseBrightness, amount);
+                    transition.recordFrameCost(clock() - blendStartUs);
+                }
+            }
+
+            if (segmentsShown) {
+                spanCount = renderSegments(baseLeds, spans, nowUs);
+            }
+        }
+
+        // Render enabled overlay layers and composite everything in one pass. The
+        // composite goes to its own buffer: baseLeds keeps the streamed frame that the
+        // next DELTA frame (or a frame that is not yet due) builds on.
+        LayerSource sources[LAYER_COUNT - 1];
+        uint8_t sourceCount = 0;
+        for (uint8_t i = 0; i < LAYER_COUNT - 1; i++) {
+            Layer& layer = overlays[i];
+            if (layer.opacity == 0) {
+                continue;
+            }
+            renderPattern(layerBuffers[i], layer.config, layer.animation, nowUs);
+            sources[sourceCount++] = {layerBuffers[i], outputStage.patternScale(layer.config.brightness),
+                                      layer.blend, layer.opacity};
         }
+        if (outputStage.isDithering()) {
+            uint32_t ditherStartUs = clock();
+            compositeLayers16(leds16, leds, baseLeds, baseScale, sources, sourceCount, NUM_LEDS, spans, spanCount);
+            outputStage.applyDithered<COLOR_ORDER>(output, leds16, ditherResidue, NUM_LEDS, layout.getPhysicalMap());
+            outputStage.recordDitherCost(clock() - ditherStartUs);
+        } else {
+            compositeLayers(leds, baseLeds, baseBrightness, sources, sourceCount, NUM_LEDS, spans, spanCount);
+            outputStage.apply<COLOR_ORDER>(output, leds, NUM_LEDS, layout.getPhysicalMap());
+        }
+        uint32_t showStartUs = clock();
+        renderTime[renderSlot].record(showStartUs - nowUs);
+        TRACE_END(RENDER, renderSlot);
 
+        TRACE_BEGIN(SHOW);
         FastLED.show();
+        TRACE_END(SHOW, 0);
+        showTime.record(clock() - showStartUs);
+        shownConfig.write(shown.config);
+
+        // Jitter: change in frame-to-frame interval
+        if (lastFrameUs != 0) {
+            uint32_t intervalUs = nowUs - lastFrameUs;
+            energy[lastRenderSlot].record(lastFrameMa, intervalUs);  // The previous frame was shown until now
+            if (lastIntervalUs != 0) {
+                frameJitter.record(intervalUs > lastIntervalUs ? intervalUs - lastIntervalUs
+                                                               : lastIntervalUs - intervalUs);
+            }
+            lastIntervalUs = intervalUs;
+        }
+        lastFrameUs = nowUs;
+        lastFrameMa = outputStage.getOutputMa();
+        lastRenderSlot = renderSlot;
+    }
+
+    // Render time of frames showing a base pattern, or RENDER_SLOT_FRAMES for streamed frames
+    const LogHistogram& getRenderTime(uint8_t slot) const {
+        return renderTime[slot];
+    }
+
+    const LogHistogram& getShowTime() const {
+        return showTime;
+    }
+
+    const LogHistogram& getFrameJitter() const {
+        return frameJitter;
+    }
+
+    // Time commands wait in the queue for the next frame
+    const LogHistogram& getCommandLatency() const {
+        return commandLatency;
+    }
+
+    // Commands dropped because the queue was full
+    uint32_t getCommandsDropped() const {
+        return commands.getDropped();
+    }
+
+    // Estimated strip energy while showing a base pattern, or RENDER_SLOT_FRAMES for streamed frames
+    const EnergyMeter& getEnergy(uint8_t slot) const {
+        return energy[slot];
     }
 
+    // Base pattern shown by the last update(). A consistent snapshot, safe to
+    // read from another task while a frame is being rendered.
     PatternConfig getCurrentConfig() const {
-        return currentConfig;
+        return shownConfig.read();
     }
 
-private:
-    CRGB leds[NUM_LEDS];
-    PatternConfig currentConfig;
-    unsigned long cycleStart;
-    uint8_t currentStep;
+    const PatternStack& getPatternStack() const {
+        return patterns;
+    }
 
-    void updateStatic() {
-        fill_solid(leds, NUM_LEDS, currentConfig.color);
+    // Feed a streamed BRAINWAVE parameter sample. Unlike setPattern() this does
+    // not restart the animation; values are interpolated per frame.
+    void pushParamSample(const StreamParams& params, uint16_t sequence, uint32_t sampleTimeUs) {
+        paramStream.pushSample(params, sequence, sampleTimeUs, clock());
     }
 
-    void updateBlink(unsigned long now) {
-        unsigned long elapsed = now - cycleStart;
+    const ParamInterpolator& getParamStream() const {
+        return paramStream;
+    }
 
-        if (elapsed >= currentConfig.speed) {
-            cycleStart = now;
-            currentStep = !currentStep;
-        }
+    // Queue an encoded pixel frame for playout through the jitter buffer
+    void pushFrame(const FrameMessageHeader& frame, const uint8_t* payload, size_t payloadLen) {
+        frameStream.push(frame.frameNumber, frame.sampleTimeUs, frame.encoding,
+                         frame.pixelCount, payload, payloadLen, clock());
+    }
 
-        if (currentStep) {
-            fill_solid(leds, NUM_LEDS, currentConfig.color);
-        } else {
-            FastLED.clear();
+    const FrameStream<NUM_LEDS>& getFrameStream() const {
+        return frameStream;
+    }
+
+    // Show a pattern on an overlay layer above the base pattern.
+    // Opacity 0 turns the layer off; the base layer is set with setPattern().
+    void setLayer(LayerId id, const PatternConfig& config, BlendMode blend, uint8_t opacity) {
+        if (id == LayerId::BASE) {
+            setPattern(config);
+            return;
         }
+        Layer& layer = overlays[(uint8_t)id - 1];
+        layer.config = config;
+        layer.blend = blend;
+        layer.opacity = opacity;
+        layer.animation.setPeriod(cyclePeriodUs(config.pattern, config.speed));
+        layer.animation.reset(clock());
+        LOG_INFO("LED", "Layer %s: %s, Blend: %s, Opacity: %d", layerToString(id),
+                 opacity ? patternToString(config.pattern) : "OFF", blendModeToString(blend), opacity);
     }
 
-    void updateFlowUp(unsigned long now) {
-        unsigned long elapsed = now - cycleStart;
+    // Overlay layer state (OVERLAY or ALERT)
+    const Layer& getLayer(LayerId id) const {
+        return overlays[id == LayerId::BASE ? 0 : (uint8_t)id - 1];
+    }
 
-        // Calculate steps for smooth flow
-        uint8_t stepsPerCycle = NUM_LEDS + 10; // Extra steps for gap
-        uint16_t stepDuration = currentConfig.speed / stepsPerCycle;
+    // Set the LED range of a segment (1 .. SEGMENT_COUNT - 1); length 0 removes it.
+    // Fails if the range leaves the strip or overlaps another segment.
+    bool setSegment(uint8_t id, uint16_t start, uint16_t length) {
+        if (id == SEGMENT_MAIN || id >= SEGMENT_COUNT || start + length > NUM_LEDS) {
+            LOG_WARN("LED", "Segment %d rejected: LEDs %u-%u", id, start, start + length);
+            return false;
+        }
+        for (uint8_t i = 0; i < SEGMENT_COUNT - 1; i++) {
+            const SegmentRange& other = segments[i].range;
+            if (i != id - 1 && length > 0 && other.length > 0 && start < other.start + other.length &&
+                other.start < start + length) {
+                LOG_WARN("LED", "Segment %d rejected: overlaps segment %d", id, i + 1);
+                return false;
+            }
+        }
 
-        if (elapsed >= stepDuration) {
-            cycleStart = now;
-            currentStep = (currentStep + 1) % stepsPerCycle;
+        Segment& segment = segments[id - 1];
+        segment.range = {start, length};
+        segment.animation.reset(clock());
+        segmentLeds = 0;
+        for (uint8_t i = 0; i < SEGMENT_COUNT - 1; i++) {
+            segmentLeds += segments[i].range.length;
         }
+        LOG_INFO("LED", "Segment %d: LEDs %u-%u", id, start, start + length);
+        return true;
+    }
 
-        // Clear all LEDs
-        FastLED.clear();
+    // Show a pattern on one segment, with its own animation and timing.
+    // Segment 0 is the whole strip (same as setPattern()).
+    void setSegmentPattern(uint8_t id, const PatternConfig& config) {
+        if (id == SEGMENT_MAIN) {
+            setPattern(config);
+            return;
+        }
+        if (id >= SEGMENT_COUNT) {
+            LOG_WARN("LED", "Unknown segment %d", id);
+            return;
+        }
+        Segment& segment = segments[id - 1];
+        segment.config = config;
+        segment.animation.setPeriod(cyclePeriodUs(config.pattern, config.speed));
+        segment.animation.reset(clock());
+        LOG_INFO("LED", "Segment %d: %s, Brightness: %d, Speed: %d ms", id, patternToString(config.pattern),
+                 config.brightness, config.speed);
+    }
 
-        // Draw flowing pattern (bottom to top)
-        uint8_t tailLength = 10;
-        for (uint8_t i = 0; i < tailLength; i++) {
-            int ledIndex = currentStep - i;
-            if (ledIndex >= 0 && ledIndex < NUM_LEDS) {
-                uint8_t brightness = 255 * (tailLength - i) / tailLength;
-                leds[ledIndex] = currentConfig.color;
-                leds[ledIndex].nscale8(brightness);
-            }
+    // Segment state (1 .. SEGMENT_COUNT - 1)
+    const Segment& getSegment(uint8_t id) const {
+        return segments[id == SEGMENT_MAIN || id >= SEGMENT_COUNT ? 0 : id - 1];
+    }
+
+    // Transition used by subsequent setPattern() calls (CUT or 0 ms switches instantly)
+    void setTransition(TransitionType type, uint16_t durationMs) {
+        transitionType = type;
+        transitionMs = durationMs;
+    }
+
+    const Transition& getTransition() const {
+        return transition;
+    }
+
+    // Replay cached frames of periodic patterns instead of redrawing them.
+    // Output is identical either way; disabling drops the cached frames.
+    void setFrameCacheEnabled(bool enabled) {
+        frameCacheEnabled = enabled;
+        if (!enabled) {
+            frameCache.clear();
         }
     }
 
-    void updateFlowDown(unsigned long now) {
-        unsigned long elapsed = now - cycleStart;
+    const FrameCache<NUM_LEDS>& getFrameCache() const {
+        return frameCache;
+    }
+
+    // Global brightness and gamma of the output stage
+    void setBrightness(uint8_t brightness) {
+        outputStage.setBrightness(brightness);
+        LOG_INFO("LED", "Global brightness: %d", brightness);
+    }
+
+    void setGamma(float gamma) {
+        outputStage.setGamma(gamma);
+        LOG_INFO("LED", "Gamma: %.2f", outputStage.getGamma());
+    }
+
+    // 16-bit composite with temporal dithering to 8 bits, for smooth low-brightness output
+    void setDithering(bool enabled) {
+        outputStage.setDithering(enabled);
+        LOG_INFO("LED", "Dithering: %s", enabled ? "ON" : "OFF");
+    }
+
+    // Strip current limit in mA (0 = unlimited); frames above it are scaled down
+    void setCurrentBudget(uint16_t limitMa) {
+        outputStage.setCurrentBudget(limitMa);
+        LOG_INFO("LED", "Current budget: %u mA", limitMa);
+    }
 
-        // Calculate steps for smooth flow
-        uint8_t stepsPerCycle = NUM_LEDS + 10;
-        uint16_t stepDuration = currentConfig.speed / stepsPerCycle;
+    const OutputStage& getOutputStage() const {
+        return outputStage;
+    }
 
-        if (elapsed >= stepDuration) {
-            cycleStart = now;
-            currentStep = (currentStep + 1) % stepsPerCycle;
+    // Physical layout of the strip: where each LED patterns draw lands on the
+    // wire, and its coordinates. Returns false (keeping the current layout) if
+    // the runs do not cover every LED exactly once.
+    bool setLayout(const LayoutRun* runs, uint8_t runCount) {
+        if (!layout.load(runs, runCount)) {
+            LOG_WARN("LED", "Layout rejected: %d runs do not cover %d LEDs exactly once", runCount, NUM_LEDS);
+            return false;
         }
+        LOG_INFO("LED", "Layout loaded: %d runs, %s", runCount, layout.isRemapped() ? "remapped" : "wire order");
+        return true;
+    }
+
+    const LedLayout<NUM_LEDS>& getLayout() const {
+        return layout;
+    }
 
-        // Clear all LEDs
-        FastLED.clear();
+    // Last composited frame (linear colors, RGB order, logical LED order; the 8-bit view of the 16-bit composite while dithering)
+    const CRGB* getLeds() const {
+        return leds;
+    }
+
+    // Last frame as sent to the strip (after the output stage, in COLOR_ORDER and wire LED order)
+    const CRGB* getOutput() const {
+        return output;
+    }
 
-        // Draw flowing pattern (top to bottom)
-        uint8_t tailLength = 10;
-        for (uint8_t i = 0; i < tailLength; i++) {
-            int ledIndex = (NUM_LEDS - 1) - (currentStep - i);
-            if (ledIndex >= 0 && ledIndex < NUM_LEDS) {
-                uint8_t brightness = 255 * (tailLength - i) / tailLength;
-                leds[ledIndex] = currentConfig.color;
-                leds[ledIndex].nscale8(brightness);
+    // Length of one animation cycle in microseconds (0 = static).
+    // speed is the blink half-period, the flow sweep time, or the BRAINWAVE step time.
+    static uint32_t cyclePeriodUs(LedPattern pattern, uint16_t speed) {
+        switch (patternInfo(pattern).timing) {
+            case PatternTiming::BLINK:
+                return 2UL * speed * 1000;    // On for speed ms, off for speed ms
+            case PatternTiming::SWEEP:
+                return (uint32_t)speed * 1000;  // Full sweep including gap
+            case PatternTiming::GRADIENT: {
+                uint64_t period = 256ULL * speed * 1000;  // One gradient step per speed ms
+                return period > UINT32_MAX ? UINT32_MAX : (uint32_t)period;
             }
+            default:
+                return 0;
         }
     }
 
-    void updateBrainwave(unsigned long now) {
-        unsigned long elapsed = now - cycleStart;
-
-        if (elapsed >= currentConfig.speed) {
-            cycleStart = now;
-            currentStep = (currentStep + 1) % 256;
-        }
-
-        // Create flowing brainwave gradient: Blue → Purple → Pink → Blue
-        // This visualizes BCI (Brain-Computer Interface) control
-        for (uint8_t i = 0; i < NUM_LEDS; i++) {
-            // Calculate position in gradient (0-255) with wave offset
-            uint8_t gradientPos = (currentStep + (i * 256 / NUM_LEDS)) % 256;
-
-            // Create smooth gradient: Blue (0-85) → Purple (86-170) → Pink (171-255)
-            CRGB color;
-            if (gradientPos < 85) {
-                // Blue to Purple transition
-                uint8_t progress = (gradientPos * 3);
-                color = CRGB(
-                    progress,           // R: 0 → 255
-                    progress / 2,       // G: 0 → 127
-                    255                 // B: constant blue
-                );
-            } else if (gradientPos < 170) {
-                // Purple to Pink transition
-                uint8_t progress = ((gradientPos - 85) * 3);
-                color = CRGB(
-                    255,                // R: constant red
-                    127 - progress / 2, // G: 127 → 0
-                    255 - progress      // B: 255 → 0
-                );
+private:
+    // Frame buffers are word-aligned for the 32-bit pixel kernels
+    alignas(4) CRGB baseLeds[NUM_LEDS];          // Base layer: pattern render or decoded stream frame
+    alignas(4) CRGB leds[NUM_LEDS];              // Composite of the base and overlay layers
+    alignas(4) CRGB output[NUM_LEDS];            // Wire-order frame registered with FastLED
+    alignas(4) CRGB transitionBuffer[NUM_LEDS];  // Outgoing pattern during a transition
+    CRGB16 leds16[NUM_LEDS];                     // 16-bit composite when dithering
+    uint8_t ditherResidue[NUM_LEDS * 3];         // Rounding error carried to the next frame
+    MicrosClock clock;
+    PatternStack patterns;
+    uint8_t displayedLevel;
+    PatternConfig previousConfig;
+    PhaseAccumulator previousAnimation;
+    PatternConfig outgoingConfig;
+    PhaseAccumulator outgoingAnimation;
+    TransitionType transitionType;
+    uint16_t transitionMs;
+    Transition transition;
+    Layer overlays[LAYER_COUNT - 1];
+    Segment segments[SEGMENT_COUNT - 1];
+    uint16_t segmentLeds;  // LEDs covered by segments
+    CRGB layerBuffers[LAYER_COUNT - 1][NUM_LEDS];
+    SpscRing<QueuedLedCommand, COMMAND_QUEUE_SLOTS> commands;  // WiFi task -> update()
+    ParamInterpolator paramStream;
+    FrameStream<NUM_LEDS> frameStream;
+    FrameCache<NUM_LEDS> frameCache;
+    bool frameCacheEnabled;
+    OutputStage outputStage;
+    LedLayout<NUM_LEDS> layout;
+
+    // Published by update() for other tasks
+    SeqLock<PatternConfig> shownConfig;
+
+    // Frame timing
+    LogHistogram renderTime[RENDER_SLOTS];
+    LogHistogram showTime;
+    LogHistogram frameJitter;
+    LogHistogram commandLatency;
+    uint32_t lastFrameUs;
+    uint32_t lastIntervalUs;
+
+    // Estimated strip energy per render slot
+    EnergyMeter energy[RENDER_SLOTS];
+    uint32_t lastFrameMa;
+    uint8_t lastRenderSlot;
+
+    static constexpr uint8_t NO_LEVEL = 0xFF;
+
+    // Apply commands received since the last frame, in arrival order
+    void applyQueuedCommands() {
+        QueuedLedCommand cmd;
+        while (commands.pop(cmd)) {
+            TRACE_BEGIN(APPLY);
+            if (cmd.layer.segment != SEGMENT_MAIN) {
+                setSegmentPattern(cmd.layer.segment, cmd.config);
+            } else if (cmd.layer.layer == LayerId::BASE) {
+                if (cmd.priority.clear) {
+                    clearPattern(cmd.priority.priority);
+                } else if (cmd.priority.implicit) {
+                    setPattern(cmd.config, cmd.priority.ttlMs);
+                } else {
+                    setPattern(cmd.config, cmd.priority.priority, cmd.priority.ttlMs);
+                }
             } else {
-                // Pink back to Blue transition
-                uint8_t progress = ((gradientPos - 170) * 3);
-                color = CRGB(
-                    255 - progress,     // R: 255 → 0
-                    0,                  // G: constant 0
-                    progress            // B: 0 → 255
-                );
+                setLayer(cmd.layer.layer, cmd.config, cmd.layer.blend, cmd.layer.opacity);
             }
+            commandLatency.record(clock() - cmd.queuedUs);
+            TRACE_END(APPLY, (uint16_t)cmd.config.pattern);
+        }
+    }
+
+    void placePattern(const PatternConfig& config, PatternPriority priority, uint32_t ttlMs, bool implicit) {
+        uint32_t nowUs = clock();
+        snapshotDisplayed();
+        patterns.set(priority, config, ttlMs, cyclePeriodUs(config.pattern, config.speed), nowUs, implicit);
+        showTopPattern((uint8_t)priority, nowUs);
+        LOG_INFO("LED", "Pattern set: %s, Brightness: %d, Speed: %d ms, Priority: %s, TTL: %u ms",
+                 patternToString(config.pattern), config.brightness, config.speed,
+                 priorityToString(priority), ttlMs);
+    }
 
-            // Apply wave modulation for "brainwave" effect
-            // Creates pulsing intensity like neural activity
-            float wave = sin((gradientPos + currentStep) * 0.05) * 0.3 + 0.7;  // 0.7-1.0 range
-            color.nscale8(wave * 255);
+    // Remember the displayed pattern before the stack changes, as the transition source
+    void snapshotDisplayed() {
+        const PatternSlot& shown = patterns.slot(displayedLevel);
+        outgoingConfig = shown.config;
+        outgoingAnimation = shown.animation;
+    }
 
-            leds[i] = color;
+    // Display the top of the stack if it changed. changedLevel is the level that
+    // was just set (its animation restarts), or NO_LEVEL.
+    void showTopPattern(uint8_t changedLevel, uint32_t nowUs) {
+        uint8_t level = patterns.topLevel();
+        if (level == displayedLevel && level != changedLevel) {
+            return;
+        }
+
+        PatternSlot& next = patterns.slot(level);
+        if (level != changedLevel) {
+            // Restored from below: continue from the phase it was covered at
+            next.animation.resume(nowUs);
+            LOG_INFO("LED", "Pattern restored: %s, Priority: %s",
+                     patternToString(next.config.pattern), priorityToString((PatternPriority)level));
+        }
+
+        // The outgoing pattern keeps animating underneath the transition
+        previousConfig = outgoingConfig;
+        previousAnimation = outgoingAnimation;
+        transition.start(next.config.pattern == LedPattern::EMERGENCY ? TransitionType::CUT : transitionType,
+                         transitionMs, nowUs);
+        displayedLevel = level;
+    }
+
+    // Draw each segment's pattern over its range of out, and list the ranges by start
+    uint8_t renderSegments(CRGB* out, BrightnessSpan* spans, uint32_t nowUs) {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < SEGMENT_COUNT - 1; i++) {
+            Segment& segment = segments[i];
+            const SegmentRange& range = segment.range;
+            if (range.length == 0) {
+                continue;
+            }
+            renderPattern(out + range.start, segment.config, segment.animation, nowUs, range.length, false);
+
+            uint8_t at = count++;
+            for (; at > 0 && spans[at - 1].start > range.start; at--) {
+                spans[at] = spans[at - 1];
+            }
+            spans[at] = {range.start, range.length, outputStage.patternScale(segment.config.brightness)};
+        }
+        return count;
+    }
+
+    // Render one frame of config into out (numLeds LEDs), advancing its animation
+    // to nowUs. Without useLayout the pattern ignores the layout's coordinates and
+    // draws along out as a strip of its own, as segments do (segments.h).
+    void renderPattern(CRGB* out, const PatternConfig& config, PhaseAccumulator& anim, uint32_t nowUs,
+                       uint16_t numLeds = NUM_LEDS, bool useLayout = true) {
+        // Streamed BCI parameters override the BRAINWAVE speed while active
+        StreamParams params = {0, 255, config.speed};
+        bool streamed = config.pattern == LedPattern::BRAINWAVE && paramStream.isActive(nowUs);
+        if (streamed) {
+            params = paramStream.valueAt(nowUs);
+        }
+        anim.setPeriod(cyclePeriodUs(config.pattern, params.speed));
+
+        PatternRenderContext ctx = {config.color, anim.advance(nowUs), params.hueShift, params.intensity,
+                                    useLayout ? layout.getPoints() : nullptr, layout.getPitch256()};
+        const PatternInfo& info = patternInfo(config.pattern);
+
+        // Streamed parameters change every frame, so their frames are not worth caching.
+        // The cache holds whole-strip frames only.
+        uint16_t frame;
+        if (!frameCacheEnabled || streamed || numLeds != NUM_LEDS ||
+            !patternFrameIndex(info.timing, ctx.phase, frame)) {
+            info.render(out, numLeds, ctx);  // One indirect call via the registry
+            return;
+        }
+        FrameCacheKey key = {info.defaults.pattern, config.color, params.hueShift, params.intensity, frame};
+        if (!frameCache.fetch(key, out)) {
+            info.render(out, NUM_LEDS, ctx);
+            frameCache.store(key, out);
         }
     }
 };
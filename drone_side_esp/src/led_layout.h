@@ -0,0 +1,167 @@
+#pragma once
+
+#include <Arduino.h>
+#include <math.h>
+
+// Position of an LED in layout units (e.g. mm). y is up; x and z span the horizontal plane.
+struct LayoutPosition {
+    int16_t x, y, z;
+};
+
+// Normalized LED coordinates: each axis scaled to 0-255 across the layout's extent
+struct LedPoint {
+    uint8_t x, y, z;
+};
+
+enum class LayoutShape : uint8_t {
+    LINE,  // Evenly spaced from `from` (first LED) to `to` (last LED)
+    RING   // Evenly spaced around a vertical axis through `from`, starting at `to`
+};
+
+// A run of LEDs that is contiguous on the wire. Runs are listed in logical
+// order, the order patterns draw in; reversed runs are wired last LED first
+// (e.g. every other arm of a serpentine strip).
+struct LayoutRun {
+    uint16_t physicalStart;  // Wire index of the run's first LED (its last one when reversed)
+    uint16_t count;
+    bool reversed;
+    LayoutShape shape;
+    LayoutPosition from;
+    LayoutPosition to;
+};
+
+// Maps the logical strip patterns draw into onto the physical LEDs. Holds a
+// logical-to-physical index table, applied by the output stage as it writes
+// the wire frame (so patterns pay nothing for it), and a normalized coordinate
+// per logical LED for patterns that draw in space rather than along the strip.
+// Until a layout is loaded the strip is straight and wired in logical order.
+template <uint16_t NumLeds>
+class LedLayout {
+public:
+    LedLayout() : pitch256(NumLeds > 1 ? 255 * 256 / (NumLeds - 1) : 256), remapped(false), loaded(false) {
+        for (uint16_t i = 0; i < NumLeds; i++) {
+            physical[i] = i;
+            points[i] = {0, (uint8_t)(NumLeds > 1 ? i * 255 / (NumLeds - 1) : 0), 0};
+        }
+    }
+
+    // Replace the layout. Fails, keeping the current layout, unless the runs
+    // cover every physical LED exactly once.
+    bool load(const LayoutRun* runs, uint8_t runCount) {
+        uint16_t map[NumLeds];
+        bool used[NumLeds] = {};
+        uint16_t logical = 0;
+        for (uint8_t r = 0; r < runCount; r++) {
+            const LayoutRun& run = runs[r];
+            if (run.count == 0 || logical + run.count > NumLeds || run.physicalStart + run.count > NumLeds) {
+                return false;
+            }
+            for (uint16_t j = 0; j < run.count; j++) {
+                uint16_t wire = run.reversed ? run.physicalStart + run.count - 1 - j : run.physicalStart + j;
+                if (used[wire]) {
+                    return false;
+                }
+                used[wire] = true;
+                map[logical++] = wire;
+            }
+        }
+        if (logical != NumLeds) {
+            return false;
+        }
+
+        remapped = false;
+        for (uint16_t i = 0; i < NumLeds; i++) {
+            physical[i] = map[i];
+            remapped |= map[i] != i;
+        }
+        buildPoints(runs, runCount);
+        loaded = true;
+        return true;
+    }
+
+    // Wire index of each logical LED, or nullptr when they are the same
+    const uint16_t* getPhysicalMap() const {
+        return remapped ? physical : nullptr;
+    }
+
+    // Coordinates of each logical LED, or nullptr until a layout is loaded
+    const LedPoint* getPoints() const {
+        return loaded ? points : nullptr;
+    }
+
+    // Height between neighbouring LEDs of the steepest line run, in 1/256
+    // coordinate units (at least one unit). Spatial patterns use it to move
+    // smoothly from one LED to the next.
+    uint16_t getPitch256() const {
+        return pitch256;
+    }
+
+    uint16_t physicalIndex(uint16_t logical) const {
+        return physical[logical];
+    }
+
+    const LedPoint& point(uint16_t logical) const {
+        return points[logical];
+    }
+
+    bool isLoaded() const { return loaded; }
+    bool isRemapped() const { return remapped; }
+
+private:
+    uint16_t physical[NumLeds];
+    LedPoint points[NumLeds];
+    uint16_t pitch256;
+    bool remapped;
+    bool loaded;
+
+    // Place every LED of the runs, then scale each axis to 0-255
+    void buildPoints(const LayoutRun* runs, uint8_t runCount) {
+        float position[NumLeds][3];
+        uint16_t logical = 0;
+        for (uint8_t r = 0; r < runCount; r++) {
+            const LayoutRun& run = runs[r];
+            for (uint16_t j = 0; j < run.count; j++) {
+                float* p = position[logical++];
+                if (run.shape == LayoutShape::RING) {
+                    float angle = 2.0f * (float)M_PI * j / run.count;
+                    float dx = run.to.x - run.from.x;
+                    float dz = run.to.z - run.from.z;
+                    p[0] = run.from.x + dx * cosf(angle) - dz * sinf(angle);
+                    p[1] = run.to.y;
+                    p[2] = run.from.z + dx * sinf(angle) + dz * cosf(angle);
+                } else {
+                    float t = run.count > 1 ? (float)j / (run.count - 1) : 0.0f;
+                    p[0] = run.from.x + (run.to.x - run.from.x) * t;
+                    p[1] = run.from.y + (run.to.y - run.from.y) * t;
+                    p[2] = run.from.z + (run.to.z - run.from.z) * t;
+                }
+            }
+        }
+
+        float low[3];
+        float scale[3];
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            low[axis] = position[0][axis];
+            float high = low[axis];
+            for (uint16_t i = 1; i < NumLeds; i++) {
+                low[axis] = min(low[axis], position[i][axis]);
+                high = max(high, position[i][axis]);
+            }
+            scale[axis] = high > low[axis] ? 255.0f / (high - low[axis]) : 0.0f;  // A flat axis maps to 0
+        }
+        for (uint16_t i = 0; i < NumLeds; i++) {
+            points[i].x = (uint8_t)((position[i][0] - low[0]) * scale[0] + 0.5f);
+            points[i].y = (uint8_t)((position[i][1] - low[1]) * scale[1] + 0.5f);
+            points[i].z = (uint8_t)((position[i][2] - low[2]) * scale[2] + 0.5f);
+        }
+
+        float pitch = 1.0f;
+        for (uint8_t r = 0; r < runCount; r++) {
+            const LayoutRun& run = runs[r];
+            if (run.shape == LayoutShape::LINE && run.count > 1) {
+                pitch = max(pitch, fabsf((float)(run.to.y - run.from.y)) / (run.count - 1) * scale[1]);
+            }
+        }
+        pitch256 = (uint16_t)(min(pitch, 255.0f) * 256 + 0.5f);
+    }
+};
@@ -6,13 +6,77 @@
 EspNowHandler espNow;
 LedController ledController;
 
+// Base ESP32 MAC address; packets from other senders are dropped
+uint8_t baseMacAddress[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};  // Placeholder - accepts any sender
+
+// Physical LED layout (see led_layout.h): runs in the order patterns draw, each
+// with its wire position and its geometry in mm, y up. The default is one
+// straight strip wired bottom to top. For four arms wired as one serpentine
+// strip, list each arm bottom to top and reverse the arms wired top to bottom:
+//   {0,  8, false, LayoutShape::LINE, {-60, 0, -60}, {-60, 70, -60}},
+//   {8,  8, true,  LayoutShape::LINE, { 60, 0, -60}, { 60, 70, -60}}, ...
+const LayoutRun ledLayout[] = {
+    {0, NUM_LEDS, false, LayoutShape::LINE, {0, 0, 0}, {0, NUM_LEDS * 16, 0}},  // 16 mm pitch (60 LED/m)
+};
+
+// Segment ranges in logical LEDs, for segments 1 .. SEGMENT_COUNT - 1 (see
+// segments.h). LED commands with "segment" set show their pattern there, and
+// everything else shows the flight state. Length 0 leaves a segment unused, e.g.
+// {NUM_LEDS / 2, NUM_LEDS / 2} for the rear half of the strip.
+const SegmentRange ledSegments[SEGMENT_COUNT - 1] = {
+    {0, 0},
+    {0, 0},
+    {0, 0},
+};
+
+// Serial buffer for incoming console commands
+#define SERIAL_BUFFER_SIZE 64
+String serialBuffer = "";
+
 // Statistics
 unsigned long lastStatsTime = 0;
 const unsigned long STATS_INTERVAL = 10000; // 10 seconds
 
 // Callback for LED commands from ESP-NOW
-void onLedCommand(const PatternConfig& config) {
-    ledController.setPattern(config);
+void onLedCommand(const PatternConfig& config, const LayerSettings& layer, const PrioritySettings& priority) {
+    // Runs in the WiFi task: hand the command to loop(), which applies it before the next frame
+    if (!ledController.queueCommand(config, layer, priority)) {
+        LOG_WARN("LED", "Command queue full, %s dropped", patternToString(config.pattern));
+    }
+}
+
+// Callback for streamed BRAINWAVE parameters from ESP-NOW
+void onParamSample(const StreamParams& params, uint16_t sequence, uint32_t sampleTimeUs) {
+    ledController.pushParamSample(params, sequence, sampleTimeUs);
+}
+
+// Callback for streamed pixel frames from ESP-NOW
+void onFrame(const FrameMessageHeader& frame, const uint8_t* payload, size_t payloadLen) {
+    ledController.pushFrame(frame, payload, payloadLen);
+}
+
+// One histogram as a status line
+void printHistogram(const char* label, const LogHistogram& histogram) {
+    Serial.printf("%-15s n %u, p50 %u us, p99 %u us, max %u us\n", label, histogram.getCount(),
+                  histogram.percentileUs(50), histogram.percentileUs(99), histogram.getMaxUs());
+}
+
+// Name of a render time slot (pattern, or streamed frames)
+const char* renderSlotName(uint8_t slot) {
+    return slot == RENDER_SLOT_FRAMES ? "FRAMES" : patternToString((LedPattern)slot);
+}
+
+// All histograms, one machine-parseable line each
+void dumpHistograms() {
+    char name[32];
+    for (uint8_t slot = 0; slot < RENDER_SLOTS; slot++) {
+        snprintf(name, sizeof(name), "render.%s", renderSlotName(slot));
+        ledController.getRenderTime(slot).dump(Serial, name);
+    }
+    ledController.getShowTime().dump(Serial, "show");
+    ledController.getFrameJitter().dump(Serial, "jitter");
+    espNow.getApplyLatency().dump(Serial, "rx_queue");
+    ledController.getCommandLatency().dump(Serial, "queue_apply");
 }
 
 void printStats() {
@@ -24,20 +88,151 @@ void printStats() {
     Serial.printf("Messages RX:    %u\n", espNow.getMessageCount());
     Serial.printf("Last message:   %lu ms ago\n", millis() - espNow.getLastMessageTime());
     Serial.printf("ESP-NOW status: %s\n", espNow.isConnected() ? "CONNECTED" : "DISCONNECTED");
+    Serial.printf("Log:            Lines: %u, Dropped: %u\n",
+                  logRing().getLinesWritten(), logRing().getLinesDropped());
+    Serial.printf("Trace:          Events: %u (send TRACE to dump)\n", traceRing().getEventsRecorded());
+
+    const Reassembler& reassembler = espNow.getReassembler();
+    Serial.printf("Reassembly:     Completed: %u, Incomplete: %u, Evicted: %u, Invalid: %u, Duplicate: %u\n",
+                  reassembler.getMessagesCompleted(), reassembler.getMessagesIncomplete(),
+                  reassembler.getMessagesEvicted(), reassembler.getFragmentsInvalid(),
+                  reassembler.getFragmentsDuplicate());
+
+    const ReceiveFilter& filter = espNow.getFilter();
+    Serial.printf("RX filter:      Accepted: %u, Dropped sender: %u, length: %u, magic: %u (%u allowed senders)\n",
+                  filter.getAccepted(), filter.getDropped(DropReason::SENDER),
+                  filter.getDropped(DropReason::LENGTH), filter.getDropped(DropReason::MAGIC),
+                  filter.getSenderCount());
 
     PatternConfig currentConfig = ledController.getCurrentConfig();
     Serial.printf("Current pattern: %s\n", patternToString(currentConfig.pattern));
     Serial.printf("LED color:      R:%d G:%d B:%d\n",
                   currentConfig.color.r, currentConfig.color.g, currentConfig.color.b);
     Serial.printf("Brightness:     %d\n", currentConfig.brightness);
+    const OutputStage& output = ledController.getOutputStage();
+    Serial.printf("Output:         Global brightness: %d, Gamma: %.2f, Dithering: %s, Over budget: %u\n",
+                  output.getBrightness(), output.getGamma(), output.isDithering() ? "ON" : "OFF",
+                  output.getDitherOverBudget());
+    const LedLayout<NUM_LEDS>& layout = ledController.getLayout();
+    Serial.printf("Layout:         %s, %s\n", layout.isLoaded() ? "LOADED" : "DEFAULT",
+                  layout.isRemapped() ? "remapped" : "wire order");
+    Serial.printf("Strip current:  %u mA (estimated %u mA), Budget: %u mA, Limited frames: %u\n",
+                  output.getOutputMa(), output.getEstimatedMa(), output.getCurrentBudget(),
+                  output.getFramesLimited());
+    for (uint8_t slot = 0; slot < RENDER_SLOTS; slot++) {
+        const EnergyMeter& energy = ledController.getEnergy(slot);
+        if (energy.getTimeMs() > 0) {
+            char label[24];
+            snprintf(label, sizeof(label), "Energy %s:", renderSlotName(slot));
+            uint32_t energyUwh = (uint32_t)energy.getEnergyUwh();
+            Serial.printf("%-15s avg %u mA, %u.%03u mWh over %u s\n", label, energy.getAverageMa(),
+                          energyUwh / 1000, energyUwh % 1000, energy.getTimeMs() / 1000);
+        }
+    }
     Serial.printf("Speed:          %d ms\n", currentConfig.speed);
+    const PatternStack& stack = ledController.getPatternStack();
+    Serial.printf("Priority:       %s, Preemptions: %u, Restores: %u, Expired: %u\n",
+                  priorityToString((PatternPriority)stack.topLevel()), stack.getPreemptions(),
+                  stack.getRestores(), stack.getExpirations());
+    for (uint8_t id = 1; id < SEGMENT_COUNT; id++) {
+        const Segment& segment = ledController.getSegment(id);
+        if (segment.range.length > 0) {
+            Serial.printf("Segment %d:      %s, LEDs %u-%u, Brightness: %d\n", id,
+                          patternToString(segment.config.pattern), segment.range.start,
+                          segment.range.start + segment.range.length - 1, segment.config.brightness);
+        }
+    }
+    for (uint8_t id = (uint8_t)LayerId::OVERLAY; id < LAYER_COUNT; id++) {
+        const Layer& layer = ledController.getLayer((LayerId)id);
+        Serial.printf("Layer %-9s %s, Blend: %s, Opacity: %d\n", layerToString((LayerId)id),
+                      layer.opacity ? patternToString(layer.config.pattern) : "OFF",
+                      blendModeToString(layer.blend), layer.opacity);
+    }
+
+    const Transition& transition = ledController.getTransition();
+    Serial.printf("Transitions:    %s, Started: %u, Completed: %u, Interrupted: %u, Over budget: %u\n",
+                  transitionToString(transition.getType()), transition.getTransitionsStarted(),
+                  transition.getTransitionsCompleted(), transition.getTransitionsInterrupted(),
+                  transition.getTransitionsOverBudget());
+    Serial.printf("Blend cost:     avg %u us, max %u us\n",
+                  transition.getFrameCostAvgUs(), transition.getFrameCostMaxUs());
+
+    for (uint8_t slot = 0; slot < RENDER_SLOTS; slot++) {
+        const LogHistogram& render = ledController.getRenderTime(slot);
+        if (render.getCount() > 0) {
+            char label[24];
+            snprintf(label, sizeof(label), "Render %s:", renderSlotName(slot));
+            printHistogram(label, render);
+        }
+    }
+    const FrameCache<NUM_LEDS>& cache = ledController.getFrameCache();
+    Serial.printf("Frame cache:    Hit rate: %u%%, Hits: %u, Misses: %u, Evictions: %u, Used: %u/%u bytes\n",
+                  cache.getHitRatePercent(), cache.getHits(), cache.getMisses(), cache.getEvictions(),
+                  cache.getBytesUsed(), cache.getBudgetBytes());
+    printHistogram("Show:", ledController.getShowTime());
+    printHistogram("Frame jitter:", ledController.getFrameJitter());
+    printHistogram("RX to queue:", espNow.getApplyLatency());
+    printHistogram("Queue to apply:", ledController.getCommandLatency());
+    Serial.printf("Command queue:  Dropped: %u\n", ledController.getCommandsDropped());
+
+    const ParamInterpolator& stream = ledController.getParamStream();
+    Serial.printf("Param stream:   %s, RX: %u, Lost: %u, Out of order: %u, Interval: %u us\n",
+                  stream.isActive(micros()) ? "ACTIVE" : "IDLE",
+                  stream.getSamplesReceived(), stream.getSamplesLost(),
+                  stream.getSamplesOutOfOrder(), stream.getIntervalUs());
+
+    const FrameStream<NUM_LEDS>& frames = ledController.getFrameStream();
+    Serial.printf("Frame stream:   %s, Frame: %u, RX: %u, Played: %u, Late: %u, Skipped: %u, Missing: %u, Overflow: %u\n",
+                  frames.isActive(micros()) ? "ACTIVE" : "IDLE", frames.getLastFrameNumber(),
+                  frames.getFramesReceived(), frames.getFramesPlayed(), frames.getFramesLate(),
+                  frames.getFramesSkipped(), frames.getFramesMissing(), frames.getFramesOverflow());
+    Serial.printf("Frame latency:  avg %u us, max %u us\n",
+                  frames.getLatencyAvgUs(), frames.getLatencyMaxUs());
+    uint32_t ratio = frames.getCompressionRatioX100();
+    Serial.printf("Frame decode:   avg %u us, max %u us, Compression: %u.%02ux, Undecodable: %u\n",
+                  frames.getDecodeAvgUs(), frames.getDecodeMaxUs(), ratio / 100, ratio % 100,
+                  frames.getFramesUndecodable());
     Serial.println("========================================\n");
 }
 
+void processSerialCommand(const String& command) {
+    String trimmed = command;
+    trimmed.trim();
+
+    if (trimmed == "STATUS") {
+        printStats();
+    } else if (trimmed == "TRACE") {
+        traceRing().dump(Serial, "drone");
+    } else if (trimmed == "HIST") {
+        dumpHistograms();
+    } else if (trimmed.startsWith("BRIGHTNESS:")) {
+        ledController.setBrightness((uint8_t)constrain(trimmed.substring(11).toInt(), 0L, 255L));
+    } else if (trimmed.startsWith("GAMMA:")) {
+        ledController.setGamma(trimmed.substring(6).toFloat());
+    } else if (trimmed == "DITHER:ON" || trimmed == "DITHER:OFF") {
+        ledController.setDithering(trimmed == "DITHER:ON");
+    } else if (trimmed.startsWith("CURRENT:")) {
+        ledController.setCurrentBudget((uint16_t)constrain(trimmed.substring(8).toInt(), 0L, 65535L));
+    } else if (trimmed.startsWith("SEGMENT:")) {
+        // SEGMENT:<id>,<start>,<length>
+        int first = trimmed.indexOf(',');
+        int second = trimmed.indexOf(',', first + 1);
+        if (first > 0 && second > first) {
+            ledController.setSegment((uint8_t)trimmed.substring(8, first).toInt(),
+                                     (uint16_t)constrain(trimmed.substring(first + 1, second).toInt(), 0L, 65535L),
+                                     (uint16_t)constrain(trimmed.substring(second + 1).toInt(), 0L, 65535L));
+        }
+    } else if (trimmed.length() > 0) {
+        Serial.println("[SERIAL] Commands: STATUS, TRACE, HIST, BRIGHTNESS:<0-255>, GAMMA:<value>, DITHER:ON|OFF, "
+                       "CURRENT:<mA>, SEGMENT:<id>,<start>,<length>");
+    }
+}
+
 void setup() {
     // Initialize serial
     Serial.begin(115200);
     delay(1000);
+    logRing().begin();
 
     Serial.println("\n\n");
     Serial.println("========================================");
@@ -47,10 +242,23 @@ void setup() {
 
     // Initialize LED controller
     ledController.begin();
+    ledController.setLayout(ledLayout, sizeof(ledLayout) / sizeof(ledLayout[0]));
+    for (uint8_t id = 1; id < SEGMENT_COUNT; id++) {
+        if (ledSegments[id - 1].length > 0) {
+            ledController.setSegment(id, ledSegments[id - 1].start, ledSegments[id - 1].length);
+        }
+    }
     Serial.println("[MAIN] LED controller initialized");
 
     // Initialize ESP-NOW
-    espNow.begin(onLedCommand);
+    espNow.begin(onLedCommand, onParamSample, onFrame);
+    static const uint8_t placeholderMac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    if (memcmp(baseMacAddress, placeholderMac, 6) != 0) {
+        espNow.allowSender(baseMacAddress);
+        Serial.printf("[MAIN] Accepting packets from %02X:%02X:%02X:%02X:%02X:%02X only\n",
+                      baseMacAddress[0], baseMacAddress[1], baseMacAddress[2],
+                      baseMacAddress[3], baseMacAddress[4], baseMacAddress[5]);
+    }
     Serial.println("[MAIN] ESP-NOW handler initialized");
 
     Serial.println("[MAIN] System ready - waiting for commands...\n");
@@ -60,14 +268,33 @@ void setup() {
 }
 
 void loop() {
+    // Read console commands
+    while (Serial.available()) {
+        char c = Serial.read();
+        if (c == '\n' || c == '\r') {
+            processSerialCommand(serialBuffer);
+            serialBuffer = "";
+        } else if (serialBuffer.length() < SERIAL_BUFFER_SIZE) {
+            serialBuffer += c;
+        }
+    }
+
     // Update LED pattern
     ledController.update();
 
-    // Print stats periodically
+    // Periodic summary through the log ring; the full report (STATUS) blocks on Serial
     unsigned long now = millis();
     if (now - lastStatsTime >= STATS_INTERVAL) {
         lastStatsTime = now;
-        printStats();
+        LOG_INFO("STATS", "Uptime: %lu s, RX: %u, Pattern: %s, Commands dropped: %u, Log dropped: %u",
+                 now / 1000, espNow.getMessageCount(), patternToString(ledController.getCurrentConfig().pattern),
+                 ledController.getCommandsDropped(), logRing().getLinesDropped());
+        uint8_t slot = ledController.getFrameStream().isActive(micros())
+            ? RENDER_SLOT_FRAMES : (uint8_t)ledController.getCurrentConfig().pattern;
+        LOG_INFO("STATS", "p99 us: render %s %u, show %u, jitter %u, rx_queue %u, queue_apply %u",
+                 renderSlotName(slot), ledController.getRenderTime(slot).percentileUs(99),
+                 ledController.getShowTime().percentileUs(99), ledController.getFrameJitter().percentileUs(99),
+                 espNow.getApplyLatency().percentileUs(99), ledController.getCommandLatency().percentileUs(99));
     }
 
     // Small delay to prevent watchdog timeout
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+// Values shared between the WiFi task (ESP-NOW callback) and loop().
+// Kept free of Arduino headers so the native ThreadSanitizer test can build it.
+
+// Statistics counter written by one task and read by another. Relaxed atomics,
+// so reads never see a torn value and no lock is taken. Usable like a plain
+// uint32_t (counter++, counter += n, reads).
+class MetricCounter {
+public:
+    MetricCounter() : value(0) {}
+
+    void operator++(int) {
+        value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void operator+=(uint32_t amount) {
+        value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    operator uint32_t() const {
+        return value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint32_t> value;
+};
+
+// Latest value of a single-word measurement (e.g. a timestamp)
+class MetricGauge {
+public:
+    MetricGauge() : value(0) {}
+
+    void set(uint32_t newValue) {
+        value.store(newValue, std::memory_order_relaxed);
+    }
+
+    uint32_t get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint32_t> value;
+};
+
+// Sequence lock publishing a multi-field struct from one writer task to any
+// number of readers without locks. The writer never waits; a reader that
+// overlaps a write retries, so it always returns a copy from a single write.
+// The payload is held in atomic words so concurrent access is well defined,
+// and ordered without standalone fences (which ThreadSanitizer cannot check).
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+public:
+    SeqLock() : sequence(0) {
+        for (size_t i = 0; i < WORDS; i++) {
+            words[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    explicit SeqLock(const T& initial) : SeqLock() {
+        write(initial);
+    }
+
+    // Publish a new value (single writer only)
+    void write(const T& value) {
+        uint32_t buffer[WORDS] = {0};
+        memcpy(buffer, &value, sizeof(T));
+
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);  // Odd: write in progress
+        for (size_t i = 0; i < WORDS; i++) {
+            // Release: a reader that sees this word also sees the odd sequence
+            words[i].store(buffer[i], std::memory_order_release);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Consistent copy of the last published value
+    T read() const {
+        uint32_t buffer[WORDS];
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; i++) {
+                buffer[i] = words[i].load(std::memory_order_acquire);
+            }
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        T value;
+        memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+
+    // Number of completed writes
+    uint32_t getVersion() const {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> words[WORDS];
+};
+
+// Bounded single-producer, single-consumer queue handing values from one task
+// to another (e.g. parsed commands from the WiFi task to loop()). The producer
+// never waits: when the queue is full the new value is dropped and counted.
+// A push may leave the last `reserve` slots free for more important values.
+template <typename T, uint32_t Slots>
+class SpscRing {
+    static_assert((Slots & (Slots - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    // Producer side
+    bool push(const T& value, uint32_t reserve = 0) {
+        uint32_t pos = head.load(std::memory_order_relaxed);
+        if (pos - tail.load(std::memory_order_acquire) >= Slots - reserve) {
+            dropped++;
+            return false;
+        }
+        slots[pos & (Slots - 1)] = value;
+        head.store(pos + 1, std::memory_order_release);  // Publishes the slot
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& value) {
+        uint32_t pos = tail.load(std::memory_order_relaxed);
+        if (pos == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots[pos & (Slots - 1)];
+        tail.store(pos + 1, std::memory_order_release);  // Hands the slot back
+        return true;
+    }
+
+    uint32_t getDropped() const { return dropped; }
+
+private:
+    T slots[Slots];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    MetricCounter dropped;
+};
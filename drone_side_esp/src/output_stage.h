@@ -0,0 +1,233 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include "pixel_kernels.h"
+
+// Output stage configuration
+#define OUTPUT_GAMMA 2.2f               // LED PWM response; 1.0 sends the composited values unchanged
+#define OUTPUT_DITHER_BUDGET_US 1000    // Max 16-bit composite + dither time per frame
+
+// Strip current model (WS2813: ~20 mA per channel at full duty, ~60 mA per white LED)
+#define POWER_MA_RED 20
+#define POWER_MA_GREEN 20
+#define POWER_MA_BLUE 20
+#define POWER_MA_IDLE 1          // Per LED, all channels off
+#define POWER_BUDGET_MA 1500     // Strip current limit (0 = unlimited)
+
+// Current drawn by one LED channel at full duty, plus the quiescent current per LED
+struct PowerModel {
+    uint16_t redMa;
+    uint16_t greenMa;
+    uint16_t blueMa;
+    uint16_t idleMa;
+};
+
+// Linear color with 8 fractional bits per channel (255.0 = 0xFF00)
+struct CRGB16 {
+    uint16_t r, g, b;
+};
+static constexpr uint16_t COLOR16_MAX = 0xFF00;
+
+// Last step before the LEDs: turns the composited frame (linear colors in RGB
+// order) into the bytes on the wire. Global brightness and gamma are folded into
+// one 256-entry table, so the whole stage is three lookups per pixel, written
+// straight into the strip's color order. Patterns and the compositor never apply
+// global brightness, and FastLED is registered as RGB at full brightness so it
+// sends these bytes as they are. With a layout map, pixels are also written to
+// their physical positions in the same pass. Per-pattern brightness is applied
+// by the compositor, through patternScale() so that it too scales the light
+// output linearly, like global brightness.
+//
+// With dithering on, the stage takes a 16-bit composite instead and keeps the
+// fraction each channel loses to 8 bits, adding it back on the next frame
+// (temporal error diffusion). Averaged over frames the LEDs then show the exact
+// 16-bit level, so low global brightness keeps smooth gradients and fades. If
+// the 16-bit path exceeds OUTPUT_DITHER_BUDGET_US in a frame, dithering turns
+// itself off so it can never cause missed frames.
+//
+// Both paths sum each wire channel as they write it, and estimate the strip
+// current from the sums with a per-channel mA model. If the estimate exceeds
+// the current budget, the frame is scaled down once to fit (PWM duty, and so
+// current, is linear in the wire bytes).
+class OutputStage {
+public:
+    OutputStage()
+        : brightness(255), gamma(OUTPUT_GAMMA), dithering(false), ditherOverBudget(0),
+          power({POWER_MA_RED, POWER_MA_GREEN, POWER_MA_BLUE, POWER_MA_IDLE}), budgetMa(POWER_BUDGET_MA),
+          estimatedMa(0), outputMa(0), framesLimited(0) {
+        buildTable();
+    }
+
+    // Global brightness, applied after gamma so it scales light output linearly
+    void setBrightness(uint8_t value) {
+        brightness = value;
+        buildTable();
+    }
+
+    void setGamma(float value) {
+        gamma = value > 0 ? value : 1.0f;
+        buildTable();
+    }
+
+    void setDithering(bool enabled) {
+        dithering = enabled;
+    }
+
+    void setPowerModel(const PowerModel& model) {
+        power = model;
+    }
+
+    // Strip current limit in mA (0 = unlimited)
+    void setCurrentBudget(uint16_t limitMa) {
+        budgetMa = limitMa;
+    }
+
+    uint8_t getBrightness() const { return brightness; }
+    float getGamma() const { return gamma; }
+    bool isDithering() const { return dithering; }
+    uint32_t getDitherOverBudget() const { return ditherOverBudget; }
+    const PowerModel& getPowerModel() const { return power; }
+    uint16_t getCurrentBudget() const { return budgetMa; }
+    uint32_t getEstimatedMa() const { return estimatedMa; }    // Last frame before limiting
+    uint32_t getOutputMa() const { return outputMa; }          // Last frame as sent
+    uint32_t getFramesLimited() const { return framesLimited; }
+
+    // Strip current for the given channel duty sums (each LED channel 0-255)
+    uint32_t estimateMa(uint32_t redSum, uint32_t greenSum, uint32_t blueSum, uint16_t numLeds) const {
+        uint32_t activeMa = (redSum * power.redMa + greenSum * power.greenMa + blueSum * power.blueMa) / 255;
+        return activeMa + (uint32_t)numLeds * power.idleMa;
+    }
+
+    // Compositor scale for a pattern brightness: the inverse gamma of it, so that
+    // after the gamma table the pattern's light output is proportional to its
+    // brightness (128 gives half the light of 255, not a fifth)
+    uint8_t patternScale(uint8_t brightness) const {
+        return scales[brightness];
+    }
+
+    // Output byte for a linear channel value
+    uint8_t lookup(uint8_t value) const {
+        return table[value];
+    }
+
+    // Output level for a 16-bit channel value, 8 fractional bits (interpolated between table entries)
+    uint16_t lookup16(uint16_t value) const {
+        uint8_t index = value >> 8;
+        uint8_t fraction = value & 0xFF;
+        return table16[index] + (((uint32_t)(table16[index + 1] - table16[index]) * fraction) >> 8);
+    }
+
+    // Brightness, gamma and color order in one pass. out holds wire-order bytes
+    // and may alias in, unless physical is given: then logical LED i is written
+    // to out[physical[i]] (see led_layout.h).
+    template <EOrder Order>
+    void apply(CRGB* out, const CRGB* in, uint16_t numLeds, const uint16_t* physical = nullptr) {
+        // Source channel of each wire byte, as FastLED encodes EOrder (octal digits)
+        constexpr uint8_t first = (Order >> 6) & 0x3;
+        constexpr uint8_t second = (Order >> 3) & 0x3;
+        constexpr uint8_t third = Order & 0x3;
+
+        uint32_t sums[3] = {0, 0, 0};
+        for (uint16_t i = 0; i < numLeds; i++) {
+            const CRGB pixel = in[i];
+            uint8_t wire0 = table[pixel.raw[first]];
+            uint8_t wire1 = table[pixel.raw[second]];
+            uint8_t wire2 = table[pixel.raw[third]];
+            CRGB& led = out[physical ? physical[i] : i];
+            led.raw[0] = wire0;
+            led.raw[1] = wire1;
+            led.raw[2] = wire2;
+            sums[0] += wire0;
+            sums[1] += wire1;
+            sums[2] += wire2;
+        }
+        limitCurrent<Order>(out, sums, numLeds);
+    }
+
+    // 16-bit composite to wire bytes with temporal dithering. residue holds one
+    // byte per output channel (numLeds * 3) and carries each rounding error to
+    // the next frame, indexed like in.
+    template <EOrder Order>
+    void applyDithered(CRGB* out, const CRGB16* in, uint8_t* residue, uint16_t numLeds,
+                       const uint16_t* physical = nullptr) {
+        uint32_t sums[3] = {0, 0, 0};
+        for (uint16_t i = 0; i < numLeds; i++) {
+            CRGB& led = out[physical ? physical[i] : i];
+            const uint16_t channels[3] = {in[i].r, in[i].g, in[i].b};
+            const uint16_t wire[3] = {channels[(Order >> 6) & 0x3], channels[(Order >> 3) & 0x3],
+                                      channels[Order & 0x3]};
+            for (uint8_t c = 0; c < 3; c++) {
+                uint16_t level = lookup16(wire[c]) + residue[i * 3 + c];  // At most 0xFF00 + 0xFF
+                led.raw[c] = level >> 8;
+                residue[i * 3 + c] = level & 0xFF;
+                sums[c] += level >> 8;
+            }
+        }
+        limitCurrent<Order>(out, sums, numLeds);
+    }
+
+    // Spread starting errors across the strip so neighbouring LEDs do not step in sync
+    static void seedResidue(uint8_t* residue, uint16_t numLeds) {
+        for (uint16_t i = 0; i < numLeds * 3; i++) {
+            residue[i] = (uint8_t)(i * 157);
+        }
+    }
+
+    // Time taken by the 16-bit path this frame; over budget turns dithering off
+    void recordDitherCost(uint32_t costUs) {
+        if (dithering && costUs > OUTPUT_DITHER_BUDGET_US) {
+            dithering = false;
+            ditherOverBudget++;
+        }
+    }
+
+private:
+    uint8_t brightness;
+    float gamma;
+    bool dithering;
+    uint32_t ditherOverBudget;
+    PowerModel power;
+    uint16_t budgetMa;
+    uint32_t estimatedMa;
+    uint32_t outputMa;
+    uint32_t framesLimited;
+    uint8_t table[256];
+    uint8_t scales[256];    // Pattern brightness to compositor scale, see patternScale()
+    uint16_t table16[257];  // 8.8 output levels; the extra entry lets lookup16() interpolate at 255
+
+    // Estimate the frame's current from its wire channel sums and scale it to the budget
+    template <EOrder Order>
+    void limitCurrent(CRGB* out, const uint32_t* wireSums, uint16_t numLeds) {
+        uint32_t sums[3];  // Red, green, blue
+        sums[(Order >> 6) & 0x3] = wireSums[0];
+        sums[(Order >> 3) & 0x3] = wireSums[1];
+        sums[Order & 0x3] = wireSums[2];
+        estimatedMa = estimateMa(sums[0], sums[1], sums[2], numLeds);
+        outputMa = estimatedMa;
+        if (budgetMa == 0 || estimatedMa <= budgetMa) {
+            return;
+        }
+
+        // Only the active part scales; the idle current is fixed
+        uint32_t idleMa = (uint32_t)numLeds * power.idleMa;
+        uint32_t factor = budgetMa > idleMa ? ((budgetMa - idleMa) << 8) / (estimatedMa - idleMa) : 0;
+        if (factor == 0) {
+            memset(out, 0, numLeds * sizeof(CRGB));
+        } else {
+            pixelScale(out, out, (uint8_t)(factor - 1), numLeds);  // v * factor / 256
+        }
+        outputMa = idleMa + (((estimatedMa - idleMa) * factor) >> 8);
+        framesLimited++;
+    }
+
+    void buildTable() {
+        for (uint16_t v = 0; v < 256; v++) {
+            float level = gamma == 1.0f ? v / 255.0f : powf(v / 255.0f, gamma);
+            table[v] = (uint8_t)(level * brightness + 0.5f);
+            table16[v] = (uint16_t)(level * brightness * 256 + 0.5f);
+            scales[v] = gamma == 1.0f ? v : (uint8_t)(powf(v / 255.0f, 1.0f / gamma) * 255 + 0.5f);
+        }
+        table16[256] = table16[255];
+    }
+};
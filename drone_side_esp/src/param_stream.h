@@ -0,0 +1,122 @@
+#pragma once
+
+#include <FastLED.h>
+#include "metrics.h"
+
+// Parameter streaming configuration
+#define PARAM_STREAM_TIMEOUT_US 1000000  // Stream considered stopped after 1 s without samples
+#define PARAM_INTERVAL_MIN_US 5000       // 200 Hz
+#define PARAM_INTERVAL_MAX_US 20000      // 50 Hz
+
+// Continuous BRAINWAVE parameters driven by the BCI
+struct StreamParams {
+    uint8_t hueShift;   // Gradient offset (wraps)
+    uint8_t intensity;  // Brightness scale
+    uint16_t speed;     // Milliseconds per gradient step
+};
+
+// Ramp from the displayed value towards the latest sample
+struct ParamRamp {
+    StreamParams from;
+    StreamParams target;
+    uint32_t rampStartUs;
+    uint32_t intervalUs;
+    uint32_t lastArrivalUs;
+    bool hasSample;
+};
+
+// Smooths jittered, lossy parameter samples into per-frame values.
+// Each new sample starts a ramp from the currently displayed value to the sample,
+// lasting one estimated sample interval. The interval is estimated from the
+// sender's timestamps, so radio jitter does not change the ramp speed, and a
+// lost sample simply holds the last target instead of jumping.
+// pushSample() runs in the WiFi task and valueAt() in the main loop; the ramp
+// is published through a SeqLock so a frame never sees half of a new sample.
+class ParamInterpolator {
+public:
+    ParamInterpolator() : ramp{{0, 255, 0}, {0, 255, 0}, 0, PARAM_INTERVAL_MAX_US, 0, false},
+                          published(ramp), lastSequence(0), lastSampleTimeUs(0) {}
+
+    void pushSample(const StreamParams& params, uint16_t sequence, uint32_t sampleTimeUs, uint32_t nowUs) {
+        if (!ramp.hasSample) {
+            ramp.from = params;
+        } else if (!isActive(ramp, nowUs)) {
+            // Stream restarted (possibly with a new sequence): ramp from the held value
+            ramp.from = ramp.target;
+        } else {
+            int16_t seqDelta = (int16_t)(sequence - lastSequence);
+            if (seqDelta <= 0) {
+                samplesOutOfOrder++;
+                return;
+            }
+            if (seqDelta > 1) {
+                samplesLost += seqDelta - 1;
+            }
+
+            // Exponentially smoothed sample interval from sender timestamps
+            uint32_t interval = (sampleTimeUs - lastSampleTimeUs) / seqDelta;
+            interval = constrain(interval, (uint32_t)PARAM_INTERVAL_MIN_US, (uint32_t)PARAM_INTERVAL_MAX_US);
+            ramp.intervalUs = (ramp.intervalUs * 7 + interval) / 8;
+
+            // Continue from what is currently displayed so there is no jump
+            ramp.from = valueAt(ramp, nowUs);
+        }
+
+        ramp.target = params;
+        ramp.rampStartUs = nowUs;
+        ramp.lastArrivalUs = nowUs;
+        ramp.hasSample = true;
+        published.write(ramp);
+        lastSequence = sequence;
+        lastSampleTimeUs = sampleTimeUs;
+        samplesReceived++;
+    }
+
+    // Interpolated parameters for a frame rendered at nowUs
+    StreamParams valueAt(uint32_t nowUs) const {
+        return valueAt(published.read(), nowUs);
+    }
+
+    bool isActive(uint32_t nowUs) const {
+        return isActive(published.read(), nowUs);
+    }
+
+    uint32_t getSamplesReceived() const { return samplesReceived; }
+    uint32_t getSamplesLost() const { return samplesLost; }
+    uint32_t getSamplesOutOfOrder() const { return samplesOutOfOrder; }
+    uint32_t getIntervalUs() const { return published.read().intervalUs; }
+
+private:
+    // Writer side, only touched by pushSample()
+    ParamRamp ramp;
+    SeqLock<ParamRamp> published;
+    uint16_t lastSequence;
+    uint32_t lastSampleTimeUs;
+
+    MetricCounter samplesReceived;
+    MetricCounter samplesLost;
+    MetricCounter samplesOutOfOrder;
+
+    static StreamParams valueAt(const ParamRamp& ramp, uint32_t nowUs) {
+        uint32_t elapsed = nowUs - ramp.rampStartUs;
+        if (elapsed >= ramp.intervalUs) {
+            return ramp.target;
+        }
+
+        uint8_t frac = (elapsed * 256) / ramp.intervalUs;
+        const StreamParams& from = ramp.from;
+        const StreamParams& target = ramp.target;
+
+        StreamParams result;
+        // Hue takes the shortest way around the wheel
+        int8_t hueDelta = (int8_t)(target.hueShift - from.hueShift);
+        result.hueShift = from.hueShift + (int16_t)hueDelta * frac / 256;
+        result.intensity = lerp8by8(from.intensity, target.intensity, frac);
+        result.speed = from.speed + ((int32_t)target.speed - from.speed) * frac / 256;
+        return result;
+    }
+
+    static bool isActive(const ParamRamp& ramp, uint32_t nowUs) {
+        return ramp.hasSample && (nowUs - ramp.lastArrivalUs) < PARAM_STREAM_TIMEOUT_US;
+    }
+};
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <FastLED.h>
+#include "flow_renderer.h"
+#include "pixel_kernels.h"
+
+// Flow pattern geometry
+#define FLOW_GAP_STEPS 10  // Extra steps per sweep so the comet fully leaves the strip
+#define FLOW_TAIL_LENGTH 10
+
+// BRAINWAVE pixels handled per palette lookup
+#define BRAINWAVE_CHUNK_LEDS 32
+
+// Per-frame inputs to a pattern renderer
+struct PatternRenderContext {
+    CRGB color;
+    uint32_t phase;      // Animation phase, 2^32 = one cycle
+    uint8_t hueShift;    // BRAINWAVE gradient offset
+    uint8_t intensity;   // BRAINWAVE brightness scale
+    const LedPoint* points;  // Coordinates of each LED, or nullptr for a straight strip
+    uint16_t pitch256;       // Height between neighbouring LEDs in points, 1/256 units
+};
+
+// Draws one frame of a pattern into out[0 .. numLeds)
+typedef void (*PatternRenderFn)(CRGB* out, uint16_t numLeds, const PatternRenderContext& ctx);
+
+inline void renderStatic(CRGB* out, uint16_t numLeds, const PatternRenderContext& ctx) {
+    pixelFill(out, ctx.color, numLeds);
+}
+
+inline void renderBlink(CRGB* out, uint16_t numLeds, const PatternRenderContext& ctx) {
+    // On during the first half of the cycle
+    if (ctx.phase < 0x80000000UL) {
+        pixelFill(out, ctx.color, numLeds);
+    } else {
+        pixelFill(out, CRGB(0, 0, 0), numLeds);
+    }
+}
+
+// Comet head position for the phase, in 1/256 LED
+inline uint32_t flowHead8(uint16_t numLeds, uint32_t phase) {
+    return (uint32_t)(((uint64_t)phase * (numLeds + FLOW_GAP_STEPS)) >> 24);
+}
+
+// Draw the flow comet along the strip, or through space when the layout gives
+// coordinates. The spatial tail covers the same share of the height as
+// FLOW_TAIL_LENGTH does of the strip.
+inline void renderFlow(CRGB* out, uint16_t numLeds, const PatternRenderContext& ctx, bool reverse) {
+    if (ctx.points == nullptr) {
+        renderComet(out, numLeds, ctx.color, flowHead8(numLeds, ctx.phase), FLOW_TAIL_LENGTH, reverse);
+        return;
+    }
+    uint8_t tailSpan = min(255, FLOW_TAIL_LENGTH * 256 / numLeds);
+    uint32_t head8 = (uint32_t)(((uint64_t)ctx.phase * (256 + tailSpan)) >> 24);
+    renderSweep(out, numLeds, ctx.points, ctx.color, head8, tailSpan, ctx.pitch256, reverse);
+}
+
+inline void renderFlowUp(CRGB* out, uint16_t numLeds, const PatternRenderContext& ctx) {
+    // Clear all LEDs
+    pixelFill(out, CRGB(0, 0, 0), numLeds);
+
+    // Draw flowing pattern (bottom to top) at a sub-LED head position
+    renderFlow(out, numLeds, ctx, false);
+}
+
+inline void renderFlowDown(CRGB* out, uint16_t numLeds, const PatternRenderContext& ctx) {
+    // Clear all LEDs
+    pixelFill(out, CRGB(0, 0, 0), numLeds);
+
+    // Draw flowing pattern (top to bottom) at a sub-LED head position
+    renderFlow(out, numLeds, ctx, true);
+}
+
+// Flowing brainwave gradient: Blue → Purple → Pink → Blue, indexed by gradient position
+struct BrainwavePalette {
+    CRGB colors[256];
+
+    BrainwavePalette() {
+        for (uint16_t gradientPos = 0; gradientPos < 256; gradientPos++) {
+            // Create smooth gradient: Blue (0-85) → Purple (86-170) → Pink (171-255)
+            if (gradientPos < 85) {
+                // Blue to Purple transition
+                uint8_t progress = (gradientPos * 3);
+                colors[gradientPos] = CRGB(
+                    progress,           // R: 0 → 255
+                    progress / 2,       // G: 0 → 127
+                    255                 // B: constant blue
+                );
+            } else if (gradientPos < 170) {
+                // Purple to Pink transition
+                uint8_t progress = ((gradientPos - 85) * 3);
+                colors[gradientPos] = CRGB(
+                    255,                // R: constant red
+                    127 - progress / 2, // G: 127 → 0
+                    255 - progress      // B: 255 → 0
+                );
+            } else {
+                // Pink back to Blue transition
+                uint8_t progress = ((gradientPos - 170) * 3);
+                colors[gradientPos] = CRGB(
+                    255 - progress,     // R: 255 → 0
+                    0,                  // G: constant 0
+                    progress            // B: 0 → 255
+                );
+            }
+        }
+    }
+};
+
+inline const CRGB* brainwavePalette() {
+    static const BrainwavePalette palette;  // Built on first use
+    return palette.colors;
+}
+
+// BRAINWAVE palette with the wave modulation folded in for one animation step:
+// entry g is the gradient color at g scaled by 0.4-1.0 along a sine of g + step,
+// two waves across the gradient. Rebuilt only when the step changes, so each
+// pixel costs one palette lookup and the intensity is a uniform scale.
+struct BrainwaveWavePalette {
+    CRGB colors[256];
+    int16_t step;
+
+    BrainwaveWavePalette() : step(-1) {}
+
+    const CRGB* forStep(uint8_t newStep) {
+        if (step != newStep) {
+            const CRGB* gradient = brainwavePalette();
+            for (uint16_t gradientPos = 0; gradientPos < 256; gradientPos++) {
+                uint8_t wave = 102 + scale8(sin8((gradientPos + newStep) * 2), 151);  // 0.4-1.0
+                colors[gradientPos] = gradient[gradientPos];
+                colors[gradientPos].nscale8(wave);
+            }
+            step = newStep;
+        }
+        return colors;
+    }
+};
+
+inline const CRGB* brainwaveWavePalette(uint8_t step) {
+    static BrainwaveWavePalette palette;
+    return palette.forStep(step);
+}
+
+inline void renderBrainwave(CRGB* out, uint16_t numLeds, const PatternRenderContext& ctx) {
+    uint8_t currentStep = ctx.phase >> 24;
+    uint8_t hueShift = ctx.hueShift;
+    uint8_t intensity = ctx.intensity;
+    // Wave modulation for the "brainwave" effect: pulsing intensity like neural activity
+    const CRGB* palette = brainwaveWavePalette(currentStep);
+
+    // This visualizes BCI (Brain-Computer Interface) control
+    uint8_t gradientPos[BRAINWAVE_CHUNK_LEDS];
+    for (uint16_t start = 0; start < numLeds; start += BRAINWAVE_CHUNK_LEDS) {
+        uint16_t count = numLeds - start < BRAINWAVE_CHUNK_LEDS ? numLeds - start : BRAINWAVE_CHUNK_LEDS;
+
+        // Calculate position in gradient (0-255) with wave offset
+        for (uint16_t j = 0; j < count; j++) {
+            gradientPos[j] = (currentStep + hueShift + ((start + j) * 256 / numLeds)) % 256;
+        }
+        pixelPalette(out + start, gradientPos, palette, count);
+        pixelScale(out + start, out + start, intensity, count);
+    }
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <Arduino.h>
+#include "patterns.h"
+#include "animation_timing.h"
+
+// Priority levels, lowest to highest. The highest active level is displayed.
+#define PRIORITY_LEVELS 3
+enum class PatternPriority : uint8_t {
+    NORMAL,   // Flight state (always present)
+    HIGH,     // Temporary indications
+    CRITICAL  // EMERGENCY
+};
+
+// Longest TTL: the stack times patterns with 32-bit microseconds, which wrap
+// after about 71 minutes. Longer TTLs are clamped to it.
+#define PATTERN_TTL_MAX_MS (UINT32_MAX / 1000)
+
+// How an LED command is placed on the priority stack
+struct PrioritySettings {
+    PatternPriority priority;
+    uint32_t ttlMs;  // 0 = until cleared, at most PATTERN_TTL_MAX_MS
+    bool clear;      // Remove the pattern at this priority instead of setting one
+    bool implicit;   // No priority in the command: defaultPriority() of the pattern
+};
+
+// Priority a pattern gets when the command does not specify one
+inline PatternPriority defaultPriority(LedPattern pattern) {
+    return pattern == LedPattern::EMERGENCY ? PatternPriority::CRITICAL : PatternPriority::NORMAL;
+}
+
+// Pattern and animation state held at one priority level
+struct PatternSlot {
+    PatternConfig config;
+    PhaseAccumulator animation;
+    uint32_t startUs;
+    uint32_t ttlUs;  // 0 = no expiry
+    bool active;
+    bool implicit;   // Set without an explicit priority
+};
+
+// One pattern per priority level. Higher levels preempt lower ones, optionally
+// for a limited time; lower levels keep their config and animation phase while
+// covered, so they can be restored locally when the preempting pattern expires
+// or is cleared, without the ground resending them.
+class PatternStack {
+public:
+    PatternStack() : preemptions(0), restores(0), expirations(0) {
+        for (uint8_t i = 0; i < PRIORITY_LEVELS; i++) {
+            slots[i].config = PatternDefaults::getDefault(LedPattern::IDLE);
+            slots[i].startUs = 0;
+            slots[i].ttlUs = 0;
+            slots[i].implicit = false;
+            slots[i].active = (i == (uint8_t)PatternPriority::NORMAL);
+        }
+    }
+
+    // Set the pattern at a priority level, restarting its animation.
+    // The NORMAL level never expires; ttlMs is clamped to PATTERN_TTL_MAX_MS.
+    // implicit records that the command gave no priority (see PatternSlot).
+    void set(PatternPriority priority, const PatternConfig& config, uint32_t ttlMs, uint32_t animationPeriodUs,
+             uint32_t nowUs, bool implicit = false) {
+        uint8_t level = (uint8_t)priority;
+        if (level > topLevel()) {
+            preemptions++;
+        }
+
+        PatternSlot& slot = slots[level];
+        slot.config = config;
+        slot.animation.setPeriod(animationPeriodUs);
+        slot.animation.reset(nowUs);
+        slot.startUs = nowUs;
+        if (ttlMs > PATTERN_TTL_MAX_MS) {
+            ttlMs = PATTERN_TTL_MAX_MS;
+        }
+        slot.ttlUs = (priority == PatternPriority::NORMAL) ? 0 : ttlMs * 1000;
+        slot.implicit = implicit;
+        slot.active = true;
+    }
+
+    // Remove the pattern at a priority level (NORMAL cannot be cleared)
+    void clear(PatternPriority priority) {
+        uint8_t level = (uint8_t)priority;
+        if (level == (uint8_t)PatternPriority::NORMAL || !slots[level].active) {
+            return;
+        }
+        if (level == topLevel()) {
+            restores++;
+        }
+        slots[level].active = false;
+    }
+
+    // Drop patterns whose TTL has run out
+    void expire(uint32_t nowUs) {
+        for (uint8_t level = 1; level < PRIORITY_LEVELS; level++) {
+            PatternSlot& slot = slots[level];
+            if (slot.active && slot.ttlUs != 0 && nowUs - slot.startUs >= slot.ttlUs) {
+                if (level == topLevel()) {
+                    restores++;
+                }
+                slot.active = false;
+                expirations++;
+            }
+        }
+    }
+
+    // Highest active priority level
+    uint8_t topLevel() const {
+        for (uint8_t level = PRIORITY_LEVELS - 1; level > 0; level--) {
+            if (slots[level].active) {
+                return level;
+            }
+        }
+        return 0;
+    }
+
+    PatternSlot& slot(uint8_t level) {
+        return slots[level];
+    }
+
+    const PatternSlot& slot(uint8_t level) const {
+        return slots[level];
+    }
+
+    uint32_t getPreemptions() const { return preemptions; }
+    uint32_t getRestores() const { return restores; }
+    uint32_t getExpirations() const { return expirations; }
+
+private:
+    PatternSlot slots[PRIORITY_LEVELS];
+
+    // Statistics
+    uint32_t preemptions;
+    uint32_t restores;
+    uint32_t expirations;
+};
+
+// Convert string to PatternPriority (unknown names select NORMAL)
+inline PatternPriority stringToPriority(const char* str) {
+    if (str && strcmp(str, "HIGH") == 0) return PatternPriority::HIGH;
+    if (str && strcmp(str, "CRITICAL") == 0) return PatternPriority::CRITICAL;
+    return PatternPriority::NORMAL;
+}
+
+// Convert PatternPriority to string
+inline const char* priorityToString(PatternPriority priority) {
+    switch (priority) {
+        case PatternPriority::NORMAL: return "NORMAL";
+        case PatternPriority::HIGH: return "HIGH";
+        case PatternPriority::CRITICAL: return "CRITICAL";
+        default: return "UNKNOWN";
+    }
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <Arduino.h>
+#include <FastLED.h>
+#include "pattern_renderers.h"
 
 // LED Pattern Types
 enum class LedPattern {
@@ -14,6 +16,8 @@ enum class LedPattern {
     BRAINWAVE       // BCI control: flowing blue-purple-pink gradient (brainwave visualization)
 };
 
+constexpr uint8_t PATTERN_COUNT = 8;  // Number of LedPattern values
+
 // Pattern Configuration
 struct PatternConfig {
     LedPattern pattern;
@@ -41,56 +45,165 @@ namespace PatternDefaults {
     constexpr uint16_t SPEED_FAST_BLINK = 200;
     constexpr uint16_t SPEED_FLOW = 100;
     constexpr uint16_t SPEED_BRAINWAVE = 50;  // Fast flowing for brainwave effect
+}
+
+// How a pattern's speed maps to its animation cycle
+enum class PatternTiming : uint8_t {
+    STATIC,    // No animation
+    BLINK,     // speed = on time = off time
+    SWEEP,     // speed = one full sweep including the gap
+    GRADIENT   // speed = one of 256 gradient steps
+};
+
+// Registry entry: everything needed to parse, configure and draw a pattern
+struct PatternInfo {
+    const char* name;
+    PatternConfig defaults;
+    PatternTiming timing;
+    PatternRenderFn render;  // nullptr = stripped from this build
+};
+
+// Build with -DDISABLE_PATTERN_<NAME> to leave a pattern's renderer out of the
+// firmware. Disabled patterns are treated as unknown names and render as IDLE.
+#ifdef DISABLE_PATTERN_TAKING_OFF
+#define RENDER_TAKING_OFF nullptr
+#else
+#define RENDER_TAKING_OFF renderFlowUp
+#endif
+#ifdef DISABLE_PATTERN_HOVERING
+#define RENDER_HOVERING nullptr
+#else
+#define RENDER_HOVERING renderBlink
+#endif
+#ifdef DISABLE_PATTERN_FLYING
+#define RENDER_FLYING nullptr
+#else
+#define RENDER_FLYING renderBlink
+#endif
+#ifdef DISABLE_PATTERN_LANDING
+#define RENDER_LANDING nullptr
+#else
+#define RENDER_LANDING renderFlowDown
+#endif
+#ifdef DISABLE_PATTERN_EMERGENCY
+#define RENDER_EMERGENCY nullptr
+#else
+#define RENDER_EMERGENCY renderBlink
+#endif
+#ifdef DISABLE_PATTERN_LOW_BATTERY
+#define RENDER_LOW_BATTERY nullptr
+#else
+#define RENDER_LOW_BATTERY renderBlink
+#endif
+#ifdef DISABLE_PATTERN_BRAINWAVE
+#define RENDER_BRAINWAVE nullptr
+#else
+#define RENDER_BRAINWAVE renderBrainwave
+#endif
+
+// All patterns, indexed by LedPattern. Adding a pattern is one enum value and one row here.
+constexpr PatternInfo PATTERN_REGISTRY[] = {
+    {"IDLE", {LedPattern::IDLE, PatternDefaults::COLOR_BLUE, PatternDefaults::DEFAULT_BRIGHTNESS,
+              PatternDefaults::SPEED_STATIC}, PatternTiming::STATIC, renderStatic},
+    {"TAKING_OFF", {LedPattern::TAKING_OFF, PatternDefaults::COLOR_GREEN, PatternDefaults::DEFAULT_BRIGHTNESS,
+                    PatternDefaults::SPEED_FLOW}, PatternTiming::SWEEP, RENDER_TAKING_OFF},
+    {"HOVERING", {LedPattern::HOVERING, PatternDefaults::COLOR_GREEN, PatternDefaults::DEFAULT_BRIGHTNESS,
+                  PatternDefaults::SPEED_SLOW_BLINK}, PatternTiming::BLINK, RENDER_HOVERING},
+    {"FLYING", {LedPattern::FLYING, PatternDefaults::COLOR_WHITE, PatternDefaults::DEFAULT_BRIGHTNESS,
+                PatternDefaults::SPEED_FAST_BLINK}, PatternTiming::BLINK, RENDER_FLYING},
+    {"LANDING", {LedPattern::LANDING, PatternDefaults::COLOR_YELLOW, PatternDefaults::DEFAULT_BRIGHTNESS,
+                 PatternDefaults::SPEED_FLOW}, PatternTiming::SWEEP, RENDER_LANDING},
+    {"EMERGENCY", {LedPattern::EMERGENCY, PatternDefaults::COLOR_RED, PatternDefaults::DEFAULT_BRIGHTNESS,
+                   PatternDefaults::SPEED_FAST_BLINK}, PatternTiming::BLINK, RENDER_EMERGENCY},
+    {"LOW_BATTERY", {LedPattern::LOW_BATTERY, PatternDefaults::COLOR_ORANGE, PatternDefaults::DEFAULT_BRIGHTNESS,
+                     PatternDefaults::SPEED_SLOW_BLINK}, PatternTiming::BLINK, RENDER_LOW_BATTERY},
+    {"BRAINWAVE", {LedPattern::BRAINWAVE, PatternDefaults::COLOR_CYAN_BLUE, 180,  // Brighter for BCI visibility
+                   PatternDefaults::SPEED_BRAINWAVE}, PatternTiming::GRADIENT, RENDER_BRAINWAVE},
+};
 
+constexpr bool registryInOrder(uint8_t index = 0) {
+    return index >= PATTERN_COUNT ||
+           ((uint8_t)PATTERN_REGISTRY[index].defaults.pattern == index && registryInOrder(index + 1));
+}
+static_assert(sizeof(PATTERN_REGISTRY) / sizeof(PATTERN_REGISTRY[0]) == PATTERN_COUNT,
+              "PATTERN_REGISTRY needs one entry per LedPattern");
+static_assert(registryInOrder(), "PATTERN_REGISTRY must be in LedPattern order");
+
+// Registry entry for a pattern (IDLE for out-of-range or disabled patterns)
+inline const PatternInfo& patternInfo(LedPattern pattern) {
+    uint8_t index = (uint8_t)pattern;
+    if (index >= PATTERN_COUNT || !PATTERN_REGISTRY[index].render) {
+        index = (uint8_t)LedPattern::IDLE;
+    }
+    return PATTERN_REGISTRY[index];
+}
+
+namespace PatternDefaults {
     // Get default config for a pattern
     inline PatternConfig getDefault(LedPattern pattern) {
-        switch (pattern) {
-            case LedPattern::IDLE:
-                return {pattern, COLOR_BLUE, DEFAULT_BRIGHTNESS, SPEED_STATIC};
-            case LedPattern::TAKING_OFF:
-                return {pattern, COLOR_GREEN, DEFAULT_BRIGHTNESS, SPEED_FLOW};
-            case LedPattern::HOVERING:
-                return {pattern, COLOR_GREEN, DEFAULT_BRIGHTNESS, SPEED_SLOW_BLINK};
-            case LedPattern::FLYING:
-                return {pattern, COLOR_WHITE, DEFAULT_BRIGHTNESS, SPEED_FAST_BLINK};
-            case LedPattern::LANDING:
-                return {pattern, COLOR_YELLOW, DEFAULT_BRIGHTNESS, SPEED_FLOW};
-            case LedPattern::EMERGENCY:
-                return {pattern, COLOR_RED, DEFAULT_BRIGHTNESS, SPEED_FAST_BLINK};
-            case LedPattern::LOW_BATTERY:
-                return {pattern, COLOR_ORANGE, DEFAULT_BRIGHTNESS, SPEED_SLOW_BLINK};
-            case LedPattern::BRAINWAVE:
-                return {pattern, COLOR_CYAN_BLUE, 180, SPEED_BRAINWAVE};  // Brighter for BCI visibility
-            default:
-                return {LedPattern::IDLE, COLOR_BLUE, DEFAULT_BRIGHTNESS, SPEED_STATIC};
-        }
+        return patternInfo(pattern).defaults;
     }
 }
 
-// Convert string to LedPattern
+// Perfect hash over pattern names: length and first character select a unique
+// slot, so a lookup is one hash and at most one string compare.
+#define PATTERN_HASH_SIZE 16      // Power of two
+#define PATTERN_NAME_MAX 16       // Longer names are never valid
+#define PATTERN_HASH_EMPTY 0xFF
+
+constexpr uint8_t patternNameHash(uint8_t length, char first) {
+    return (uint8_t)(length * 9 + (uint8_t)first) & (PATTERN_HASH_SIZE - 1);
+}
+
+constexpr uint8_t constexprLength(const char* str) {
+    return *str ? 1 + constexprLength(str + 1) : 0;
+}
+
+constexpr uint8_t registryNameHash(uint8_t index) {
+    return patternNameHash(constexprLength(PATTERN_REGISTRY[index].name), PATTERN_REGISTRY[index].name[0]);
+}
+
+// Registry index of the enabled pattern hashing to slot, or PATTERN_HASH_EMPTY
+constexpr uint8_t patternHashSlot(uint8_t slot, uint8_t index = 0) {
+    return index >= PATTERN_COUNT ? PATTERN_HASH_EMPTY
+           : (PATTERN_REGISTRY[index].render && registryNameHash(index) == slot) ? index
+           : patternHashSlot(slot, index + 1);
+}
+
+// True if no two registry names share a hash slot
+constexpr bool patternHashIsPerfect(uint8_t i = 0, uint8_t j = 1) {
+    return i >= PATTERN_COUNT ? true
+           : j >= PATTERN_COUNT ? patternHashIsPerfect(i + 1, i + 2)
+           : registryNameHash(i) != registryNameHash(j) && patternHashIsPerfect(i, j + 1);
+}
+static_assert(patternHashIsPerfect(), "Pattern names collide in patternNameHash; change the multiplier");
+
+constexpr uint8_t PATTERN_HASH_TABLE[PATTERN_HASH_SIZE] = {
+    patternHashSlot(0), patternHashSlot(1), patternHashSlot(2), patternHashSlot(3),
+    patternHashSlot(4), patternHashSlot(5), patternHashSlot(6), patternHashSlot(7),
+    patternHashSlot(8), patternHashSlot(9), patternHashSlot(10), patternHashSlot(11),
+    patternHashSlot(12), patternHashSlot(13), patternHashSlot(14), patternHashSlot(15),
+};
+
+// Convert string to LedPattern (unknown names and nullptr give IDLE)
 inline LedPattern stringToPattern(const char* str) {
-    if (strcmp(str, "IDLE") == 0) return LedPattern::IDLE;
-    if (strcmp(str, "TAKING_OFF") == 0) return LedPattern::TAKING_OFF;
-    if (strcmp(str, "HOVERING") == 0) return LedPattern::HOVERING;
-    if (strcmp(str, "FLYING") == 0) return LedPattern::FLYING;
-    if (strcmp(str, "LANDING") == 0) return LedPattern::LANDING;
-    if (strcmp(str, "EMERGENCY") == 0) return LedPattern::EMERGENCY;
-    if (strcmp(str, "LOW_BATTERY") == 0) return LedPattern::LOW_BATTERY;
-    if (strcmp(str, "BRAINWAVE") == 0) return LedPattern::BRAINWAVE;
-    return LedPattern::IDLE;
+    if (!str) {
+        return LedPattern::IDLE;
+    }
+    size_t length = strnlen(str, PATTERN_NAME_MAX);
+    if (length == 0 || length >= PATTERN_NAME_MAX) {
+        return LedPattern::IDLE;
+    }
+
+    uint8_t index = PATTERN_HASH_TABLE[patternNameHash(length, str[0])];
+    if (index == PATTERN_HASH_EMPTY || strcmp(str, PATTERN_REGISTRY[index].name) != 0) {
+        return LedPattern::IDLE;
+    }
+    return (LedPattern)index;
 }
 
 // Convert LedPattern to string
 inline const char* patternToString(LedPattern pattern) {
-    switch (pattern) {
-        case LedPattern::IDLE: return "IDLE";
-        case LedPattern::TAKING_OFF: return "TAKING_OFF";
-        case LedPattern::HOVERING: return "HOVERING";
-        case LedPattern::FLYING: return "FLYING";
-        case LedPattern::LANDING: return "LANDING";
-        case LedPattern::EMERGENCY: return "EMERGENCY";
-        case LedPattern::LOW_BATTERY: return "LOW_BATTERY";
-        case LedPattern::BRAINWAVE: return "BRAINWAVE";
-        default: return "UNKNOWN";
-    }
+    uint8_t index = (uint8_t)pattern;
+    return index < PATTERN_COUNT ? PATTERN_REGISTRY[index].name : "UNKNOWN";
 }
@@ -0,0 +1,390 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Inner loops of rendering, compositing and transitions. Every kernel works on
+// the strip as a flat array of channel bytes and produces exactly the bytes of
+// the FastLED per-pixel operation it replaces (fill_solid, nscale8, blend, +=).
+//
+// Variants, selected at compile time:
+//   Scalar - reference implementation, one byte at a time
+//   Swar   - four channels per 32-bit word; used on the ESP32-S3 and any other target
+//   Sse2   - 16 channels per instruction (host simulation)
+//   Avx2   - 32 channels per instruction (host, built with -mavx2)
+// Build with -DPIXEL_KERNELS_SCALAR or -DPIXEL_KERNELS_SWAR to force a variant.
+// Palette lookup is a gather, which none of these instruction sets has for bytes,
+// so every variant uses the scalar loop for it.
+// Kept free of Arduino headers so the native tests can check every variant.
+namespace PixelKernels {
+
+// FastLED's scale8 with FASTLED_SCALE8_FIXED: 255 leaves the value unchanged
+inline uint8_t scaleByte(uint8_t value, uint8_t scale) {
+    return (uint8_t)(((uint16_t)value * (1 + (uint16_t)scale)) >> 8);
+}
+
+// FastLED's blend8 with FASTLED_BLEND_FIXED: 0 gives a, 255 gives b
+inline uint8_t blendByte(uint8_t a, uint8_t b, uint8_t amountOfB) {
+    return (uint8_t)(((uint16_t)a * (256 - amountOfB) + (uint16_t)b * (1 + amountOfB)) >> 8);
+}
+
+inline uint8_t addByte(uint8_t a, uint8_t b) {
+    uint16_t sum = (uint16_t)a + b;
+    return sum > 255 ? 255 : (uint8_t)sum;
+}
+
+namespace Scalar {
+    inline void fill(uint8_t* out, const uint8_t* rgb, size_t pixels) {
+        for (size_t i = 0; i < pixels; i++) {
+            out[i * 3] = rgb[0];
+            out[i * 3 + 1] = rgb[1];
+            out[i * 3 + 2] = rgb[2];
+        }
+    }
+
+    inline void scale(uint8_t* out, const uint8_t* in, uint8_t scale, size_t bytes) {
+        for (size_t i = 0; i < bytes; i++) {
+            out[i] = scaleByte(in[i], scale);
+        }
+    }
+
+    inline void blend(uint8_t* out, const uint8_t* a, const uint8_t* b, uint8_t amountOfB, size_t bytes) {
+        for (size_t i = 0; i < bytes; i++) {
+            out[i] = blendByte(a[i], b[i], amountOfB);
+        }
+    }
+
+    inline void addSaturate(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t bytes) {
+        for (size_t i = 0; i < bytes; i++) {
+            out[i] = addByte(a[i], b[i]);
+        }
+    }
+
+    // out[i] = palette[indices[i]], palette holding 256 RGB entries
+    inline void palette(uint8_t* out, const uint8_t* indices, const uint8_t* palette, size_t pixels) {
+        for (size_t i = 0; i < pixels; i++) {
+            const uint8_t* entry = palette + indices[i] * 3;
+            out[i * 3] = entry[0];
+            out[i * 3 + 1] = entry[1];
+            out[i * 3 + 2] = entry[2];
+        }
+    }
+}
+
+namespace Swar {
+    typedef uint32_t __attribute__((may_alias)) Word;
+
+    static constexpr uint32_t EVEN_BYTES = 0x00FF00FFUL;
+    static constexpr uint32_t HIGH_BITS = 0x80808080UL;
+
+    // Bytes before the first word boundary of out
+    inline size_t headBytes(const uint8_t* out, size_t bytes) {
+        size_t head = (4 - ((uintptr_t)out & 3)) & 3;
+        return head < bytes ? head : bytes;
+    }
+
+    // Word access needs every pointer at the same offset within a word
+    inline bool sameAlignment(const void* a, const void* b) {
+        return (((uintptr_t)a ^ (uintptr_t)b) & 3) == 0;
+    }
+
+    // Each byte times (scale + 1), in two sets of 16-bit lanes
+    inline uint32_t scaleWord(uint32_t word, uint32_t factor) {
+        uint32_t even = ((word & EVEN_BYTES) * factor >> 8) & EVEN_BYTES;
+        uint32_t odd = ((word >> 8) & EVEN_BYTES) * factor & ~EVEN_BYTES;
+        return even | odd;
+    }
+
+    inline uint32_t blendWord(uint32_t a, uint32_t b, uint32_t weightA, uint32_t weightB) {
+        uint32_t even = (((a & EVEN_BYTES) * weightA + (b & EVEN_BYTES) * weightB) >> 8) & EVEN_BYTES;
+        uint32_t odd = (((a >> 8) & EVEN_BYTES) * weightA + ((b >> 8) & EVEN_BYTES) * weightB) & ~EVEN_BYTES;
+        return even | odd;
+    }
+
+    // Per-byte add, saturating each byte whose top bit carried out
+    inline uint32_t addWord(uint32_t a, uint32_t b) {
+        uint32_t low = (a & ~HIGH_BITS) + (b & ~HIGH_BITS);
+        uint32_t sum = low ^ ((a ^ b) & HIGH_BITS);
+        uint32_t carry = ((a & b) | ((a | b) & ~sum)) & HIGH_BITS;
+        return sum | ((carry >> 7) * 0xFF);
+    }
+
+    inline void fill(uint8_t* out, const uint8_t* rgb, size_t pixels) {
+        size_t bytes = pixels * 3;
+        size_t head = headBytes(out, bytes);
+        for (size_t i = 0; i < head; i++) {
+            out[i] = rgb[i % 3];
+        }
+
+        // Three words repeat the color every 12 bytes
+        uint8_t pattern[12];
+        for (size_t i = 0; i < 12; i++) {
+            pattern[i] = rgb[(head + i) % 3];
+        }
+        uint32_t words[3];
+        memcpy(words, pattern, sizeof(words));
+
+        size_t i = head;
+        for (; i + 12 <= bytes; i += 12) {
+            Word* dst = (Word*)(out + i);
+            dst[0] = words[0];
+            dst[1] = words[1];
+            dst[2] = words[2];
+        }
+        for (; i < bytes; i++) {
+            out[i] = rgb[i % 3];
+        }
+    }
+
+    inline void scale(uint8_t* out, const uint8_t* in, uint8_t scale, size_t bytes) {
+        if (!sameAlignment(out, in)) {
+            Scalar::scale(out, in, scale, bytes);
+            return;
+        }
+        size_t i = headBytes(out, bytes);
+        Scalar::scale(out, in, scale, i);
+        uint32_t factor = 1 + (uint32_t)scale;
+        for (; i + 4 <= bytes; i += 4) {
+            *(Word*)(out + i) = scaleWord(*(const Word*)(in + i), factor);
+        }
+        Scalar::scale(out + i, in + i, scale, bytes - i);
+    }
+
+    inline void blend(uint8_t* out, const uint8_t* a, const uint8_t* b, uint8_t amountOfB, size_t bytes) {
+        if (!sameAlignment(out, a) || !sameAlignment(out, b)) {
+            Scalar::blend(out, a, b, amountOfB, bytes);
+            return;
+        }
+        size_t i = headBytes(out, bytes);
+        Scalar::blend(out, a, b, amountOfB, i);
+        uint32_t weightA = 256 - (uint32_t)amountOfB;
+        uint32_t weightB = 1 + (uint32_t)amountOfB;
+        for (; i + 4 <= bytes; i += 4) {
+            *(Word*)(out + i) = blendWord(*(const Word*)(a + i), *(const Word*)(b + i), weightA, weightB);
+        }
+        Scalar::blend(out + i, a + i, b + i, amountOfB, bytes - i);
+    }
+
+    inline void addSaturate(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t bytes) {
+        if (!sameAlignment(out, a) || !sameAlignment(out, b)) {
+            Scalar::addSaturate(out, a, b, bytes);
+            return;
+        }
+        size_t i = headBytes(out, bytes);
+        Scalar::addSaturate(out, a, b, i);
+        for (; i + 4 <= bytes; i += 4) {
+            *(Word*)(out + i) = addWord(*(const Word*)(a + i), *(const Word*)(b + i));
+        }
+        Scalar::addSaturate(out + i, a + i, b + i, bytes - i);
+    }
+
+    using Scalar::palette;
+}
+
+#if defined(__SSE2__)
+namespace Sse2 {
+    // Each byte times (scale + 1) >> 8, via 16-bit lanes
+    inline __m128i scaleVector(__m128i value, __m128i factor) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i low = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(value, zero), factor), 8);
+        __m128i high = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(value, zero), factor), 8);
+        return _mm_packus_epi16(low, high);
+    }
+
+    inline __m128i blendVector(__m128i a, __m128i b, __m128i weightA, __m128i weightB) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), weightA),
+                                    _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), weightB));
+        __m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), weightA),
+                                     _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), weightB));
+        return _mm_packus_epi16(_mm_srli_epi16(low, 8), _mm_srli_epi16(high, 8));
+    }
+
+    inline void fill(uint8_t* out, const uint8_t* rgb, size_t pixels) {
+        // Three vectors repeat the color every 48 bytes
+        uint8_t pattern[48];
+        Scalar::fill(pattern, rgb, 16);
+        __m128i v0 = _mm_loadu_si128((const __m128i*)pattern);
+        __m128i v1 = _mm_loadu_si128((const __m128i*)(pattern + 16));
+        __m128i v2 = _mm_loadu_si128((const __m128i*)(pattern + 32));
+
+        size_t bytes = pixels * 3;
+        size_t i = 0;
+        for (; i + 48 <= bytes; i += 48) {
+            _mm_storeu_si128((__m128i*)(out + i), v0);
+            _mm_storeu_si128((__m128i*)(out + i + 16), v1);
+            _mm_storeu_si128((__m128i*)(out + i + 32), v2);
+        }
+        Scalar::fill(out + i, rgb, (bytes - i) / 3);
+    }
+
+    inline void scale(uint8_t* out, const uint8_t* in, uint8_t scale, size_t bytes) {
+        const __m128i factor = _mm_set1_epi16(1 + (int16_t)scale);
+        size_t i = 0;
+        for (; i + 16 <= bytes; i += 16) {
+            __m128i value = _mm_loadu_si128((const __m128i*)(in + i));
+            _mm_storeu_si128((__m128i*)(out + i), scaleVector(value, factor));
+        }
+        Scalar::scale(out + i, in + i, scale, bytes - i);
+    }
+
+    inline void blend(uint8_t* out, const uint8_t* a, const uint8_t* b, uint8_t amountOfB, size_t bytes) {
+        const __m128i weightA = _mm_set1_epi16(256 - (int16_t)amountOfB);
+        const __m128i weightB = _mm_set1_epi16(1 + (int16_t)amountOfB);
+        size_t i = 0;
+        for (; i + 16 <= bytes; i += 16) {
+            __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+            __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+            _mm_storeu_si128((__m128i*)(out + i), blendVector(va, vb, weightA, weightB));
+        }
+        Scalar::blend(out + i, a + i, b + i, amountOfB, bytes - i);
+    }
+
+    inline void addSaturate(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t bytes) {
+        size_t i = 0;
+        for (; i + 16 <= bytes; i += 16) {
+            __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+            __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+            _mm_storeu_si128((__m128i*)(out + i), _mm_adds_epu8(va, vb));
+        }
+        Scalar::addSaturate(out + i, a + i, b + i, bytes - i);
+    }
+
+    using Scalar::palette;
+}
+#endif
+
+#if defined(__AVX2__)
+namespace Avx2 {
+    // Unpack and pack both work within 128-bit halves, so byte order is preserved
+    inline __m256i scaleVector(__m256i value, __m256i factor) {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i low = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(value, zero), factor), 8);
+        __m256i high = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(value, zero), factor), 8);
+        return _mm256_packus_epi16(low, high);
+    }
+
+    inline __m256i blendVector(__m256i a, __m256i b, __m256i weightA, __m256i weightB) {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i low = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(a, zero), weightA),
+                                       _mm256_mullo_epi16(_mm256_unpacklo_epi8(b, zero), weightB));
+        __m256i high = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(a, zero), weightA),
+                                        _mm256_mullo_epi16(_mm256_unpackhi_epi8(b, zero), weightB));
+        return _mm256_packus_epi16(_mm256_srli_epi16(low, 8), _mm256_srli_epi16(high, 8));
+    }
+
+    inline void fill(uint8_t* out, const uint8_t* rgb, size_t pixels) {
+        // Three vectors repeat the color every 96 bytes
+        uint8_t pattern[96];
+        Scalar::fill(pattern, rgb, 32);
+        __m256i v0 = _mm256_loadu_si256((const __m256i*)pattern);
+        __m256i v1 = _mm256_loadu_si256((const __m256i*)(pattern + 32));
+        __m256i v2 = _mm256_loadu_si256((const __m256i*)(pattern + 64));
+
+        size_t bytes = pixels * 3;
+        size_t i = 0;
+        for (; i + 96 <= bytes; i += 96) {
+            _mm256_storeu_si256((__m256i*)(out + i), v0);
+            _mm256_storeu_si256((__m256i*)(out + i + 32), v1);
+            _mm256_storeu_si256((__m256i*)(out + i + 64), v2);
+        }
+        Sse2::fill(out + i, rgb, (bytes - i) / 3);
+    }
+
+    inline void scale(uint8_t* out, const uint8_t* in, uint8_t scale, size_t bytes) {
+        const __m256i factor = _mm256_set1_epi16(1 + (int16_t)scale);
+        size_t i = 0;
+        for (; i + 32 <= bytes; i += 32) {
+            __m256i value = _mm256_loadu_si256((const __m256i*)(in + i));
+            _mm256_storeu_si256((__m256i*)(out + i), scaleVector(value, factor));
+        }
+        Sse2::scale(out + i, in + i, scale, bytes - i);
+    }
+
+    inline void blend(uint8_t* out, const uint8_t* a, const uint8_t* b, uint8_t amountOfB, size_t bytes) {
+        const __m256i weightA = _mm256_set1_epi16(256 - (int16_t)amountOfB);
+        const __m256i weightB = _mm256_set1_epi16(1 + (int16_t)amountOfB);
+        size_t i = 0;
+        for (; i + 32 <= bytes; i += 32) {
+            __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+            __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+            _mm256_storeu_si256((__m256i*)(out + i), blendVector(va, vb, weightA, weightB));
+        }
+        Sse2::blend(out + i, a + i, b + i, amountOfB, bytes - i);
+    }
+
+    inline void addSaturate(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t bytes) {
+        size_t i = 0;
+        for (; i + 32 <= bytes; i += 32) {
+            __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+            __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+            _mm256_storeu_si256((__m256i*)(out + i), _mm256_adds_epu8(va, vb));
+        }
+        Sse2::addSaturate(out + i, a + i, b + i, bytes - i);
+    }
+
+    using Scalar::palette;
+}
+#endif
+
+// Variant used by the firmware
+#if defined(PIXEL_KERNELS_SCALAR)
+namespace Selected = Scalar;
+#define PIXEL_KERNELS_VARIANT "scalar"
+#elif defined(PIXEL_KERNELS_SWAR)
+namespace Selected = Swar;
+#define PIXEL_KERNELS_VARIANT "swar32"
+#elif defined(__AVX2__)
+namespace Selected = Avx2;
+#define PIXEL_KERNELS_VARIANT "avx2"
+#elif defined(__SSE2__)
+namespace Selected = Sse2;
+#define PIXEL_KERNELS_VARIANT "sse2"
+#else
+namespace Selected = Swar;
+#define PIXEL_KERNELS_VARIANT "swar32"
+#endif
+
+}  // namespace PixelKernels
+
+// Pixel-typed entry points (Pixel is CRGB: three channel bytes)
+template <typename Pixel>
+inline void pixelFill(Pixel* out, const Pixel& color, uint16_t numLeds) {
+    static_assert(sizeof(Pixel) == 3, "Pixel must be three channel bytes");
+    PixelKernels::Selected::fill((uint8_t*)out, (const uint8_t*)&color, numLeds);
+}
+
+// out = in scaled like CRGB::nscale8 (out may alias in)
+template <typename Pixel>
+inline void pixelScale(Pixel* out, const Pixel* in, uint8_t scale, uint16_t numLeds) {
+    static_assert(sizeof(Pixel) == 3, "Pixel must be three channel bytes");
+    PixelKernels::Selected::scale((uint8_t*)out, (const uint8_t*)in, scale, numLeds * 3);
+}
+
+// out = blend(a, b, amountOfB) like FastLED's blend (out may alias a or b)
+template <typename Pixel>
+inline void pixelBlend(Pixel* out, const Pixel* a, const Pixel* b, uint8_t amountOfB, uint16_t numLeds) {
+    static_assert(sizeof(Pixel) == 3, "Pixel must be three channel bytes");
+    PixelKernels::Selected::blend((uint8_t*)out, (const uint8_t*)a, (const uint8_t*)b, amountOfB, numLeds * 3);
+}
+
+// out = a + b per channel, saturating (out may alias a or b)
+template <typename Pixel>
+inline void pixelAdd(Pixel* out, const Pixel* a, const Pixel* b, uint16_t numLeds) {
+    static_assert(sizeof(Pixel) == 3, "Pixel must be three channel bytes");
+    PixelKernels::Selected::addSaturate((uint8_t*)out, (const uint8_t*)a, (const uint8_t*)b, numLeds * 3);
+}
+
+// out[i] = palette[indices[i]] for a 256-entry palette
+template <typename Pixel>
+inline void pixelPalette(Pixel* out, const uint8_t* indices, const Pixel* palette, uint16_t numLeds) {
+    static_assert(sizeof(Pixel) == 3, "Pixel must be three channel bytes");
+    PixelKernels::Selected::palette((uint8_t*)out, indices, (const uint8_t*)palette, numLeds);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Arduino.h>
+#include "protocol.h"
+#include "metrics.h"
+
+// Receive filter configuration
+#define RECEIVE_MAX_SENDERS 4      // Allow-list entries
+#define RECEIVE_MIN_JSON_LENGTH 2  // "{}"
+
+// Why a packet was dropped by the filter
+#define DROP_REASON_COUNT 3
+enum class DropReason : uint8_t {
+    LENGTH,  // Empty, larger than one ESP-NOW frame, or too short for its message type
+    SENDER,  // Sender not on the allow-list
+    MAGIC    // Neither JSON nor a known binary message type
+};
+
+// Cheap checks run in the ESP-NOW receive callback before a packet is logged or
+// parsed, so traffic from other ESP-NOW devices on the channel costs a few
+// compares. An empty allow-list accepts any sender.
+class ReceiveFilter {
+public:
+    ReceiveFilter() : senderCount(0) {}
+
+    // Add a sender to the allow-list. Returns false if the list is full.
+    bool allowSender(const uint8_t* mac) {
+        if (senderCount >= RECEIVE_MAX_SENDERS) {
+            return false;
+        }
+        memcpy(senders[senderCount++], mac, 6);
+        return true;
+    }
+
+    void clearSenders() {
+        senderCount = 0;
+    }
+
+    // True if the packet should be handled; otherwise counts the drop reason
+    bool accept(const uint8_t* mac, const uint8_t* data, int len) {
+        if (len < 1 || len > ESPNOW_MAX_PAYLOAD) {
+            return drop(DropReason::LENGTH);
+        }
+        if (senderCount != 0 && !isAllowed(mac)) {
+            return drop(DropReason::SENDER);
+        }
+
+        // JSON may start with whitespace, which is never the magic byte
+        int start = 0;
+        while (start < len && isJsonWhitespace(data[start])) {
+            start++;
+        }
+        if (start < len && data[start] == '{') {
+            if (len - start < RECEIVE_MIN_JSON_LENGTH) {
+                return drop(DropReason::LENGTH);
+            }
+        } else {
+            if (data[0] != PROTOCOL_MAGIC || len < (int)sizeof(MessageHeader)) {
+                return drop(DropReason::MAGIC);
+            }
+            int required = minLength(data[1]);
+            if (required == 0) {
+                return drop(DropReason::MAGIC);
+            }
+            if (len < required) {
+                return drop(DropReason::LENGTH);
+            }
+        }
+
+        accepted++;
+        return true;
+    }
+
+    uint8_t getSenderCount() const { return senderCount; }
+    uint32_t getAccepted() const { return accepted; }
+    uint32_t getDropped(DropReason reason) const { return dropped[(uint8_t)reason]; }
+
+private:
+    uint8_t senders[RECEIVE_MAX_SENDERS][6];
+    uint8_t senderCount;
+
+    // Statistics
+    MetricCounter accepted;
+    MetricCounter dropped[DROP_REASON_COUNT];
+
+    // Shortest valid packet for each binary message type (0 = unknown type)
+    static int minLength(uint8_t type) {
+        switch ((MessageType)type) {
+            case MessageType::PARAM_SAMPLE: return sizeof(ParamSampleMessage);
+            case MessageType::FRAME: return sizeof(FrameMessageHeader);
+            case MessageType::FRAGMENT: return sizeof(FragmentHeader);
+            default: return 0;
+        }
+    }
+
+    static bool isJsonWhitespace(uint8_t c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    bool isAllowed(const uint8_t* mac) const {
+        for (uint8_t i = 0; i < senderCount; i++) {
+            if (memcmp(senders[i], mac, 6) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool drop(DropReason reason) {
+        dropped[(uint8_t)reason]++;
+        return false;
+    }
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+#include "patterns.h"
+#include "animation_timing.h"
+
+// Strip zones with their own pattern. Segment 0 (MAIN) is the whole strip and
+// shows the flight state pattern stack; segments 1.. cover LED ranges on top of it.
+#define SEGMENT_COUNT 4
+#define SEGMENT_MAIN 0
+
+// LED range of a segment, in logical LEDs (see led_layout.h)
+struct SegmentRange {
+    uint16_t start;
+    uint16_t length;  // 0 = unused
+};
+
+// Pattern and animation state of one segment. Each segment draws its pattern
+// as if its range were a strip of its own, so a flow runs along the segment.
+struct Segment {
+    SegmentRange range;
+    PatternConfig config;
+    PhaseAccumulator animation;
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <FastLED.h>
+#include "pixel_kernels.h"
+
+// Transition configuration
+#define TRANSITION_DEFAULT_MS 250          // Default pattern change duration
+#define TRANSITION_FRAME_BUDGET_US 2000    // Max extra render + blend time per frame
+
+// How one pattern replaces another
+enum class TransitionType : uint8_t {
+    CUT,        // Switch instantly
+    CROSSFADE,  // Blend every LED from outgoing to incoming
+    WIPE        // Incoming pattern sweeps along the strip
+};
+
+// Time-based blend between an outgoing and an incoming frame.
+// Progress is an 8-bit fraction of the configured duration, so the transition
+// takes the same wall time at any frame rate. The caller renders both patterns
+// into separate buffers and reports the extra cost of each transition frame;
+// if a frame exceeds TRANSITION_FRAME_BUDGET_US the transition is cut short so
+// it can never cause missed frames.
+class Transition {
+public:
+    Transition() : type(TransitionType::CUT), durationUs(0), startUs(0), active(false),
+                   transitionsStarted(0), transitionsCompleted(0), transitionsInterrupted(0),
+                   transitionsOverBudget(0), frames(0), costSumUs(0), costMaxUs(0) {}
+
+    void start(TransitionType newType, uint16_t durationMs, uint32_t nowUs) {
+        if (active) {
+            transitionsInterrupted++;
+        }
+        type = newType;
+        durationUs = (uint32_t)durationMs * 1000;
+        startUs = nowUs;
+        active = (newType != TransitionType::CUT && durationUs > 0);
+        if (active) {
+            transitionsStarted++;
+        }
+    }
+
+    // Stop blending and show only the incoming pattern
+    void finish() {
+        active = false;
+    }
+
+    bool isActive() const {
+        return active;
+    }
+
+    // Fraction of the way to the incoming pattern at nowUs, 0-255.
+    // The transition ends (and returns 255) once the duration has elapsed.
+    uint8_t progress(uint32_t nowUs) {
+        if (!active) {
+            return 255;
+        }
+        uint32_t elapsed = nowUs - startUs;
+        if (elapsed >= durationUs) {
+            active = false;
+            transitionsCompleted++;
+            return 255;
+        }
+        return (uint8_t)(((uint64_t)elapsed * 256) / durationUs);
+    }
+
+    // Blend outgoing (from) and incoming (to) frames into out (may alias either)
+    void blendFrames(CRGB* out, const CRGB* from, const CRGB* to, uint16_t numLeds, uint8_t amount) const {
+        switch (type) {
+            case TransitionType::CROSSFADE:
+                pixelBlend(out, from, to, amount, numLeds);
+                break;
+            case TransitionType::WIPE: {
+                // Edge position in 1/256 LED; the LED under the edge is blended
+                uint32_t edge256 = (uint32_t)amount * numLeds;
+                uint16_t edgeLed = edge256 >> 8;
+                uint8_t edgeFrac = edge256 & 0xFF;
+                for (uint16_t i = 0; i < numLeds; i++) {
+                    if (i < edgeLed) {
+                        out[i] = to[i];
+                    } else if (i == edgeLed) {
+                        out[i] = blend(from[i], to[i], edgeFrac);
+                    } else {
+                        out[i] = from[i];
+                    }
+                }
+                break;
+            }
+            default:
+                if (out != to) {
+                    memcpy(out, to, numLeds * sizeof(CRGB));
+                }
+                break;
+        }
+    }
+
+    // Record the extra time spent on one transition frame (outgoing render + blend)
+    void recordFrameCost(uint32_t costUs) {
+        frames++;
+        costSumUs += costUs;
+        if (costUs > costMaxUs) {
+            costMaxUs = costUs;
+        }
+        if (active && costUs > TRANSITION_FRAME_BUDGET_US) {
+            active = false;
+            transitionsOverBudget++;
+        }
+    }
+
+    TransitionType getType() const { return type; }
+    uint32_t getTransitionsStarted() const { return transitionsStarted; }
+    uint32_t getTransitionsCompleted() const { return transitionsCompleted; }
+    uint32_t getTransitionsInterrupted() const { return transitionsInterrupted; }
+    uint32_t getTransitionsOverBudget() const { return transitionsOverBudget; }
+    uint32_t getFrameCostAvgUs() const { return frames ? costSumUs / frames : 0; }
+    uint32_t getFrameCostMaxUs() const { return costMaxUs; }
+
+private:
+    TransitionType type;
+    uint32_t durationUs;
+    uint32_t startUs;
+    bool active;
+
+    // Statistics
+    uint32_t transitionsStarted;
+    uint32_t transitionsCompleted;
+    uint32_t transitionsInterrupted;
+    uint32_t transitionsOverBudget;
+    uint32_t frames;
+    uint32_t costSumUs;
+    uint32_t costMaxUs;
+};
+
+// Convert TransitionType to string
+inline const char* transitionToString(TransitionType type) {
+    switch (type) {
+        case TransitionType::CUT: return "CUT";
+        case TransitionType::CROSSFADE: return "CROSSFADE";
+        case TransitionType::WIPE: return "WIPE";
+        default: return "UNKNOWN";
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// Injected clock for tests driving LedController and animation timing.
+// Set fakeNowUs, then pass fakeClock as the controller's MicrosClock.
+static unsigned long fakeNowUs = 0;
+
+static unsigned long fakeClock() {
+    return fakeNowUs;
+}
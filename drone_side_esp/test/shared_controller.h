@@ -0,0 +1,31 @@
+#pragma once
+
+#include <new>
+#include "led_controller.h"
+#include "fake_clock.h"
+
+// LedControllers shared by the tests of one binary. Each one holds its frame
+// cache and pixel buffers (about 36 KB), too much for one per test on the
+// device. Define SHARED_CONTROLLERS 2 before including this for tests that
+// compare two controllers, and call resetSharedControllers() from setUp().
+#ifndef SHARED_CONTROLLERS
+#define SHARED_CONTROLLERS 1
+#endif
+
+alignas(LedController) static uint8_t sharedControllerStorage[SHARED_CONTROLLERS][sizeof(LedController)];
+static bool sharedControllersBuilt = false;
+
+static LedController& sharedController(uint8_t index = 0) {
+    return *reinterpret_cast<LedController*>(sharedControllerStorage[index]);
+}
+
+// Replace each shared controller with a freshly constructed one
+static void resetSharedControllers() {
+    for (uint8_t i = 0; i < SHARED_CONTROLLERS; i++) {
+        if (sharedControllersBuilt) {
+            sharedController(i).~LedController();
+        }
+        new (sharedControllerStorage[i]) LedController(fakeClock);
+    }
+    sharedControllersBuilt = true;
+}
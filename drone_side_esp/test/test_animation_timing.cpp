@@ -0,0 +1,210 @@
+/**
+ * @file test_animation_timing.cpp
+ * @brief Unit tests for the phase accumulator animation timing
+ *
+ * All tests drive time through an injected fake clock, so they verify exact
+ * animation speed independent of the real frame rate:
+ * 1. Whole cycles complete exactly on the period, with no drift
+ * 2. Phase is identical whether sampled at 1 kHz or 60 Hz
+ * 3. Long strips keep the commanded flow speed
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "animation_timing.h"
+#include "led_controller.h"
+#include "fake_clock.h"
+
+static void setClock(unsigned long us) {
+    fakeNowUs = us;
+}
+
+static void advanceClock(unsigned long us) {
+    fakeNowUs += us;
+}
+
+// Deterministic pseudo-random frame interval between 1 and 40 ms
+static uint32_t jitteredFrameUs(uint32_t& seed) {
+    seed = seed * 1664525UL + 1013904223UL;
+    return 1000 + (seed >> 8) % 39000;
+}
+
+// Test phase starts at zero after reset
+void test_phase_starts_at_zero() {
+    setClock(12345);
+    PhaseAccumulator acc;
+    acc.setPeriod(1000);
+    acc.reset(fakeClock());
+
+    TEST_ASSERT_EQUAL_UINT32(0, acc.advance(fakeClock()));
+    TEST_ASSERT_EQUAL_UINT32(0, acc.getCycles());
+}
+
+// Test uneven steps that sum to whole periods land exactly on phase 0
+void test_phase_exact_period_uneven_steps() {
+    setClock(0);
+    PhaseAccumulator acc;
+    acc.setPeriod(1000);
+    acc.reset(fakeClock());
+
+    const unsigned long steps[] = {7, 333, 1, 659};  // Sums to exactly 1000 us
+    for (int cycle = 0; cycle < 10; cycle++) {
+        for (unsigned long step : steps) {
+            advanceClock(step);
+            acc.advance(fakeClock());
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(10, acc.getCycles());
+    TEST_ASSERT_EQUAL_UINT32(0, acc.phase());
+}
+
+// Test half a period gives half phase
+void test_phase_half_period() {
+    setClock(0);
+    PhaseAccumulator acc;
+    acc.setPeriod(400000);
+    acc.reset(fakeClock());
+
+    advanceClock(200000);
+    TEST_ASSERT_EQUAL_UINT32(0x80000000UL, acc.advance(fakeClock()));
+}
+
+// Test blink timing does not drift over many cycles with jittered frames
+void test_blink_no_drift_with_jitter() {
+    setClock(0);
+    PhaseAccumulator acc;
+    acc.setPeriod(LedController::cyclePeriodUs(LedPattern::FLYING, PatternDefaults::SPEED_FAST_BLINK));
+    acc.reset(fakeClock());
+
+    uint32_t seed = 42;
+    while (fakeNowUs < 400000UL * 1000) {  // 1000 blink cycles
+        advanceClock(jitteredFrameUs(seed));
+        acc.advance(fakeClock());
+    }
+
+    uint32_t expectedCycles = fakeNowUs / 400000UL;
+    TEST_ASSERT_EQUAL_UINT32(expectedCycles, acc.getCycles());
+
+    uint32_t expectedPhase = (uint32_t)(((uint64_t)(fakeNowUs % 400000UL) << 32) / 400000UL);
+    TEST_ASSERT_EQUAL_UINT32(expectedPhase, acc.phase());
+}
+
+// Test flow position is the same at 1 kHz and 60 Hz sampling
+void test_flow_frame_rate_independent() {
+    const uint32_t period = LedController::cyclePeriodUs(LedPattern::TAKING_OFF, PatternDefaults::SPEED_FLOW);
+
+    PhaseAccumulator fast;
+    PhaseAccumulator slow;
+    fast.setPeriod(period);
+    slow.setPeriod(period);
+    setClock(0);
+    fast.reset(fakeClock());
+    slow.reset(fakeClock());
+
+    for (uint32_t t = 1000; t <= 1000000; t += 1000) {
+        setClock(t);
+        fast.advance(fakeClock());
+        if (t % 16000 == 0) {  // ~60 Hz
+            slow.advance(fakeClock());
+            TEST_ASSERT_EQUAL_UINT32(fast.step(NUM_LEDS + FLOW_GAP_STEPS), slow.step(NUM_LEDS + FLOW_GAP_STEPS));
+        }
+    }
+}
+
+// Test flow speed is exact on a long strip (previously stepDuration truncated to 0)
+void test_flow_long_strip_exact_speed() {
+    const uint32_t stepsPerCycle = 300 + 10;
+    setClock(0);
+    PhaseAccumulator acc;
+    acc.setPeriod(LedController::cyclePeriodUs(LedPattern::LANDING, PatternDefaults::SPEED_FLOW));
+    acc.reset(fakeClock());
+
+    // Halfway through the sweep the head is halfway along
+    advanceClock(50000);
+    acc.advance(fakeClock());
+    TEST_ASSERT_EQUAL_UINT32(stepsPerCycle / 2, acc.step(stepsPerCycle));
+
+    // Exactly one sweep per SPEED_FLOW ms, however many steps
+    advanceClock(50000);
+    acc.advance(fakeClock());
+    TEST_ASSERT_EQUAL_UINT32(1, acc.getCycles());
+    TEST_ASSERT_EQUAL_UINT32(0, acc.step(stepsPerCycle));
+}
+
+// Test micros() overflow is handled
+void test_phase_clock_wraparound() {
+    setClock(0xFFFFFFFFUL - 500);
+    PhaseAccumulator acc;
+    acc.setPeriod(2000);
+    acc.reset(fakeClock());
+
+    setClock(499);  // 1000 us later, across the wrap
+    TEST_ASSERT_EQUAL_UINT32(0x80000000UL, acc.advance(fakeClock()));
+    TEST_ASSERT_EQUAL_UINT32(0, acc.getCycles());
+}
+
+// Test changing the period keeps the current phase
+void test_set_period_keeps_phase() {
+    setClock(0);
+    PhaseAccumulator acc;
+    acc.setPeriod(1000);
+    acc.reset(fakeClock());
+
+    advanceClock(250);
+    uint32_t before = acc.advance(fakeClock());
+    acc.setPeriod(4000);
+    TEST_ASSERT_EQUAL_UINT32(before, acc.phase());
+
+    // New period applies from here on: 1000 us is another quarter cycle
+    advanceClock(1000);
+    TEST_ASSERT_EQUAL_UINT32(0x80000000UL, acc.advance(fakeClock()));
+}
+
+// Test a zero period (static pattern) freezes the phase
+void test_zero_period_freezes() {
+    setClock(0);
+    PhaseAccumulator acc;
+    acc.setPeriod(0);
+    acc.reset(fakeClock());
+
+    advanceClock(1000000);
+    TEST_ASSERT_EQUAL_UINT32(0, acc.advance(fakeClock()));
+    TEST_ASSERT_EQUAL_UINT32(0, acc.getCycles());
+}
+
+// Test cycle periods derived from pattern speeds
+void test_cycle_period_per_pattern() {
+    TEST_ASSERT_EQUAL_UINT32(0, LedController::cyclePeriodUs(LedPattern::IDLE, 0));
+    TEST_ASSERT_EQUAL_UINT32(400000, LedController::cyclePeriodUs(LedPattern::EMERGENCY, 200));
+    TEST_ASSERT_EQUAL_UINT32(2000000, LedController::cyclePeriodUs(LedPattern::HOVERING, 1000));
+    TEST_ASSERT_EQUAL_UINT32(100000, LedController::cyclePeriodUs(LedPattern::TAKING_OFF, 100));
+    TEST_ASSERT_EQUAL_UINT32(12800000, LedController::cyclePeriodUs(LedPattern::BRAINWAVE, 50));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, LedController::cyclePeriodUs(LedPattern::BRAINWAVE, 65535));
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Phase accumulator tests
+    RUN_TEST(test_phase_starts_at_zero);
+    RUN_TEST(test_phase_exact_period_uneven_steps);
+    RUN_TEST(test_phase_half_period);
+    RUN_TEST(test_phase_clock_wraparound);
+    RUN_TEST(test_set_period_keeps_phase);
+    RUN_TEST(test_zero_period_freezes);
+
+    // Pattern timing tests
+    RUN_TEST(test_blink_no_drift_with_jitter);
+    RUN_TEST(test_flow_frame_rate_independent);
+    RUN_TEST(test_flow_long_strip_exact_speed);
+    RUN_TEST(test_cycle_period_per_pattern);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
@@ -0,0 +1,209 @@
+/**
+ * @file test_compositor.cpp
+ * @brief Unit tests for the layered frame compositor
+ *
+ * Verifies that:
+ * 1. Each blend mode combines an overlay with the base correctly
+ * 2. Black overlay pixels are transparent and brightness is applied per layer
+ * 3. LedController shows LOW_BATTERY on top of the flight state pattern
+ * 4. A streamed frame keeps its colors, under an overlay, until the next frame
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "compositor.h"
+#include "led_controller.h"
+#include "shared_controller.h"
+
+void setUp() {
+    resetSharedControllers();
+}
+
+#define TEST_NUM_LEDS 8
+
+// Test base brightness is applied with no overlays
+void test_base_only_applies_brightness() {
+    CRGB base[TEST_NUM_LEDS];
+    CRGB out[TEST_NUM_LEDS];
+    fill_solid(base, TEST_NUM_LEDS, CRGB(200, 100, 50));
+
+    compositeLayers(out, base, 128, nullptr, 0, TEST_NUM_LEDS);
+
+    CRGB expected = CRGB(200, 100, 50);
+    expected.nscale8(128);
+    for (int i = 0; i < TEST_NUM_LEDS; i++) {
+        TEST_ASSERT_TRUE(out[i] == expected);
+    }
+}
+
+// Test NORMAL covers lit pixels and leaves black pixels transparent
+void test_normal_blend_black_is_transparent() {
+    CRGB base[TEST_NUM_LEDS];
+    CRGB overlay[TEST_NUM_LEDS];
+    CRGB out[TEST_NUM_LEDS];
+    fill_solid(base, TEST_NUM_LEDS, CRGB(0, 0, 255));
+    fill_solid(overlay, TEST_NUM_LEDS, CRGB(0, 0, 0));
+    overlay[2] = CRGB(255, 0, 0);
+
+    LayerSource layer = {overlay, 255, BlendMode::NORMAL, 255};
+    compositeLayers(out, base, 255, &layer, 1, TEST_NUM_LEDS);
+
+    TEST_ASSERT_TRUE(out[1] == CRGB(0, 0, 255));
+    TEST_ASSERT_TRUE(out[2] == CRGB(255, 0, 0));
+    TEST_ASSERT_TRUE(out[3] == CRGB(0, 0, 255));
+}
+
+// Test NORMAL opacity mixes the overlay with the base
+void test_normal_blend_opacity() {
+    CRGB base[TEST_NUM_LEDS];
+    CRGB overlay[TEST_NUM_LEDS];
+    CRGB out[TEST_NUM_LEDS];
+    fill_solid(base, TEST_NUM_LEDS, CRGB(0, 0, 200));
+    fill_solid(overlay, TEST_NUM_LEDS, CRGB(200, 0, 0));
+
+    LayerSource layer = {overlay, 255, BlendMode::NORMAL, 128};
+    compositeLayers(out, base, 255, &layer, 1, TEST_NUM_LEDS);
+
+    TEST_ASSERT_UINT8_WITHIN(2, 100, out[0].r);
+    TEST_ASSERT_UINT8_WITHIN(2, 100, out[0].b);
+}
+
+// Test ADD saturates and LIGHTEN takes the per-channel maximum
+void test_add_and_lighten_blend() {
+    CRGB base[TEST_NUM_LEDS];
+    CRGB overlay[TEST_NUM_LEDS];
+    CRGB out[TEST_NUM_LEDS];
+    fill_solid(base, TEST_NUM_LEDS, CRGB(200, 50, 0));
+    fill_solid(overlay, TEST_NUM_LEDS, CRGB(100, 20, 30));
+
+    LayerSource add = {overlay, 255, BlendMode::ADD, 255};
+    compositeLayers(out, base, 255, &add, 1, TEST_NUM_LEDS);
+    TEST_ASSERT_TRUE(out[0] == CRGB(255, 70, 30));
+
+    LayerSource lighten = {overlay, 255, BlendMode::LIGHTEN, 255};
+    compositeLayers(out, base, 255, &lighten, 1, TEST_NUM_LEDS);
+    TEST_ASSERT_TRUE(out[0] == CRGB(200, 50, 30));
+}
+
+// Test layers stack in order: the alert covers the overlay
+void test_layer_order() {
+    CRGB base[TEST_NUM_LEDS];
+    CRGB overlay[TEST_NUM_LEDS];
+    CRGB alert[TEST_NUM_LEDS];
+    CRGB out[TEST_NUM_LEDS];
+    fill_solid(base, TEST_NUM_LEDS, CRGB(0, 0, 255));
+    fill_solid(overlay, TEST_NUM_LEDS, CRGB(0, 255, 0));
+    fill_solid(alert, TEST_NUM_LEDS, CRGB(255, 0, 0));
+
+    LayerSource layers[2] = {
+        {overlay, 255, BlendMode::NORMAL, 255},
+        {alert, 255, BlendMode::NORMAL, 255}
+    };
+    compositeLayers(out, base, 255, layers, 2, TEST_NUM_LEDS);
+    TEST_ASSERT_TRUE(out[0] == CRGB(255, 0, 0));
+}
+
+// Test LOW_BATTERY pulses over the flight state pattern and can be turned off
+void test_controller_low_battery_overlay() {
+    LedController& controller = sharedController();
+    controller.setGamma(1.0f);  // Composited values then equal pattern brightness
+    fakeNowUs = 0;
+    controller.setTransition(TransitionType::CUT, 0);
+    controller.begin();
+
+    PatternConfig base = PatternDefaults::getDefault(LedPattern::IDLE);
+    base.brightness = 255;
+    controller.setPattern(base);
+
+    PatternConfig battery = PatternDefaults::getDefault(LedPattern::LOW_BATTERY);
+    battery.brightness = 255;
+    controller.setLayer(LayerId::OVERLAY, battery, BlendMode::NORMAL, 255);
+
+    // Blink on: orange covers the base
+    fakeNowUs += 100000;
+    controller.update();
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == PatternDefaults::COLOR_ORANGE);
+
+    // Blink off: flight state shows through
+    fakeNowUs += 1000000;
+    controller.update();
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == PatternDefaults::COLOR_BLUE);
+
+    // The base pattern can change underneath without clearing the overlay
+    controller.setPattern(LedPattern::HOVERING);
+    TEST_ASSERT_EQUAL_UINT8(255, controller.getLayer(LayerId::OVERLAY).opacity);
+
+    // Opacity 0 turns the overlay off
+    controller.setLayer(LayerId::OVERLAY, battery, BlendMode::NORMAL, 0);
+    controller.setPattern(base);
+    fakeNowUs += 1000000;
+    controller.update();
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == PatternDefaults::COLOR_BLUE);
+}
+
+// Test a streamed frame is shown unchanged on every update until the next one,
+// and a DELTA frame applies to the decoded frame, not the composite
+void test_controller_streamed_frame_persists() {
+    LedController& controller = sharedController();
+    controller.setGamma(1.0f);  // Composited values then equal pattern brightness
+    fakeNowUs = 1000000;
+    controller.setTransition(TransitionType::CUT, 0);
+    PatternConfig base = PatternDefaults::getDefault(LedPattern::IDLE);
+    base.brightness = 128;
+    controller.setPattern(base);
+    PatternConfig alert = PatternDefaults::getDefault(LedPattern::IDLE);
+    alert.color = CRGB(0, 0, 40);
+    alert.brightness = 255;
+    controller.setLayer(LayerId::ALERT, alert, BlendMode::ADD, 255);
+
+    FrameMessageHeader frame = {{PROTOCOL_MAGIC, MessageType::FRAME}, 1, 0, NUM_LEDS, FrameEncoding::RLE};
+    const uint8_t grey[] = {FRAME_OP_RUN | (NUM_LEDS - 1), 200, 200, 200};
+    controller.pushFrame(frame, grey, sizeof(grey));
+    fakeNowUs += FRAME_JITTER_DELAY_US;
+    controller.update();
+    const CRGB expected(100, 100, 140);  // Frame at brightness 128, plus the alert
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == expected);
+
+    // No new frame: the same frame is shown again, not rescaled or re-blended
+    for (uint8_t i = 0; i < 5; i++) {
+        fakeNowUs += 16667;
+        controller.update();
+        TEST_ASSERT_TRUE(controller.getLeds()[0] == expected);
+        TEST_ASSERT_TRUE(controller.getLeds()[NUM_LEDS - 1] == expected);
+    }
+
+    // A DELTA frame changes only the first LED of the decoded frame
+    frame.frameNumber = 2;
+    frame.sampleTimeUs = fakeNowUs - 1000000;  // Sender clock started with the first frame
+    frame.encoding = FrameEncoding::DELTA;
+    const uint8_t delta[] = {FRAME_OP_RUN, 0, 254, 0, FRAME_OP_SKIP | (NUM_LEDS - 2)};
+    controller.pushFrame(frame, delta, sizeof(delta));
+    fakeNowUs += FRAME_JITTER_DELAY_US;
+    controller.update();
+    TEST_ASSERT_EQUAL_UINT32(2, controller.getFrameStream().getFramesPlayed());
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == CRGB(0, 127, 40));
+    TEST_ASSERT_TRUE(controller.getLeds()[1] == expected);
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Blend mode tests
+    RUN_TEST(test_base_only_applies_brightness);
+    RUN_TEST(test_normal_blend_black_is_transparent);
+    RUN_TEST(test_normal_blend_opacity);
+    RUN_TEST(test_add_and_lighten_blend);
+    RUN_TEST(test_layer_order);
+
+    // Controller tests
+    RUN_TEST(test_controller_low_battery_overlay);
+    RUN_TEST(test_controller_streamed_frame_persists);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
@@ -0,0 +1,169 @@
+/**
+ * @file test_flow_render.cpp
+ * @brief Unit tests and benchmark for the sub-pixel flow (comet) renderer
+ *
+ * Verifies that:
+ * 1. At whole-LED positions the output matches the previous integer renderer
+ * 2. Fractional positions split intensity between adjacent LEDs
+ * 3. The comet moves smoothly and never writes outside the strip
+ * 4. Render cost stays comparable to the previous updateFlowUp
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "flow_renderer.h"
+
+#define TEST_NUM_LEDS 30
+#define TEST_TAIL_LENGTH 10
+#define TEST_STEPS_PER_CYCLE (TEST_NUM_LEDS + 10)
+
+static const CRGB TEST_COLOR = CRGB(0, 255, 0);
+
+// Previous integer-step updateFlowUp drawing code, kept as the reference
+static void legacyFlowUp(CRGB* leds, uint16_t numLeds, const CRGB& color, int currentStep) {
+    fill_solid(leds, numLeds, CRGB(0, 0, 0));
+    uint8_t tailLength = TEST_TAIL_LENGTH;
+    for (uint8_t i = 0; i < tailLength; i++) {
+        int ledIndex = currentStep - i;
+        if (ledIndex >= 0 && ledIndex < numLeds) {
+            uint8_t brightness = 255 * (tailLength - i) / tailLength;
+            leds[ledIndex] = color;
+            leds[ledIndex].nscale8(brightness);
+        }
+    }
+}
+
+static void subPixelFlow(CRGB* leds, uint16_t numLeds, const CRGB& color, uint32_t head8, bool reverse) {
+    fill_solid(leds, numLeds, CRGB(0, 0, 0));
+    renderComet(leds, numLeds, color, head8, TEST_TAIL_LENGTH, reverse);
+}
+
+// Brightness-weighted centre of the comet, in 1/256 LED
+static uint32_t centroid256(const CRGB* leds, uint16_t numLeds) {
+    uint32_t sum = 0;
+    uint32_t weighted = 0;
+    for (uint16_t i = 0; i < numLeds; i++) {
+        sum += leds[i].g;
+        weighted += (uint32_t)leds[i].g * i * 256;
+    }
+    return sum ? weighted / sum : 0;
+}
+
+// Test whole-LED positions reproduce the integer renderer exactly
+void test_integer_positions_match_legacy() {
+    CRGB expected[TEST_NUM_LEDS];
+    CRGB actual[TEST_NUM_LEDS];
+
+    for (int step = 0; step < TEST_STEPS_PER_CYCLE; step++) {
+        legacyFlowUp(expected, TEST_NUM_LEDS, TEST_COLOR, step);
+        subPixelFlow(actual, TEST_NUM_LEDS, TEST_COLOR, (uint32_t)step << 8, false);
+        TEST_ASSERT_EQUAL_MEMORY(expected, actual, sizeof(expected));
+    }
+}
+
+// Test reverse direction mirrors the forward comet
+void test_reverse_is_mirrored() {
+    CRGB forward[TEST_NUM_LEDS];
+    CRGB reverse[TEST_NUM_LEDS];
+
+    for (uint32_t head8 = 0; head8 < TEST_STEPS_PER_CYCLE * 256; head8 += 37) {
+        subPixelFlow(forward, TEST_NUM_LEDS, TEST_COLOR, head8, false);
+        subPixelFlow(reverse, TEST_NUM_LEDS, TEST_COLOR, head8, true);
+        for (int i = 0; i < TEST_NUM_LEDS; i++) {
+            TEST_ASSERT_TRUE(forward[i] == reverse[TEST_NUM_LEDS - 1 - i]);
+        }
+    }
+}
+
+// Test half-LED position splits the head across two LEDs
+void test_half_position_splits_head() {
+    CRGB leds[TEST_NUM_LEDS];
+    subPixelFlow(leds, TEST_NUM_LEDS, TEST_COLOR, (10 << 8) + 128, false);
+
+    // LED ahead of the head is half lit, the head LED slightly below full
+    TEST_ASSERT_UINT8_WITHIN(2, 127, leds[11].g);
+    TEST_ASSERT_UINT8_WITHIN(2, 242, leds[10].g);
+    TEST_ASSERT_EQUAL_UINT8(0, leds[12].g);
+}
+
+// Test the comet centre moves monotonically in 1/16 LED increments
+void test_motion_is_smooth() {
+    CRGB leds[TEST_NUM_LEDS];
+
+    // Keep the whole comet on the strip so the centroid is not clipped
+    subPixelFlow(leds, TEST_NUM_LEDS, TEST_COLOR, TEST_TAIL_LENGTH << 8, false);
+    uint32_t previous = centroid256(leds, TEST_NUM_LEDS);
+
+    for (uint32_t head8 = (TEST_TAIL_LENGTH << 8) + 16; head8 < (TEST_NUM_LEDS - 2) << 8; head8 += 16) {
+        subPixelFlow(leds, TEST_NUM_LEDS, TEST_COLOR, head8, false);
+        uint32_t centre = centroid256(leds, TEST_NUM_LEDS);
+        TEST_ASSERT_GREATER_OR_EQUAL(previous, centre);
+        TEST_ASSERT_LESS_OR_EQUAL(previous + 64, centre);  // Never jumps a quarter LED
+        previous = centre;
+    }
+}
+
+// Test no writes outside the strip at either end of the sweep
+void test_no_out_of_bounds_writes() {
+    CRGB buffer[TEST_NUM_LEDS + 2];
+    const CRGB sentinel = CRGB(1, 2, 3);
+
+    for (uint32_t head8 = 0; head8 < TEST_STEPS_PER_CYCLE * 256; head8 += 53) {
+        for (int dir = 0; dir < 2; dir++) {
+            buffer[0] = sentinel;
+            buffer[TEST_NUM_LEDS + 1] = sentinel;
+            subPixelFlow(buffer + 1, TEST_NUM_LEDS, TEST_COLOR, head8, dir == 1);
+            TEST_ASSERT_TRUE(buffer[0] == sentinel);
+            TEST_ASSERT_TRUE(buffer[TEST_NUM_LEDS + 1] == sentinel);
+        }
+    }
+}
+
+// Benchmark: sub-pixel renderer vs previous integer updateFlowUp
+void test_benchmark_vs_legacy() {
+    const uint32_t iterations = 20000;
+    static CRGB leds[TEST_NUM_LEDS];
+
+    uint32_t start = micros();
+    for (uint32_t n = 0; n < iterations; n++) {
+        legacyFlowUp(leds, TEST_NUM_LEDS, TEST_COLOR, n % TEST_STEPS_PER_CYCLE);
+    }
+    uint32_t legacyUs = micros() - start;
+
+    start = micros();
+    for (uint32_t n = 0; n < iterations; n++) {
+        subPixelFlow(leds, TEST_NUM_LEDS, TEST_COLOR, (n * 7) % (TEST_STEPS_PER_CYCLE * 256), false);
+    }
+    uint32_t subPixelUs = micros() - start;
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "legacy: %lu ns/frame, sub-pixel: %lu ns/frame",
+             (unsigned long)((uint64_t)legacyUs * 1000 / iterations),
+             (unsigned long)((uint64_t)subPixelUs * 1000 / iterations));
+    TEST_MESSAGE(msg);
+
+    // One extra LED per frame: cost must stay in the same ballpark (clear dominates)
+    TEST_ASSERT_LESS_OR_EQUAL(legacyUs * 2 + 1000, subPixelUs);
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Rendering tests
+    RUN_TEST(test_integer_positions_match_legacy);
+    RUN_TEST(test_reverse_is_mirrored);
+    RUN_TEST(test_half_position_splits_head);
+    RUN_TEST(test_motion_is_smooth);
+    RUN_TEST(test_no_out_of_bounds_writes);
+
+    // Performance
+    RUN_TEST(test_benchmark_vs_legacy);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
@@ -0,0 +1,158 @@
+/**
+ * @file test_fragmentation.cpp
+ * @brief Unit tests for fragmented message reassembly
+ *
+ * Verifies that:
+ * 1. Fragments arriving in order or out of order rebuild the original message
+ * 2. Duplicate and malformed fragments are counted and ignored
+ * 3. Messages missing fragments time out and are counted as incomplete
+ * 4. A full pool evicts its oldest partial message for a new one
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "fragmentation.h"
+
+#define TEST_MESSAGE_SIZE 600  // Three fragments
+
+static uint8_t message[TEST_MESSAGE_SIZE];
+
+static void fillMessage(uint8_t seed) {
+    for (size_t i = 0; i < sizeof(message); i++) {
+        message[i] = (uint8_t)(i * 7 + seed);
+    }
+}
+
+// Build fragment `index` of message `messageId` the way the base sends it
+static size_t buildFragment(uint8_t* out, uint16_t messageId, uint8_t index, size_t totalLength) {
+    FragmentHeader header;
+    header.header.magic = PROTOCOL_MAGIC;
+    header.header.type = MessageType::FRAGMENT;
+    header.messageId = messageId;
+    header.fragmentIndex = index;
+    header.fragmentCount = (totalLength + FRAGMENT_PAYLOAD_SIZE - 1) / FRAGMENT_PAYLOAD_SIZE;
+    header.totalLength = totalLength;
+
+    size_t offset = index * FRAGMENT_PAYLOAD_SIZE;
+    size_t chunk = totalLength - offset < FRAGMENT_PAYLOAD_SIZE ? totalLength - offset : FRAGMENT_PAYLOAD_SIZE;
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), message + offset, chunk);
+    return sizeof(header) + chunk;
+}
+
+static const uint8_t* feed(Reassembler& reassembler, uint16_t messageId, uint8_t index,
+                           uint32_t nowUs, size_t& outLen) {
+    uint8_t fragment[ESPNOW_MAX_PAYLOAD];
+    size_t len = buildFragment(fragment, messageId, index, TEST_MESSAGE_SIZE);
+    return reassembler.accept(fragment, (int)len, nowUs, outLen);
+}
+
+// Test in-order and out-of-order fragments both rebuild the message
+void test_reassemble_in_and_out_of_order() {
+    static Reassembler reassembler;
+    size_t outLen = 0;
+    fillMessage(1);
+    TEST_ASSERT_NULL(feed(reassembler, 1, 0, 0, outLen));
+    TEST_ASSERT_NULL(feed(reassembler, 1, 1, 0, outLen));
+    const uint8_t* result = feed(reassembler, 1, 2, 0, outLen);
+    TEST_ASSERT_NOT_NULL(result);
+    TEST_ASSERT_EQUAL_UINT32(TEST_MESSAGE_SIZE, outLen);
+    TEST_ASSERT_EQUAL_MEMORY(message, result, TEST_MESSAGE_SIZE);
+
+    fillMessage(2);
+    TEST_ASSERT_NULL(feed(reassembler, 2, 2, 0, outLen));
+    TEST_ASSERT_NULL(feed(reassembler, 2, 0, 0, outLen));
+    result = feed(reassembler, 2, 1, 0, outLen);
+    TEST_ASSERT_NOT_NULL(result);
+    TEST_ASSERT_EQUAL_MEMORY(message, result, TEST_MESSAGE_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(2, reassembler.getMessagesCompleted());
+}
+
+// Test duplicates are ignored and malformed fragments rejected
+void test_duplicate_and_invalid_fragments() {
+    static Reassembler reassembler;
+    size_t outLen = 0;
+    fillMessage(3);
+    TEST_ASSERT_NULL(feed(reassembler, 5, 0, 0, outLen));
+    TEST_ASSERT_NULL(feed(reassembler, 5, 0, 0, outLen));
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getFragmentsDuplicate());
+
+    // Truncated payload, and a header shorter than its struct
+    uint8_t fragment[ESPNOW_MAX_PAYLOAD];
+    size_t len = buildFragment(fragment, 5, 1, TEST_MESSAGE_SIZE);
+    TEST_ASSERT_NULL(reassembler.accept(fragment, (int)len - 1, 0, outLen));
+    TEST_ASSERT_NULL(reassembler.accept(fragment, (int)sizeof(FragmentHeader) - 1, 0, outLen));
+    TEST_ASSERT_EQUAL_UINT32(2, reassembler.getFragmentsInvalid());
+
+    TEST_ASSERT_NULL(feed(reassembler, 5, 1, 0, outLen));
+    const uint8_t* result = feed(reassembler, 5, 2, 0, outLen);
+    TEST_ASSERT_NOT_NULL(result);
+    TEST_ASSERT_EQUAL_MEMORY(message, result, TEST_MESSAGE_SIZE);
+
+    // A fragment of a completed message starts a new partial one, not a duplicate
+    TEST_ASSERT_NULL(feed(reassembler, 5, 2, 0, outLen));
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getFragmentsDuplicate());
+}
+
+// Test a message missing fragments expires after the timeout
+void test_timeout_expiry() {
+    static Reassembler reassembler;
+    size_t outLen = 0;
+    fillMessage(4);
+    TEST_ASSERT_NULL(feed(reassembler, 7, 0, 1000, outLen));
+    TEST_ASSERT_NULL(feed(reassembler, 7, 1, 1000 + REASSEMBLY_TIMEOUT_US, outLen));
+    TEST_ASSERT_EQUAL_UINT32(0, reassembler.getMessagesIncomplete());
+
+    // The last fragment arrives too late: the partial message is gone
+    TEST_ASSERT_NULL(feed(reassembler, 7, 2, 1001 + REASSEMBLY_TIMEOUT_US, outLen));
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getMessagesIncomplete());
+    TEST_ASSERT_EQUAL_UINT32(0, reassembler.getMessagesCompleted());
+}
+
+// Test a full pool evicts the oldest partial message and keeps the others
+void test_eviction_when_full() {
+    static Reassembler reassembler;
+    size_t outLen = 0;
+    fillMessage(5);
+    for (uint16_t id = 0; id < REASSEMBLY_SLOTS; id++) {
+        TEST_ASSERT_NULL(feed(reassembler, 100 + id, 0, 1000 + id, outLen));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, reassembler.getMessagesEvicted());
+
+    TEST_ASSERT_NULL(feed(reassembler, 200, 0, 2000, outLen));
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getMessagesEvicted());
+
+    // The next oldest, message 101, still completes
+    TEST_ASSERT_NULL(feed(reassembler, 101, 1, 3000, outLen));
+    TEST_ASSERT_NOT_NULL(feed(reassembler, 101, 2, 3000, outLen));
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getMessagesCompleted());
+
+    // Message 100 lost its first fragment: the rest only starts a new partial message
+    TEST_ASSERT_NULL(feed(reassembler, 100, 1, 3000, outLen));
+    TEST_ASSERT_NULL(feed(reassembler, 100, 2, 3000, outLen));
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getMessagesEvicted());
+
+    // Everything left over times out: 102, 103, 200 and the new 100
+    TEST_ASSERT_NULL(feed(reassembler, 300, 0, 3000 + 2 * REASSEMBLY_TIMEOUT_US, outLen));
+    TEST_ASSERT_EQUAL_UINT32(REASSEMBLY_SLOTS, reassembler.getMessagesIncomplete());
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Reassembly
+    RUN_TEST(test_reassemble_in_and_out_of_order);
+    RUN_TEST(test_duplicate_and_invalid_fragments);
+
+    // Expiry and eviction
+    RUN_TEST(test_timeout_expiry);
+    RUN_TEST(test_eviction_when_full);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
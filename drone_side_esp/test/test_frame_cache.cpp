@@ -0,0 +1,155 @@
+/**
+ * @file test_frame_cache.cpp
+ * @brief Unit tests for the periodic pattern frame cache
+ *
+ * Verifies that:
+ * 1. Stored frames are returned for the same key only
+ * 2. The cache stays within its budget, evicting the least recently used frame
+ * 3. Cached output is identical to rendering every frame
+ * 4. Replaying cached BRAINWAVE frames is faster than rendering them (benchmark)
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "frame_cache.h"
+#include "led_controller.h"
+#define SHARED_CONTROLLERS 2
+#include "shared_controller.h"
+
+void setUp() {
+    resetSharedControllers();
+}
+
+static FrameCacheKey makeKey(LedPattern pattern, uint16_t frame) {
+    return {pattern, CRGB(255, 0, 0), 0, 255, frame};
+}
+
+// Test a stored frame comes back for its key and not for others
+void test_cache_fetch_and_miss() {
+    static FrameCache<8> cache;
+    CRGB frame[8];
+    CRGB out[8];
+    fill_solid(frame, 8, CRGB(1, 2, 3));
+
+    TEST_ASSERT_FALSE(cache.fetch(makeKey(LedPattern::FLYING, 0), out));
+    cache.store(makeKey(LedPattern::FLYING, 0), frame);
+    TEST_ASSERT_TRUE(cache.fetch(makeKey(LedPattern::FLYING, 0), out));
+    TEST_ASSERT_TRUE(out[7] == CRGB(1, 2, 3));
+
+    TEST_ASSERT_FALSE(cache.fetch(makeKey(LedPattern::FLYING, 1), out));
+    TEST_ASSERT_FALSE(cache.fetch(makeKey(LedPattern::EMERGENCY, 0), out));
+    FrameCacheKey otherColor = makeKey(LedPattern::FLYING, 0);
+    otherColor.color = CRGB(0, 255, 0);
+    TEST_ASSERT_FALSE(cache.fetch(otherColor, out));
+
+    TEST_ASSERT_EQUAL_UINT32(1, cache.getHits());
+    TEST_ASSERT_EQUAL_UINT32(4, cache.getMisses());
+    TEST_ASSERT_EQUAL_UINT8(20, cache.getHitRatePercent());
+    TEST_ASSERT_EQUAL_UINT32(8 * sizeof(CRGB), cache.getBytesUsed());
+}
+
+// Test the budget holds and the least recently used frame is evicted
+void test_cache_budget_and_eviction() {
+    // One set of FRAME_CACHE_WAYS frames
+    static FrameCache<10, 10 * sizeof(CRGB) * FRAME_CACHE_WAYS> cache;
+    CRGB frame[10];
+    CRGB out[10];
+
+    for (uint16_t i = 0; i < FRAME_CACHE_WAYS; i++) {
+        fill_solid(frame, 10, CRGB(i, 0, 0));
+        cache.store(makeKey(LedPattern::BRAINWAVE, i), frame);
+    }
+    TEST_ASSERT_TRUE(cache.fetch(makeKey(LedPattern::BRAINWAVE, 0), out));  // Frame 1 is now the oldest
+
+    cache.store(makeKey(LedPattern::BRAINWAVE, 100), frame);
+    TEST_ASSERT_EQUAL_UINT32(1, cache.getEvictions());
+    TEST_ASSERT_EQUAL_UINT32(cache.getBudgetBytes(), cache.getBytesUsed());
+    TEST_ASSERT_FALSE(cache.fetch(makeKey(LedPattern::BRAINWAVE, 1), out));
+    TEST_ASSERT_TRUE(cache.fetch(makeKey(LedPattern::BRAINWAVE, 0), out));
+    TEST_ASSERT_TRUE(out[0] == CRGB(0, 0, 0));
+
+    cache.clear();
+    TEST_ASSERT_EQUAL_UINT32(0, cache.getBytesUsed());
+}
+
+// Test cached frames match freshly rendered ones for every cacheable pattern
+void test_cached_output_matches_rendered() {
+    LedController& cached = sharedController(0);
+    LedController& rendered = sharedController(1);
+    rendered.setFrameCacheEnabled(false);
+
+    const LedPattern patterns[] = {LedPattern::IDLE, LedPattern::HOVERING, LedPattern::BRAINWAVE,
+                                   LedPattern::TAKING_OFF};
+    for (LedPattern pattern : patterns) {
+        fakeNowUs = 1000000;
+        cached.setTransition(TransitionType::CUT, 0);
+        rendered.setTransition(TransitionType::CUT, 0);
+        cached.setPattern(pattern);
+        rendered.setPattern(pattern);
+
+        // Two full cycles at an irregular frame interval, so cycle 2 replays cycle 1
+        uint32_t periodUs = LedController::cyclePeriodUs(pattern, PatternDefaults::getDefault(pattern).speed);
+        uint32_t spanUs = periodUs ? 2 * periodUs : 100000;
+        for (uint32_t t = 0; t < spanUs; t += 997) {
+            fakeNowUs = 1000000 + t;
+            cached.update();
+            rendered.update();
+            TEST_ASSERT_EQUAL_MEMORY(rendered.getLeds(), cached.getLeds(), NUM_LEDS * sizeof(CRGB));
+        }
+    }
+
+    const FrameCache<NUM_LEDS>& cache = cached.getFrameCache();
+    TEST_ASSERT_TRUE(cache.getHitRatePercent() > 90);
+    TEST_ASSERT_TRUE(cache.getBytesUsed() <= cache.getBudgetBytes());
+    TEST_ASSERT_EQUAL_UINT32(0, rendered.getFrameCache().getHits() + rendered.getFrameCache().getMisses());
+}
+
+// Benchmark BRAINWAVE frames rendered vs replayed from the cache
+void test_cache_benchmark() {
+    LedController& controller = sharedController();
+    controller.setTransition(TransitionType::CUT, 0);
+    controller.setPattern(LedPattern::BRAINWAVE);
+    const uint32_t frames = 2000;
+    const uint32_t stepUs = PatternDefaults::SPEED_BRAINWAVE * 1000;  // One gradient step per frame
+
+    unsigned long elapsedUs[2];
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        controller.setFrameCacheEnabled(pass == 1);
+        fakeNowUs = 0;
+        controller.update();  // Warm-up: fills the cache on the cached pass
+
+        unsigned long start = micros();
+        for (uint32_t i = 0; i < frames; i++) {
+            fakeNowUs += stepUs;
+            controller.update();
+        }
+        elapsedUs[pass] = micros() - start;
+    }
+
+    Serial.printf("[BENCH] BRAINWAVE frame (%d LEDs): rendered %lu ns, cached %lu ns, hit rate %u%%\n",
+                  NUM_LEDS, elapsedUs[0] * 1000 / frames, elapsedUs[1] * 1000 / frames,
+                  controller.getFrameCache().getHitRatePercent());
+    TEST_ASSERT_TRUE(elapsedUs[1] < elapsedUs[0]);
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Cache tests
+    RUN_TEST(test_cache_fetch_and_miss);
+    RUN_TEST(test_cache_budget_and_eviction);
+
+    // Controller integration
+    RUN_TEST(test_cached_output_matches_rendered);
+
+    // Performance
+    RUN_TEST(test_cache_benchmark);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
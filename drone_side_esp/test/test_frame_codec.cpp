@@ -0,0 +1,213 @@
+/**
+ * @file test_frame_codec.cpp
+ * @brief Round-trip tests for the base frame encoder and the drone frame decoder
+ *
+ * Verifies that:
+ * 1. RAW, RLE and DELTA (with SKIP runs) frames decode to the encoded pixels
+ * 2. Truncated and overrunning payloads are rejected
+ * 3. A DELTA frame whose predecessor was lost is counted as undecodable
+ *    and playback resumes at the next keyframe
+ * 4. A stream paused past the timeout resumes at a keyframe, never a DELTA on pattern pixels
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "frame_stream.h"
+#include "frame_encoder.h"
+
+#define TEST_NUM_LEDS 40
+
+static uint8_t payload[FRAME_MAX_PAYLOAD];
+static uint32_t encodeUs = 0;  // Send time of round-trip frames, one frame apart at 60 fps
+
+static void fillNoise(uint8_t* rgb, uint8_t seed) {
+    uint32_t state = seed * 2654435761UL + 1;
+    for (uint16_t i = 0; i < TEST_NUM_LEDS * 3; i++) {
+        state = state * 1103515245UL + 12345;
+        rgb[i] = (uint8_t)(state >> 16);
+    }
+}
+
+// Encode rgb, decode it over leds and check the result matches
+static FrameEncoding roundTrip(FrameEncoder& encoder, const uint8_t* rgb, CRGB* leds) {
+    FrameEncoding encoding;
+    encodeUs += 16667;
+    size_t len = encoder.encode(rgb, TEST_NUM_LEDS, payload, sizeof(payload), encoding, encodeUs);
+    TEST_ASSERT_TRUE(len > 0);
+    TEST_ASSERT_TRUE(decodeFrame(encoding, payload, len, TEST_NUM_LEDS, leds, TEST_NUM_LEDS));
+    TEST_ASSERT_EQUAL_MEMORY(rgb, leds, TEST_NUM_LEDS * 3);
+    return encoding;
+}
+
+// Test every encoding reproduces the frame it encoded
+void test_round_trip_encodings() {
+    static FrameEncoder encoder;
+    uint8_t rgb[TEST_NUM_LEDS * 3];
+    CRGB leds[TEST_NUM_LEDS];
+
+    fillNoise(rgb, 1);
+    TEST_ASSERT_TRUE(roundTrip(encoder, rgb, leds) == FrameEncoding::RAW);  // Nothing repeats
+
+    memset(rgb, 0, sizeof(rgb));
+    for (uint16_t i = 0; i < TEST_NUM_LEDS; i++) {
+        rgb[i * 3 + (i < TEST_NUM_LEDS / 2 ? 0 : 2)] = 200;  // Two runs
+    }
+    TEST_ASSERT_TRUE(roundTrip(encoder, rgb, leds) == FrameEncoding::RLE);
+
+    // A few changed pixels: SKIP runs over the rest
+    rgb[5 * 3 + 1] = 77;
+    rgb[6 * 3 + 1] = 78;
+    rgb[30 * 3] = 1;
+    TEST_ASSERT_TRUE(roundTrip(encoder, rgb, leds) == FrameEncoding::DELTA);
+
+    // Unchanged frame: a DELTA of only SKIPs
+    TEST_ASSERT_TRUE(roundTrip(encoder, rgb, leds) == FrameEncoding::DELTA);
+    TEST_ASSERT_EQUAL_UINT32(2, encoder.getKeyframes());
+}
+
+// Test the periodic keyframe round-trips without depending on the framebuffer
+void test_round_trip_keyframe_interval() {
+    static FrameEncoder encoder;
+    uint8_t rgb[TEST_NUM_LEDS * 3];
+    CRGB leds[TEST_NUM_LEDS];
+    memset(rgb, 10, sizeof(rgb));
+    TEST_ASSERT_TRUE(roundTrip(encoder, rgb, leds) != FrameEncoding::DELTA);
+    for (uint16_t n = 1; n < FRAME_KEYFRAME_INTERVAL; n++) {
+        rgb[(n % TEST_NUM_LEDS) * 3] = (uint8_t)n;
+        TEST_ASSERT_TRUE(roundTrip(encoder, rgb, leds) == FrameEncoding::DELTA);
+    }
+
+    memset(leds, 0xFF, sizeof(leds));
+    TEST_ASSERT_TRUE(roundTrip(encoder, rgb, leds) != FrameEncoding::DELTA);
+}
+
+// Test truncated payloads and opcodes past the pixel count are rejected
+void test_truncated_payloads() {
+    FrameEncoder encoder;
+    uint8_t rgb[TEST_NUM_LEDS * 3];
+    CRGB leds[TEST_NUM_LEDS];
+    FrameEncoding encoding;
+
+    fillNoise(rgb, 2);
+    size_t len = encoder.encode(rgb, TEST_NUM_LEDS, payload, sizeof(payload), encoding, 0);
+    TEST_ASSERT_FALSE(decodeFrame(encoding, payload, len - 1, TEST_NUM_LEDS, leds, TEST_NUM_LEDS));
+
+    memset(rgb, 0, sizeof(rgb));
+    rgb[0] = 9;
+    len = encoder.encode(rgb, TEST_NUM_LEDS, payload, sizeof(payload), encoding, 16667);
+    TEST_ASSERT_TRUE(encoding == FrameEncoding::RLE);
+    for (size_t cut = 1; cut < len; cut++) {
+        TEST_ASSERT_FALSE(decodeFrame(encoding, payload, cut, TEST_NUM_LEDS, leds, TEST_NUM_LEDS));
+    }
+
+    // More pixels than the header announces
+    TEST_ASSERT_FALSE(decodeFrame(encoding, payload, len, TEST_NUM_LEDS - 1, leds, TEST_NUM_LEDS));
+
+    // SKIP is only valid in a DELTA frame
+    const uint8_t skipAll[] = {FRAME_OP_SKIP | (TEST_NUM_LEDS - 1)};
+    TEST_ASSERT_FALSE(decodeFrame(FrameEncoding::RLE, skipAll, sizeof(skipAll), TEST_NUM_LEDS, leds, TEST_NUM_LEDS));
+    TEST_ASSERT_TRUE(decodeFrame(FrameEncoding::DELTA, skipAll, sizeof(skipAll), TEST_NUM_LEDS, leds, TEST_NUM_LEDS));
+}
+
+// Test a DELTA frame after a lost frame is not applied, and the next keyframe recovers
+void test_delta_without_predecessor() {
+    static FrameStream<TEST_NUM_LEDS> stream;
+    static FrameEncoder encoder;
+    uint8_t rgb[TEST_NUM_LEDS * 3];
+    CRGB leds[TEST_NUM_LEDS];
+    FrameEncoding encoding;
+    uint32_t nowUs = 1000000;
+
+    auto send = [&](uint16_t frameNumber, bool deliver) {
+        size_t len = encoder.encode(rgb, TEST_NUM_LEDS, payload, sizeof(payload), encoding, nowUs);
+        if (deliver) {
+            stream.push(frameNumber, frameNumber * 16667, encoding, TEST_NUM_LEDS, payload, len, nowUs);
+        }
+        nowUs += 16667;
+        return stream.render(leds, nowUs + FRAME_JITTER_DELAY_US);
+    };
+
+    memset(rgb, 50, sizeof(rgb));
+    TEST_ASSERT_TRUE(send(1, true));
+    TEST_ASSERT_EQUAL_MEMORY(rgb, leds, sizeof(rgb));
+
+    rgb[3] = 99;
+    send(2, false);  // Lost on the air
+    rgb[6] = 98;
+    TEST_ASSERT_FALSE(send(3, true));
+    TEST_ASSERT_TRUE(encoding == FrameEncoding::DELTA);
+    TEST_ASSERT_EQUAL_UINT32(1, stream.getFramesUndecodable());
+    TEST_ASSERT_EQUAL_UINT8(50, leds[1].r);  // Still frame 1
+
+    // Deltas stay undecodable until the next keyframe
+    for (uint16_t n = 4; n < FRAME_KEYFRAME_INTERVAL + 1; n++) {
+        rgb[9] = (uint8_t)n;
+        send(n, true);
+    }
+    TEST_ASSERT_EQUAL_UINT32(FRAME_KEYFRAME_INTERVAL - 2, stream.getFramesUndecodable());
+    rgb[9] = 0;
+    TEST_ASSERT_TRUE(send(FRAME_KEYFRAME_INTERVAL + 1, true));
+    TEST_ASSERT_TRUE(encoding != FrameEncoding::DELTA);
+    TEST_ASSERT_EQUAL_MEMORY(rgb, leds, sizeof(rgb));
+}
+
+// Test a stream that pauses long enough to time out resumes only at a keyframe:
+// the encoder sends one, and the decoder never applies a DELTA to the pixels
+// drawn while the stream was off
+void test_paused_stream_resumes_with_keyframe() {
+    static FrameStream<TEST_NUM_LEDS> stream;
+    static FrameEncoder encoder;
+    uint8_t rgb[TEST_NUM_LEDS * 3];
+    CRGB leds[TEST_NUM_LEDS];
+    FrameEncoding encoding;
+    uint32_t nowUs = 1000000;
+
+    // Red frames stream, then stop for longer than the drone's timeout
+    memset(rgb, 0, sizeof(rgb));
+    for (uint16_t i = 0; i < TEST_NUM_LEDS; i++) {
+        rgb[i * 3] = 200;
+    }
+    size_t len = encoder.encode(rgb, TEST_NUM_LEDS, payload, sizeof(payload), encoding, nowUs);
+    stream.push(1, nowUs, encoding, TEST_NUM_LEDS, payload, len, nowUs);
+    TEST_ASSERT_TRUE(stream.render(leds, nowUs + FRAME_JITTER_DELAY_US));
+    nowUs += FRAME_STREAM_TIMEOUT_US;
+    TEST_ASSERT_FALSE(stream.isActive(nowUs));
+    fill_solid(leds, TEST_NUM_LEDS, CRGB(0, 0, 255));  // The pattern engine draws meanwhile
+
+    // A DELTA continuing the numbering (an encoder that ignored the pause) is not applied
+    rgb[0] = 201;
+    const uint8_t delta[] = {FRAME_OP_LITERAL, 201, 0, 0, FRAME_OP_SKIP | (TEST_NUM_LEDS - 2)};
+    stream.push(2, nowUs, FrameEncoding::DELTA, TEST_NUM_LEDS, delta, sizeof(delta), nowUs);
+    TEST_ASSERT_FALSE(stream.render(leds, nowUs + FRAME_JITTER_DELAY_US));
+    TEST_ASSERT_EQUAL_UINT32(1, stream.getFramesUndecodable());
+    TEST_ASSERT_TRUE(leds[1] == CRGB(0, 0, 255));
+
+    // The encoder sends a keyframe after the pause, which restores the stream
+    len = encoder.encode(rgb, TEST_NUM_LEDS, payload, sizeof(payload), encoding, nowUs + 16667);
+    TEST_ASSERT_TRUE(encoding != FrameEncoding::DELTA);
+    stream.push(3, nowUs + 16667, encoding, TEST_NUM_LEDS, payload, len, nowUs + 16667);
+    TEST_ASSERT_TRUE(stream.render(leds, nowUs + 16667 + FRAME_JITTER_DELAY_US));
+    TEST_ASSERT_EQUAL_MEMORY(rgb, leds, sizeof(rgb));
+    TEST_ASSERT_EQUAL_UINT32(2, encoder.getKeyframes());
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Encoder/decoder round trip
+    RUN_TEST(test_round_trip_encodings);
+    RUN_TEST(test_round_trip_keyframe_interval);
+    RUN_TEST(test_truncated_payloads);
+
+    // Streaming
+    RUN_TEST(test_delta_without_predecessor);
+    RUN_TEST(test_paused_stream_resumes_with_keyframe);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
@@ -0,0 +1,92 @@
+/**
+ * @file test_histogram.cpp
+ * @brief Unit tests for the log-scale timing histograms
+ *
+ * Verifies that:
+ * 1. Values land in power-of-two buckets, with large values in the last bucket
+ * 2. Percentiles report their bucket bound, and max is exact
+ * 3. The LED controller records render time per pattern, show time and frame jitter
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "histogram.h"
+#include "led_controller.h"
+#include "shared_controller.h"
+
+void setUp() {
+    resetSharedControllers();
+}
+
+// Test bucket boundaries
+void test_histogram_buckets() {
+    TEST_ASSERT_EQUAL_UINT8(0, LogHistogram::bucketFor(0));
+    TEST_ASSERT_EQUAL_UINT8(1, LogHistogram::bucketFor(1));
+    TEST_ASSERT_EQUAL_UINT8(2, LogHistogram::bucketFor(2));
+    TEST_ASSERT_EQUAL_UINT8(2, LogHistogram::bucketFor(3));
+    TEST_ASSERT_EQUAL_UINT8(11, LogHistogram::bucketFor(1024));
+    TEST_ASSERT_EQUAL_UINT8(HISTOGRAM_BUCKETS - 1, LogHistogram::bucketFor(1000000));
+    TEST_ASSERT_EQUAL_UINT8(HISTOGRAM_BUCKETS - 1, LogHistogram::bucketFor(UINT32_MAX));
+}
+
+// Test percentiles and max
+void test_histogram_percentiles() {
+    LogHistogram histogram;
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.percentileUs(50));
+
+    for (int i = 0; i < 98; i++) {
+        histogram.record(100);  // [64, 128)
+    }
+    histogram.record(3000);     // [2048, 4096)
+    histogram.record(90000);    // Last bucket
+
+    TEST_ASSERT_EQUAL_UINT32(100, histogram.getCount());
+    TEST_ASSERT_EQUAL_UINT32(98, histogram.getBucket(7));
+    TEST_ASSERT_EQUAL_UINT32(128, histogram.percentileUs(50));
+    TEST_ASSERT_EQUAL_UINT32(4096, histogram.percentileUs(99));
+    TEST_ASSERT_EQUAL_UINT32(90000, histogram.percentileUs(100));
+    TEST_ASSERT_EQUAL_UINT32(90000, histogram.getMaxUs());
+
+    histogram.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getCount());
+}
+
+// Test the controller feeds its histograms once per frame
+void test_controller_frame_histograms() {
+    LedController& controller = sharedController();
+    controller.setTransition(TransitionType::CUT, 0);
+    controller.setPattern(LedPattern::FLYING);
+    uint8_t slot = (uint8_t)LedPattern::FLYING;
+    uint32_t before = controller.getRenderTime(slot).getCount();
+
+    // Frames at 0, 10, 20 and 35 ms: intervals 10, 10, 15 ms
+    const unsigned long frameTimesUs[] = {0, 10000, 20000, 35000};
+    for (unsigned long t : frameTimesUs) {
+        fakeNowUs = 1000000 + t;
+        controller.update();
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(before + 4, controller.getRenderTime(slot).getCount());
+    TEST_ASSERT_EQUAL_UINT32(4, controller.getShowTime().getCount());
+    TEST_ASSERT_EQUAL_UINT32(2, controller.getFrameJitter().getCount());
+    TEST_ASSERT_EQUAL_UINT32(5000, controller.getFrameJitter().getMaxUs());
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Histogram tests
+    RUN_TEST(test_histogram_buckets);
+    RUN_TEST(test_histogram_percentiles);
+
+    // Controller integration
+    RUN_TEST(test_controller_frame_histograms);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
@@ -0,0 +1,259 @@
+/**
+ * @file test_led_command_parser.cpp
+ * @brief Unit tests for the zero-allocation led_command scanner
+ *
+ * Verifies that:
+ * 1. Valid commands decode every field, with defaults for absent ones
+ * 2. Rejected messages report the same reason the handler logged before
+ * 3. The scanner agrees with the ArduinoJson parser on a corpus of messages
+ * 4. Parsing is faster than deserializing into a StaticJsonDocument
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "led_command_parser.h"
+
+// Reference parser: the ArduinoJson logic the scanner replaced in EspNowHandler
+static bool referenceParse(const char* json, LedCommand& out) {
+    StaticJsonDocument<250> doc;
+    if (deserializeJson(doc, json)) {
+        return false;
+    }
+    const char* type = doc["type"];
+    if (!type || strcmp(type, "led_command") != 0) {
+        return false;
+    }
+    JsonObject dataObj = doc["data"];
+    if (!dataObj) {
+        return false;
+    }
+    const char* patternStr = dataObj["pattern"];
+    if (!patternStr) {
+        return false;
+    }
+
+    LedPattern pattern = stringToPattern(patternStr);
+    out.config = PatternDefaults::getDefault(pattern);
+    if (dataObj.containsKey("color")) {
+        JsonArray colorArray = dataObj["color"];
+        if (colorArray.size() >= 3) {
+            out.config.color = CRGB(colorArray[0].as<uint8_t>(), colorArray[1].as<uint8_t>(),
+                                    colorArray[2].as<uint8_t>());
+        }
+    }
+    if (dataObj.containsKey("brightness")) {
+        out.config.brightness = dataObj["brightness"].as<uint8_t>();
+    }
+    if (dataObj.containsKey("speed")) {
+        out.config.speed = dataObj["speed"].as<uint16_t>();
+    }
+
+    out.layer = {LayerId::BASE, BlendMode::NORMAL, 255, SEGMENT_MAIN};
+    out.layer.layer = stringToLayer(dataObj["layer"]);
+    out.layer.blend = stringToBlendMode(dataObj["blend"]);
+    if (dataObj.containsKey("opacity")) {
+        out.layer.opacity = dataObj["opacity"].as<uint8_t>();
+    }
+    if (dataObj.containsKey("segment")) {
+        out.layer.segment = dataObj["segment"].as<uint8_t>();
+    }
+
+    out.priority = {defaultPriority(pattern), 0, false};
+    if (dataObj.containsKey("priority")) {
+        out.priority.priority = stringToPriority(dataObj["priority"]);
+    }
+    if (dataObj.containsKey("ttl")) {
+        out.priority.ttlMs = dataObj["ttl"].as<uint32_t>();
+    }
+    if (dataObj.containsKey("clear")) {
+        out.priority.clear = dataObj["clear"].as<bool>();
+    }
+    out.timestamp = doc["timestamp"].as<uint64_t>();
+    return true;
+}
+
+static bool scan(const char* json, LedCommand& out) {
+    LedCommandScanner scanner;
+    return scanner.parse(json, json ? strlen(json) : 0, out);
+}
+
+static LedCommandError scanError(const char* json) {
+    LedCommandScanner scanner;
+    LedCommand command;
+    scanner.parse(json, strlen(json), command);
+    return scanner.getError();
+}
+
+// Test a command with every field set
+void test_scan_all_fields() {
+    const char* json = R"({"type":"led_command","data":{"pattern":"FLYING","color":[1,2,3],"brightness":40,)"
+                       R"("speed":700,"layer":"OVERLAY","blend":"ADD","opacity":90,"priority":"HIGH","ttl":1500,)"
+                       R"("clear":true,"segment":2},"timestamp":1699564800000})";
+    LedCommand command;
+
+    TEST_ASSERT_TRUE(scan(json, command));
+    TEST_ASSERT_EQUAL(LedPattern::FLYING, command.config.pattern);
+    TEST_ASSERT_TRUE(command.config.color == CRGB(1, 2, 3));
+    TEST_ASSERT_EQUAL_UINT8(40, command.config.brightness);
+    TEST_ASSERT_EQUAL_UINT16(700, command.config.speed);
+    TEST_ASSERT_EQUAL(LayerId::OVERLAY, command.layer.layer);
+    TEST_ASSERT_EQUAL(BlendMode::ADD, command.layer.blend);
+    TEST_ASSERT_EQUAL_UINT8(90, command.layer.opacity);
+    TEST_ASSERT_EQUAL_UINT8(2, command.layer.segment);
+    TEST_ASSERT_EQUAL(PatternPriority::HIGH, command.priority.priority);
+    TEST_ASSERT_EQUAL_UINT32(1500, command.priority.ttlMs);
+    TEST_ASSERT_TRUE(command.priority.clear);
+    TEST_ASSERT_TRUE(command.timestamp == 1699564800000ULL);
+}
+
+// Test absent fields take the pattern defaults
+void test_scan_defaults() {
+    LedCommand command;
+    TEST_ASSERT_TRUE(scan(R"({"type":"led_command","data":{"pattern":"EMERGENCY"}})", command));
+
+    PatternConfig defaults = PatternDefaults::getDefault(LedPattern::EMERGENCY);
+    TEST_ASSERT_TRUE(command.config.color == defaults.color);
+    TEST_ASSERT_EQUAL_UINT8(defaults.brightness, command.config.brightness);
+    TEST_ASSERT_EQUAL_UINT16(defaults.speed, command.config.speed);
+    TEST_ASSERT_EQUAL(LayerId::BASE, command.layer.layer);
+    TEST_ASSERT_EQUAL_UINT8(255, command.layer.opacity);
+    TEST_ASSERT_EQUAL_UINT8(SEGMENT_MAIN, command.layer.segment);
+    TEST_ASSERT_EQUAL(PatternPriority::CRITICAL, command.priority.priority);
+    TEST_ASSERT_FALSE(command.priority.clear);
+}
+
+// Test messages larger than the old 250-byte document still parse
+void test_scan_long_message() {
+    char json[600];
+    snprintf(json, sizeof(json),
+             R"({"type":"led_command","data":{"pattern":"LANDING","note":"%0300d","brightness":7}})", 0);
+    LedCommand command;
+
+    TEST_ASSERT_TRUE(scan(json, command));
+    TEST_ASSERT_EQUAL(LedPattern::LANDING, command.config.pattern);
+    TEST_ASSERT_EQUAL_UINT8(7, command.config.brightness);
+}
+
+// Test each rejection reports its reason
+void test_scan_errors() {
+    TEST_ASSERT_EQUAL(LedCommandError::SYNTAX, scanError(R"({"type":"led_command","data":{"pattern":"FLYING")"));
+    TEST_ASSERT_EQUAL(LedCommandError::SYNTAX, scanError(""));
+    TEST_ASSERT_EQUAL(LedCommandError::INVALID_TYPE, scanError(R"({"type":"other","data":{"pattern":"FLYING"}})"));
+    TEST_ASSERT_EQUAL(LedCommandError::INVALID_TYPE, scanError("[1,2]"));
+    TEST_ASSERT_EQUAL(LedCommandError::MISSING_DATA, scanError(R"({"type":"led_command","data":[1]})"));
+    TEST_ASSERT_EQUAL(LedCommandError::MISSING_PATTERN, scanError(R"({"type":"led_command","data":{"pattern":5}})"));
+
+    LedCommand command;
+    TEST_ASSERT_FALSE(scan(nullptr, command));
+}
+
+// Test the scanner and ArduinoJson agree, field by field, on every corpus message
+void test_scan_matches_arduinojson() {
+    static const char* corpus[] = {
+        R"({"type":"led_command","data":{"pattern":"FLYING"},"timestamp":1699564800000})",
+        R"({"type":"led_command","data":{"pattern":"IDLE","color":[255,128]}})",
+        R"({"type":"led_command","data":{"pattern":"IDLE","color":[300,-1,12.7,9]}})",
+        R"({"type":"led_command","data":{"pattern":"IDLE","color":"red"}})",
+        R"({"type":"led_command","data":{"pattern":"IDLE","brightness":256,"speed":-5}})",
+        R"({"type":"led_command","data":{"pattern":"IDLE","brightness":"42","speed":1e3}})",
+        R"({"type":"led_command","data":{"pattern":"IDLE","brightness":true,"speed":null}})",
+        R"({"type":"led_command","data":{"pattern":"HOVERING","ttl":4294967296,"clear":0}})",
+        R"({"type":"led_command","data":{"pattern":"HOVERING","ttl":12,"clear":"no"}})",
+        R"({"type":"led_command","data":{"pattern":"FLYING","priority":"BOGUS","layer":"ALERT"}})",
+        R"({"type":"led_command","data":{"pattern":"EMERGENCY","priority":null}})",
+        R"({"type":"led_command","data":{"pattern":"FLYING","blend":"LIGHTEN"}})",
+        R"({"type":"led_command","data":{"pattern":"LOW_BATTERY","segment":3}})",
+        R"({"type":"led_command","data":{"pattern":"LOW_BATTERY","segment":300}})",
+        R"({"type":"led_command","data":{"pattern":"LOW_BATTERY","segment":"1"}})",
+        R"({"type":"led_command","data":{"pattern":"IDLE"},"data":{"pattern":"FLYING"}})",
+        R"({"type":"led_command","data":{"pattern":"IDLE"},"data":5})",
+        R"({"type":"led_command","data":{"pattern":"IDLE","x":{"y":[1,{"z":null}]}}})",
+        R"({"type":"led_command","data":{"pattern":"LOW_BATTERY"}} trailing)",
+        R"(  {"type" : "led_command" , "data" : { "pattern" : "LANDING" } }  )",
+        R"({'type':'led_command','data':{'pattern':'TAKING_OFF'}})",
+        R"({type:"led_command",data:{pattern:"BRAINWAVE"}})",
+        R"({"type":"led_command","data":{"pattern":"FLYING",}})",
+        R"({"type":"led_command","data":{"pattern":"FLYING"})",
+        R"({"type":"led_command","data":{"pattern":"FLYING\q"}})",
+        R"({"type":"led_command","data":{"pattern":"FLYING"}, "timestamp":-1})",
+        R"({"type":"led_command","data":{"pattern":"A_VERY_LONG_PATTERN_NAME_THAT_MATCHES_NOTHING"}})",
+        R"({"data":{"pattern":"FLYING"}})",
+        R"("led_command")",
+        "null",
+    };
+
+    for (const char* json : corpus) {
+        LedCommand expected = {};
+        LedCommand actual = {};
+        bool expectedOk = referenceParse(json, expected);
+        bool actualOk = scan(json, actual);
+
+        TEST_ASSERT_EQUAL_MESSAGE(expectedOk, actualOk, json);
+        if (!expectedOk) {
+            continue;
+        }
+        TEST_ASSERT_EQUAL_MESSAGE(expected.config.pattern, actual.config.pattern, json);
+        TEST_ASSERT_TRUE_MESSAGE(expected.config.color == actual.config.color, json);
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(expected.config.brightness, actual.config.brightness, json);
+        TEST_ASSERT_EQUAL_UINT16_MESSAGE(expected.config.speed, actual.config.speed, json);
+        TEST_ASSERT_EQUAL_MESSAGE(expected.layer.layer, actual.layer.layer, json);
+        TEST_ASSERT_EQUAL_MESSAGE(expected.layer.blend, actual.layer.blend, json);
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(expected.layer.opacity, actual.layer.opacity, json);
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(expected.layer.segment, actual.layer.segment, json);
+        TEST_ASSERT_EQUAL_MESSAGE(expected.priority.priority, actual.priority.priority, json);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected.priority.ttlMs, actual.priority.ttlMs, json);
+        TEST_ASSERT_EQUAL_MESSAGE(expected.priority.clear, actual.priority.clear, json);
+        TEST_ASSERT_TRUE_MESSAGE(expected.timestamp == actual.timestamp, json);
+    }
+}
+
+// Benchmark a typical command through both parsers
+void test_scan_benchmark() {
+    const char* json = R"({"type":"led_command","data":{"pattern":"FLYING","color":[0,255,0],"brightness":200,)"
+                       R"("speed":300,"priority":"HIGH","ttl":2000},"timestamp":1699564800000})";
+    const uint32_t iterations = 2000;
+    LedCommand command;
+    uint32_t ok = 0;
+
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < iterations; i++) {
+        ok += referenceParse(json, command);
+    }
+    unsigned long referenceUs = micros() - start;
+
+    start = micros();
+    for (uint32_t i = 0; i < iterations; i++) {
+        ok += scan(json, command);
+    }
+    unsigned long scannerUs = micros() - start;
+
+    Serial.printf("[BENCH] ArduinoJson: %lu ns/msg, scanner: %lu ns/msg\n",
+                  referenceUs * 1000 / iterations, scannerUs * 1000 / iterations);
+    TEST_ASSERT_EQUAL_UINT32(2 * iterations, ok);
+    TEST_ASSERT_TRUE(scannerUs < referenceUs);
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Decoding tests
+    RUN_TEST(test_scan_all_fields);
+    RUN_TEST(test_scan_defaults);
+    RUN_TEST(test_scan_long_message);
+    RUN_TEST(test_scan_errors);
+
+    // Equivalence with ArduinoJson
+    RUN_TEST(test_scan_matches_arduinojson);
+
+    // Performance
+    RUN_TEST(test_scan_benchmark);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
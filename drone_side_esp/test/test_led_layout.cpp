@@ -0,0 +1,288 @@
+/**
+ * @file test_led_layout.cpp
+ * @brief Unit tests for the physical LED layout map
+ *
+ * Verifies that:
+ * 1. Runs build the logical-to-physical map, including reversed (serpentine) runs
+ * 2. Layouts that do not cover every LED exactly once are rejected
+ * 3. Line and ring runs give normalized coordinates
+ * 4. The output stage writes each logical LED to its physical position, on both paths
+ * 5. TAKING_OFF's upward flow on a four-arm layout lights equal heights on every arm together,
+ *    and its head moves smoothly between LEDs on the default straight layout
+ * 6. Remapping at the output stage costs little over the unmapped pass (benchmark)
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "led_layout.h"
+#include "output_stage.h"
+#include "led_controller.h"
+#include "shared_controller.h"
+
+void setUp() {
+    resetSharedControllers();
+}
+
+#define TEST_NUM_LEDS 12
+
+// Three arms of four LEDs, the middle one wired top to bottom
+static const LayoutRun SERPENTINE[] = {
+    {0, 4, false, LayoutShape::LINE, {0, 0, 0}, {0, 30, 0}},
+    {4, 4, true, LayoutShape::LINE, {100, 0, 0}, {100, 30, 0}},
+    {8, 4, false, LayoutShape::LINE, {200, 0, 0}, {200, 30, 0}},
+};
+
+// Test the index map of a serpentine strip and of a strip in wire order
+void test_serpentine_map() {
+    LedLayout<TEST_NUM_LEDS> layout;
+    TEST_ASSERT_NULL(layout.getPhysicalMap());
+    TEST_ASSERT_NULL(layout.getPoints());
+
+    TEST_ASSERT_TRUE(layout.load(SERPENTINE, 3));
+    const uint16_t expected[TEST_NUM_LEDS] = {0, 1, 2, 3, 7, 6, 5, 4, 8, 9, 10, 11};
+    TEST_ASSERT_NOT_NULL(layout.getPhysicalMap());
+    for (uint16_t i = 0; i < TEST_NUM_LEDS; i++) {
+        TEST_ASSERT_EQUAL_UINT16(expected[i], layout.getPhysicalMap()[i]);
+    }
+
+    // Runs listed out of wire order still map, and a straight strip needs no map
+    const LayoutRun swapped[] = {
+        {6, 6, false, LayoutShape::LINE, {0, 0, 0}, {0, 50, 0}},
+        {0, 6, false, LayoutShape::LINE, {0, 60, 0}, {0, 110, 0}},
+    };
+    TEST_ASSERT_TRUE(layout.load(swapped, 2));
+    TEST_ASSERT_EQUAL_UINT16(6, layout.physicalIndex(0));
+    TEST_ASSERT_EQUAL_UINT16(0, layout.physicalIndex(6));
+
+    const LayoutRun straight[] = {{0, TEST_NUM_LEDS, false, LayoutShape::LINE, {0, 0, 0}, {0, 100, 0}}};
+    TEST_ASSERT_TRUE(layout.load(straight, 1));
+    TEST_ASSERT_NULL(layout.getPhysicalMap());
+    TEST_ASSERT_NOT_NULL(layout.getPoints());
+}
+
+// Test overlapping, short and out-of-range layouts are rejected
+void test_invalid_layout_rejected() {
+    LedLayout<TEST_NUM_LEDS> layout;
+    TEST_ASSERT_TRUE(layout.load(SERPENTINE, 3));
+
+    const LayoutRun overlap[] = {
+        {0, 6, false, LayoutShape::LINE, {0, 0, 0}, {0, 10, 0}},
+        {5, 6, false, LayoutShape::LINE, {0, 0, 0}, {0, 10, 0}},
+    };
+    const LayoutRun shortRuns[] = {{0, 11, false, LayoutShape::LINE, {0, 0, 0}, {0, 10, 0}}};
+    const LayoutRun outOfRange[] = {{4, 12, false, LayoutShape::LINE, {0, 0, 0}, {0, 10, 0}}};
+    const LayoutRun empty[] = {
+        {0, 0, false, LayoutShape::LINE, {0, 0, 0}, {0, 10, 0}},
+        {0, 12, false, LayoutShape::LINE, {0, 0, 0}, {0, 10, 0}},
+    };
+    TEST_ASSERT_FALSE(layout.load(overlap, 2));
+    TEST_ASSERT_FALSE(layout.load(shortRuns, 1));
+    TEST_ASSERT_FALSE(layout.load(outOfRange, 1));
+    TEST_ASSERT_FALSE(layout.load(empty, 2));
+
+    // The serpentine layout is still in place
+    TEST_ASSERT_EQUAL_UINT16(7, layout.physicalIndex(4));
+}
+
+// Test line interpolation, per-axis normalization and ring placement
+void test_coordinates() {
+    LedLayout<TEST_NUM_LEDS> layout;
+    TEST_ASSERT_TRUE(layout.load(SERPENTINE, 3));
+
+    // Logical order runs bottom to top on every arm, whatever the wiring
+    TEST_ASSERT_EQUAL_UINT8(0, layout.point(0).y);
+    TEST_ASSERT_EQUAL_UINT8(255, layout.point(3).y);
+    TEST_ASSERT_EQUAL_UINT8(0, layout.point(4).y);
+    TEST_ASSERT_EQUAL_UINT8(85, layout.point(5).y);
+    TEST_ASSERT_EQUAL_UINT8(128, layout.point(4).x);
+    TEST_ASSERT_EQUAL_UINT8(255, layout.point(11).x);
+    TEST_ASSERT_EQUAL_UINT8(0, layout.point(11).z);  // Flat axis
+    TEST_ASSERT_EQUAL_UINT16(85 * 256, layout.getPitch256());  // Height between LEDs of an arm
+
+    // A ring of 8 around (0, 50, 0) starting at +x, above a 4 LED line
+    const LayoutRun ringOnPole[] = {
+        {0, 4, false, LayoutShape::LINE, {0, 0, 0}, {0, 40, 0}},
+        {4, 8, false, LayoutShape::RING, {0, 0, 0}, {100, 50, 0}},
+    };
+    TEST_ASSERT_TRUE(layout.load(ringOnPole, 2));
+    TEST_ASSERT_EQUAL_UINT8(255, layout.point(4).x);
+    TEST_ASSERT_EQUAL_UINT8(128, layout.point(4).z);
+    TEST_ASSERT_EQUAL_UINT8(255, layout.point(6).z);  // A quarter turn
+    TEST_ASSERT_EQUAL_UINT8(0, layout.point(8).x);    // Half a turn
+    for (uint16_t i = 4; i < TEST_NUM_LEDS; i++) {
+        TEST_ASSERT_EQUAL_UINT8(255, layout.point(i).y);
+    }
+    TEST_ASSERT_EQUAL_UINT8(128, layout.point(0).x);  // The pole is on the ring's axis
+    TEST_ASSERT_EQUAL_UINT16(68 * 256, layout.getPitch256());  // Rings do not count
+}
+
+// Test the output stage scatters logical pixels to their wire positions
+void test_output_stage_remap() {
+    LedLayout<TEST_NUM_LEDS> layout;
+    TEST_ASSERT_TRUE(layout.load(SERPENTINE, 3));
+    const uint16_t* map = layout.getPhysicalMap();
+    OutputStage stage;
+    stage.setGamma(1.0f);
+    stage.setCurrentBudget(0);
+
+    CRGB in[TEST_NUM_LEDS];
+    CRGB out[TEST_NUM_LEDS];
+    for (uint16_t i = 0; i < TEST_NUM_LEDS; i++) {
+        in[i] = CRGB(i, 100 + i, 200 + i);
+    }
+    stage.apply<GRB>(out, in, TEST_NUM_LEDS, map);
+    for (uint16_t i = 0; i < TEST_NUM_LEDS; i++) {
+        TEST_ASSERT_EQUAL_UINT8(100 + i, out[map[i]].raw[0]);
+        TEST_ASSERT_EQUAL_UINT8(i, out[map[i]].raw[1]);
+    }
+
+    // The dithered path maps the same way
+    CRGB16 in16[TEST_NUM_LEDS];
+    uint8_t residue[TEST_NUM_LEDS * 3] = {};
+    for (uint16_t i = 0; i < TEST_NUM_LEDS; i++) {
+        in16[i] = {(uint16_t)(i << 8), (uint16_t)((100 + i) << 8), (uint16_t)((200 + i) << 8)};
+    }
+    CRGB dithered[TEST_NUM_LEDS];
+    stage.applyDithered<GRB>(dithered, in16, residue, TEST_NUM_LEDS, map);
+    TEST_ASSERT_EQUAL_MEMORY(out, dithered, sizeof(out));
+}
+
+// Test a vertical sweep reaches the same height on all four arms at once
+void test_vertical_sweep_across_arms() {
+    // Four arms of 6 wired as one serpentine strip, then a 6 LED ring on top
+    const LayoutRun arms[] = {
+        {0, 6, false, LayoutShape::LINE, {-60, 0, -60}, {-60, 50, -60}},
+        {6, 6, true, LayoutShape::LINE, {60, 0, -60}, {60, 50, -60}},
+        {12, 6, false, LayoutShape::LINE, {60, 0, 60}, {60, 50, 60}},
+        {18, 6, true, LayoutShape::LINE, {-60, 0, 60}, {-60, 50, 60}},
+        {24, 6, false, LayoutShape::RING, {0, 0, 0}, {40, 60, 0}},
+    };
+    LedController& controller = sharedController();
+    TEST_ASSERT_TRUE(controller.setLayout(arms, 5));
+    controller.setBrightness(255);
+    controller.setGamma(1.0f);
+    controller.setTransition(TransitionType::CUT, 0);
+    PatternConfig config = PatternDefaults::getDefault(LedPattern::TAKING_OFF);
+    config.brightness = 255;
+    controller.setPattern(config);
+    const LedLayout<NUM_LEDS>& layout = controller.getLayout();
+
+    uint16_t framesLit = 0;
+    for (uint32_t step = 0; step < 40; step++) {
+        fakeNowUs += config.speed * 1000UL / 40;
+        controller.update();
+        const CRGB* wire = controller.getOutput();
+
+        // The n-th LED from the bottom of each arm shows the same color
+        for (uint16_t n = 0; n < 6; n++) {
+            const CRGB& first = wire[layout.physicalIndex(n)];
+            for (uint16_t arm = 1; arm < 4; arm++) {
+                TEST_ASSERT_TRUE(first == wire[layout.physicalIndex(arm * 6 + n)]);
+            }
+        }
+        // So does every LED of the ring
+        for (uint16_t i = 25; i < 30; i++) {
+            TEST_ASSERT_TRUE(wire[layout.physicalIndex(24)] == wire[layout.physicalIndex(i)]);
+        }
+        framesLit += wire[layout.physicalIndex(0)] != CRGB(0, 0, 0);
+    }
+    TEST_ASSERT_TRUE(framesLit > 0 && framesLit < 40);
+
+    // Rejected layouts leave the current one in place
+    TEST_ASSERT_FALSE(controller.setLayout(arms, 4));
+    TEST_ASSERT_EQUAL_UINT16(11, layout.physicalIndex(6));
+}
+
+// Test the flow head moves smoothly on the default layout, one straight line run
+// (main.cpp), as it does on a strip without a layout
+void test_default_layout_sweep_smooth() {
+    const LayoutRun straight[] = {
+        {0, NUM_LEDS, false, LayoutShape::LINE, {0, 0, 0}, {0, NUM_LEDS * 16, 0}},
+    };
+    LedController& controller = sharedController();
+    TEST_ASSERT_TRUE(controller.setLayout(straight, 1));
+    controller.setGamma(1.0f);
+    controller.setTransition(TransitionType::CUT, 0);
+    PatternConfig config = PatternDefaults::getDefault(LedPattern::TAKING_OFF);
+    config.brightness = 255;
+    config.speed = 3200;
+    controller.setPattern(config);
+
+    // Eight steps per LED pitch: no LED may jump more than about an eighth of full brightness
+    const uint16_t steps = 8 * NUM_LEDS;
+    CRGB previous[NUM_LEDS];
+    controller.update();
+    memcpy(previous, controller.getLeds(), sizeof(previous));
+    uint8_t largestStep = 0;
+    for (uint16_t step = 1; step < steps; step++) {
+        fakeNowUs += config.speed * 1000UL / (steps + 8 * 10);  // The cycle also covers the tail
+        controller.update();
+        const CRGB* leds = controller.getLeds();
+        for (uint16_t i = 0; i < NUM_LEDS; i++) {
+            uint8_t change = abs((int)leds[i].g - (int)previous[i].g);
+            largestStep = max(largestStep, change);
+        }
+        memcpy(previous, leds, sizeof(previous));
+    }
+    TEST_ASSERT_TRUE(largestStep > 0);
+    TEST_ASSERT_TRUE(largestStep <= 40);
+}
+
+// Benchmark the output stage with and without a layout map
+void test_remap_benchmark() {
+    const uint16_t numLeds = NUM_LEDS;
+    const uint32_t iterations = 2000;
+    static LedLayout<NUM_LEDS> layout;
+    const LayoutRun serpentine[] = {
+        {0, NUM_LEDS / 2, false, LayoutShape::LINE, {0, 0, 0}, {0, 100, 0}},
+        {NUM_LEDS / 2, NUM_LEDS - NUM_LEDS / 2, true, LayoutShape::LINE, {50, 0, 0}, {50, 100, 0}},
+    };
+    TEST_ASSERT_TRUE(layout.load(serpentine, 2));
+    OutputStage stage;
+    CRGB frame[NUM_LEDS];
+    CRGB out[NUM_LEDS];
+    for (uint16_t i = 0; i < numLeds; i++) {
+        frame[i] = CRGB(i * 7, i * 13, i * 29);
+    }
+
+    unsigned long start = micros();
+    for (uint32_t n = 0; n < iterations; n++) {
+        stage.apply<GRB>(out, frame, numLeds);
+    }
+    unsigned long plainUs = micros() - start;
+
+    start = micros();
+    for (uint32_t n = 0; n < iterations; n++) {
+        stage.apply<GRB>(out, frame, numLeds, layout.getPhysicalMap());
+    }
+    unsigned long mappedUs = micros() - start;
+
+    Serial.printf("[BENCH] Output stage (%u LEDs): wire order %lu ns/frame, remapped %lu ns/frame\n",
+                  numLeds, plainUs * 1000 / iterations, mappedUs * 1000 / iterations);
+    TEST_ASSERT_TRUE(mappedUs < plainUs * 2 + 1000);
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Layout map tests
+    RUN_TEST(test_serpentine_map);
+    RUN_TEST(test_invalid_layout_rejected);
+    RUN_TEST(test_coordinates);
+
+    // Output stage and pattern tests
+    RUN_TEST(test_output_stage_remap);
+    RUN_TEST(test_vertical_sweep_across_arms);
+    RUN_TEST(test_default_layout_sweep_smooth);
+
+    // Performance
+    RUN_TEST(test_remap_benchmark);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
@@ -0,0 +1,108 @@
+/**
+ * @file test_log_ring.cpp
+ * @brief Unit tests for the asynchronous log ring
+ *
+ * Verifies that:
+ * 1. Lines are formatted into the ring and drained in order
+ * 2. A full ring drops and counts lines instead of blocking
+ * 3. Over-long lines are truncated but keep their line break
+ * 4. Lines above LOG_LEVEL are compiled out, arguments included
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "log_ring.h"
+
+static int evaluations = 0;
+
+static int countEvaluation() {
+    return ++evaluations;
+}
+
+// Test lines come out in the order they were logged
+void test_log_ring_order() {
+    static LogRing ring;
+    size_t len;
+
+    TEST_ASSERT_NULL(ring.peek(len));
+    TEST_ASSERT_TRUE(ring.printf("[LED] first %d\n", 1));
+    TEST_ASSERT_TRUE(ring.printf("[LED] second %s\n", "line"));
+
+    const char* text = ring.peek(len);
+    TEST_ASSERT_EQUAL(strlen("[LED] first 1\n"), len);
+    TEST_ASSERT_EQUAL_MEMORY("[LED] first 1\n", text, len);
+    ring.release();
+
+    text = ring.peek(len);
+    TEST_ASSERT_EQUAL_MEMORY("[LED] second line\n", text, len);
+    ring.release();
+    TEST_ASSERT_NULL(ring.peek(len));
+    TEST_ASSERT_EQUAL_UINT32(2, ring.getLinesWritten());
+}
+
+// Test a full ring drops new lines until it is drained
+void test_log_ring_drops_when_full() {
+    static LogRing ring;
+    size_t len;
+
+    for (uint32_t i = 0; i < LOG_RING_SLOTS; i++) {
+        TEST_ASSERT_TRUE(ring.printf("line %u\n", (unsigned)i));
+    }
+    TEST_ASSERT_FALSE(ring.printf("overflow\n"));
+    TEST_ASSERT_EQUAL_UINT32(1, ring.getLinesDropped());
+
+    // Draining one line makes room for one more, which comes out last
+    ring.release();
+    TEST_ASSERT_TRUE(ring.printf("after\n"));
+    for (uint32_t i = 1; i < LOG_RING_SLOTS; i++) {
+        ring.release();
+    }
+    const char* text = ring.peek(len);
+    TEST_ASSERT_EQUAL_MEMORY("after\n", text, len);
+}
+
+// Test an over-long line is cut to LOG_LINE_MAX and still ends the line
+void test_log_ring_truncates() {
+    static LogRing ring;
+    char longLine[LOG_LINE_MAX * 2];
+    memset(longLine, 'x', sizeof(longLine) - 1);
+    longLine[sizeof(longLine) - 1] = '\0';
+    size_t len;
+
+    ring.printf("%s\n", longLine);
+    const char* text = ring.peek(len);
+    TEST_ASSERT_EQUAL(LOG_LINE_MAX - 1, len);
+    TEST_ASSERT_EQUAL('\n', text[len - 1]);
+}
+
+// Test only lines at or below LOG_LEVEL reach the ring
+void test_log_level_elision() {
+    evaluations = 0;
+    uint32_t before = logRing().getLinesWritten() + logRing().getLinesDropped();
+
+    LOG_INFO("TEST", "kept %d", countEvaluation());
+    LOG_DEBUG("TEST", "elided %d", countEvaluation());
+
+    TEST_ASSERT_EQUAL(LOG_LEVEL >= LOG_LEVEL_DEBUG ? 2 : 1, evaluations);
+    TEST_ASSERT_EQUAL_UINT32(before + evaluations, logRing().getLinesWritten() + logRing().getLinesDropped());
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Ring buffer tests
+    RUN_TEST(test_log_ring_order);
+    RUN_TEST(test_log_ring_drops_when_full);
+    RUN_TEST(test_log_ring_truncates);
+
+    // Level filtering tests
+    RUN_TEST(test_log_level_elision);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
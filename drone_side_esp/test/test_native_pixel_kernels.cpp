@@ -0,0 +1,230 @@
+/**
+ * @file test_native_pixel_kernels.cpp
+ * @brief Host tests for the pixel kernel variants
+ *
+ * Runs in the native environment (pio test -e native). Every variant available
+ * on the host is checked, including the 32-bit SWAR variant used on the ESP32-S3.
+ *
+ * Verifies that:
+ * 1. The scalar reference matches FastLED's scale8, blend8 and qadd8 for all inputs
+ * 2. Every variant produces the scalar reference's bytes, at any length and alignment
+ * 3. Kernels work in place (output aliasing an input)
+ * 4. Timing of each variant against the scalar reference (benchmark, printed only)
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include "pixel_kernels.h"
+
+using namespace PixelKernels;
+
+struct KernelVariant {
+    const char* name;
+    void (*fill)(uint8_t*, const uint8_t*, size_t);
+    void (*scale)(uint8_t*, const uint8_t*, uint8_t, size_t);
+    void (*blend)(uint8_t*, const uint8_t*, const uint8_t*, uint8_t, size_t);
+    void (*addSaturate)(uint8_t*, const uint8_t*, const uint8_t*, size_t);
+    void (*palette)(uint8_t*, const uint8_t*, const uint8_t*, size_t);
+};
+
+static const KernelVariant VARIANTS[] = {
+    {"scalar", Scalar::fill, Scalar::scale, Scalar::blend, Scalar::addSaturate, Scalar::palette},
+    {"swar32", Swar::fill, Swar::scale, Swar::blend, Swar::addSaturate, Swar::palette},
+#if defined(__SSE2__)
+    {"sse2", Sse2::fill, Sse2::scale, Sse2::blend, Sse2::addSaturate, Sse2::palette},
+#endif
+#if defined(__AVX2__)
+    {"avx2", Avx2::fill, Avx2::scale, Avx2::blend, Avx2::addSaturate, Avx2::palette},
+#endif
+};
+static const size_t VARIANT_COUNT = sizeof(VARIANTS) / sizeof(VARIANTS[0]);
+
+static const size_t MAX_BYTES = 200;
+static const uint8_t AMOUNTS[] = {0, 1, 2, 127, 128, 129, 200, 254, 255};
+
+// Compare against the reference (Unity rejects zero-length memory compares)
+static void assertSameBytes(const uint8_t* expected, const uint8_t* actual, size_t count, const char* variant) {
+    if (count > 0) {
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, actual, count, variant);
+    }
+}
+
+static void randomBytes(uint8_t* data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        data[i] = (uint8_t)rand();
+    }
+}
+
+// Test the byte operations against FastLED's definitions, exhaustively
+void test_reference_matches_fastled() {
+    uint32_t mismatches = 0;
+    for (uint16_t a = 0; a < 256; a++) {
+        for (uint16_t b = 0; b < 256; b++) {
+            // scale8 (FASTLED_SCALE8_FIXED)
+            mismatches += scaleByte(a, b) != (uint8_t)((a * (1 + b)) >> 8);
+            // qadd8
+            mismatches += addByte(a, b) != (a + b > 255 ? 255 : a + b);
+            // blend8 (FASTLED_BLEND_FIXED), every amount
+            for (uint16_t f = 0; f < 256; f++) {
+                uint16_t partial = (uint16_t)((a << 8) | b);
+                partial += b * f;
+                partial -= a * f;
+                mismatches += blendByte(a, b, f) != (uint8_t)(partial >> 8);
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+    TEST_ASSERT_EQUAL_UINT8(200, scaleByte(200, 255));
+    TEST_ASSERT_EQUAL_UINT8(10, blendByte(10, 250, 0));
+    TEST_ASSERT_EQUAL_UINT8(250, blendByte(10, 250, 255));
+}
+
+// Test every variant against the reference, for all lengths and relative alignments
+void test_variants_match_reference() {
+    alignas(32) uint8_t a[MAX_BYTES + 4];
+    alignas(32) uint8_t b[MAX_BYTES + 4];
+    alignas(32) uint8_t expected[MAX_BYTES + 4];
+    alignas(32) uint8_t actual[MAX_BYTES + 4];
+    alignas(32) uint8_t palette[256 * 3];
+    uint8_t indices[MAX_BYTES];
+    randomBytes(palette, sizeof(palette));
+    const uint8_t rgb[3] = {0x12, 0xA5, 0xFE};
+
+    for (size_t v = 1; v < VARIANT_COUNT; v++) {
+        const KernelVariant& variant = VARIANTS[v];
+        for (size_t bytes = 0; bytes <= MAX_BYTES; bytes++) {
+            for (size_t offset = 0; offset < 4; offset++) {
+                randomBytes(a, sizeof(a));
+                randomBytes(b, sizeof(b));
+                uint8_t* in = a + (bytes + offset) % 4;  // Input misaligned against the output
+                uint8_t* out = actual + offset;
+
+                for (uint8_t amount : AMOUNTS) {
+                    Scalar::scale(expected, in, amount, bytes);
+                    variant.scale(out, in, amount, bytes);
+                    assertSameBytes(expected, out, bytes, variant.name);
+
+                    Scalar::blend(expected, in, b + offset, amount, bytes);
+                    variant.blend(out, in, b + offset, amount, bytes);
+                    assertSameBytes(expected, out, bytes, variant.name);
+                }
+
+                Scalar::addSaturate(expected, in, b + offset, bytes);
+                variant.addSaturate(out, in, b + offset, bytes);
+                assertSameBytes(expected, out, bytes, variant.name);
+
+                size_t pixels = bytes / 3;
+                Scalar::fill(expected, rgb, pixels);
+                variant.fill(out, rgb, pixels);
+                assertSameBytes(expected, out, pixels * 3, variant.name);
+
+                randomBytes(indices, pixels);
+                Scalar::palette(expected, indices, palette, pixels);
+                variant.palette(out, indices, palette, pixels);
+                assertSameBytes(expected, out, pixels * 3, variant.name);
+            }
+        }
+    }
+}
+
+// Test kernels whose output is one of their inputs
+void test_variants_in_place() {
+    alignas(32) uint8_t original[MAX_BYTES];
+    alignas(32) uint8_t other[MAX_BYTES];
+    alignas(32) uint8_t expected[MAX_BYTES];
+    alignas(32) uint8_t data[MAX_BYTES];
+    randomBytes(original, MAX_BYTES);
+    randomBytes(other, MAX_BYTES);
+
+    for (size_t v = 1; v < VARIANT_COUNT; v++) {
+        const KernelVariant& variant = VARIANTS[v];
+
+        Scalar::scale(expected, original, 77, MAX_BYTES);
+        memcpy(data, original, MAX_BYTES);
+        variant.scale(data, data, 77, MAX_BYTES);
+        assertSameBytes(expected, data, MAX_BYTES, variant.name);
+
+        Scalar::blend(expected, original, other, 99, MAX_BYTES);
+        memcpy(data, original, MAX_BYTES);
+        variant.blend(data, data, other, 99, MAX_BYTES);
+        assertSameBytes(expected, data, MAX_BYTES, variant.name);
+
+        Scalar::addSaturate(expected, other, original, MAX_BYTES);
+        memcpy(data, original, MAX_BYTES);
+        variant.addSaturate(data, other, data, MAX_BYTES);
+        assertSameBytes(expected, data, MAX_BYTES, variant.name);
+    }
+}
+
+static uint64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Benchmark each kernel on a 300 LED strip
+void test_kernel_benchmark() {
+    static const size_t bytes = 300 * 3;
+    const uint32_t iterations = 2000;
+    alignas(32) static uint8_t a[bytes];
+    alignas(32) static uint8_t b[bytes];
+    alignas(32) static uint8_t out[bytes];
+    alignas(32) static uint8_t palette[256 * 3];
+    static uint8_t indices[bytes / 3];
+    randomBytes(a, bytes);
+    randomBytes(b, bytes);
+    randomBytes(palette, sizeof(palette));
+    randomBytes(indices, sizeof(indices));
+    const uint8_t rgb[3] = {1, 2, 3};
+
+    uint64_t scalarBlendNs = 0;
+    uint64_t selectedBlendNs = 0;
+    for (size_t v = 0; v < VARIANT_COUNT; v++) {
+        const KernelVariant& variant = VARIANTS[v];
+        uint64_t ns[5];
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t n = 0; n < iterations; n++) variant.fill(out, rgb, bytes / 3);
+        ns[0] = elapsedNs(start) / iterations;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t n = 0; n < iterations; n++) variant.scale(out, a, (uint8_t)n, bytes);
+        ns[1] = elapsedNs(start) / iterations;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t n = 0; n < iterations; n++) variant.blend(out, a, b, (uint8_t)n, bytes);
+        ns[2] = elapsedNs(start) / iterations;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t n = 0; n < iterations; n++) variant.addSaturate(out, a, b, bytes);
+        ns[3] = elapsedNs(start) / iterations;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t n = 0; n < iterations; n++) variant.palette(out, indices, palette, bytes / 3);
+        ns[4] = elapsedNs(start) / iterations;
+
+        printf("[BENCH] Kernels %-6s (300 LEDs): fill %llu ns, scale %llu ns, blend %llu ns, add %llu ns, "
+               "palette %llu ns\n", variant.name, (unsigned long long)ns[0], (unsigned long long)ns[1],
+               (unsigned long long)ns[2], (unsigned long long)ns[3], (unsigned long long)ns[4]);
+        if (v == 0) {
+            scalarBlendNs = ns[2];
+        }
+        if (strcmp(variant.name, PIXEL_KERNELS_VARIANT) == 0) {
+            selectedBlendNs = ns[2];
+        }
+    }
+
+    // Timing only, not asserted: shared CI hosts are too noisy for a pass/fail threshold
+    printf("[BENCH] Selected variant: %s, blend %.2fx the scalar reference's speed\n", PIXEL_KERNELS_VARIANT,
+           selectedBlendNs ? (double)scalarBlendNs / selectedBlendNs : 0.0);
+}
+
+int main() {
+    UNITY_BEGIN();
+
+    // Equivalence tests
+    RUN_TEST(test_reference_matches_fastled);
+    RUN_TEST(test_variants_match_reference);
+    RUN_TEST(test_variants_in_place);
+
+    // Performance
+    RUN_TEST(test_kernel_benchmark);
+
+    return UNITY_END();
+}
@@ -0,0 +1,267 @@
+/**
+ * @file test_output_stage.cpp
+ * @brief Unit tests for the fused brightness/gamma/color-order output stage
+ *
+ * Verifies that:
+ * 1. Gamma 1.0 at full brightness passes values through, and brightness scales linearly
+ * 2. The gamma curve is monotonic and keeps black and white fixed
+ * 3. Bytes are written in the strip's color order
+ * 4. The LED controller sends its composited frame through the output stage, with
+ *    pattern brightness scaling the light output linearly like global brightness
+ * 5. Temporal dithering averages to the 16-bit level and removes banding at low brightness
+ * 6. The dithered controller path matches the 8-bit path and backs off when over budget
+ * 7. The fused stage beats separate brightness, gamma and reorder passes (benchmark)
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "output_stage.h"
+#include "led_controller.h"
+#define SHARED_CONTROLLERS 2
+#include "shared_controller.h"
+
+void setUp() {
+    resetSharedControllers();
+}
+
+#define TEST_NUM_LEDS 8
+
+// Test linear response and brightness scaling
+void test_identity_and_brightness() {
+    OutputStage stage;
+    stage.setGamma(1.0f);
+    for (uint16_t v = 0; v < 256; v++) {
+        TEST_ASSERT_EQUAL_UINT8(v, stage.lookup(v));
+    }
+
+    stage.setBrightness(128);
+    TEST_ASSERT_EQUAL_UINT8(0, stage.lookup(0));
+    TEST_ASSERT_EQUAL_UINT8(64, stage.lookup(127));
+    TEST_ASSERT_EQUAL_UINT8(128, stage.lookup(255));
+}
+
+// Test the gamma curve shape
+void test_gamma_curve() {
+    OutputStage stage;
+    TEST_ASSERT_EQUAL_FLOAT(OUTPUT_GAMMA, stage.getGamma());
+    TEST_ASSERT_EQUAL_UINT8(0, stage.lookup(0));
+    TEST_ASSERT_EQUAL_UINT8(255, stage.lookup(255));
+    TEST_ASSERT_UINT8_WITHIN(1, 56, stage.lookup(128));  // (128/255)^2.2 * 255
+    for (uint16_t v = 1; v < 256; v++) {
+        TEST_ASSERT_TRUE(stage.lookup(v) >= stage.lookup(v - 1));
+    }
+
+    stage.setGamma(0);  // Invalid: falls back to linear
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, stage.getGamma());
+}
+
+// Test color order permutes channels
+void test_color_order() {
+    OutputStage stage;
+    stage.setGamma(1.0f);
+    CRGB in[TEST_NUM_LEDS];
+    CRGB out[TEST_NUM_LEDS];
+    fill_solid(in, TEST_NUM_LEDS, CRGB(10, 20, 30));
+
+    stage.apply<GRB>(out, in, TEST_NUM_LEDS);
+    TEST_ASSERT_EQUAL_UINT8(20, out[0].raw[0]);
+    TEST_ASSERT_EQUAL_UINT8(10, out[0].raw[1]);
+    TEST_ASSERT_EQUAL_UINT8(30, out[0].raw[2]);
+
+    stage.apply<BGR>(out, in, TEST_NUM_LEDS);
+    TEST_ASSERT_TRUE(out[TEST_NUM_LEDS - 1] == CRGB(30, 20, 10));
+
+    stage.apply<RGB>(in, in, TEST_NUM_LEDS);  // In place
+    TEST_ASSERT_TRUE(in[0] == CRGB(10, 20, 30));
+}
+
+// Test the controller's output frame is its composited frame after the output stage
+void test_controller_output() {
+    LedController& controller = sharedController();
+    controller.setTransition(TransitionType::CUT, 0);
+    controller.setPattern(LedPattern::BRAINWAVE);
+    controller.setBrightness(200);
+    fakeNowUs = 1000000;
+    controller.update();
+
+    const CRGB* leds = controller.getLeds();
+    const CRGB* output = controller.getOutput();
+    const OutputStage& stage = controller.getOutputStage();
+    for (int i = 0; i < NUM_LEDS; i++) {
+        TEST_ASSERT_EQUAL_UINT8(stage.lookup(leds[i].g), output[i].raw[0]);
+        TEST_ASSERT_EQUAL_UINT8(stage.lookup(leds[i].r), output[i].raw[1]);
+        TEST_ASSERT_EQUAL_UINT8(stage.lookup(leds[i].b), output[i].raw[2]);
+    }
+}
+
+// Test pattern brightness scales the light output linearly, as if applied after gamma
+void test_pattern_brightness_after_gamma() {
+    LedController& controller = sharedController();
+    controller.setTransition(TransitionType::CUT, 0);
+    controller.setCurrentBudget(0);  // Full white would be limited
+    PatternConfig white = PatternDefaults::getDefault(LedPattern::IDLE);
+    white.color = CRGB(255, 255, 255);
+
+    const uint8_t levels[] = {0, 20, 50, 128, 255};
+    for (uint8_t level : levels) {
+        white.brightness = level;
+        controller.setPattern(white);
+        fakeNowUs += 10000;
+        controller.update();
+        TEST_ASSERT_UINT8_WITHIN(1, level, controller.getOutput()[0].raw[0]);
+        TEST_ASSERT_UINT8_WITHIN(1, level, controller.getOutput()[NUM_LEDS - 1].raw[2]);
+    }
+}
+
+// Test the dithered output averages to the exact 16-bit level
+void test_dither_average() {
+    OutputStage stage;
+    stage.setGamma(1.0f);
+    const CRGB16 in = {(uint16_t)(20 * 256 + 77), 0, COLOR16_MAX};  // Red 20.3
+    uint8_t residue[3] = {0, 0, 0};
+    CRGB out;
+
+    uint32_t sum = 0;
+    for (int frame = 0; frame < 256; frame++) {
+        stage.applyDithered<RGB>(&out, &in, residue, 1);
+        TEST_ASSERT_TRUE(out.r == 20 || out.r == 21);
+        TEST_ASSERT_EQUAL_UINT8(0, out.g);
+        TEST_ASSERT_EQUAL_UINT8(255, out.b);
+        sum += out.r;
+    }
+    TEST_ASSERT_EQUAL_UINT32(20 * 256 + 77, sum);
+}
+
+// Test a gradient at night-ops brightness keeps its levels when dithered
+void test_dither_low_brightness_gradient() {
+    OutputStage stage;
+    stage.setGamma(1.0f);
+    stage.setBrightness(20);
+    static uint8_t residue[256 * 3];
+    OutputStage::seedResidue(residue, 256);
+
+    // Ramp over every 8-bit input level; count distinct output levels averaged over 256 frames
+    static CRGB16 ramp[256];
+    static CRGB out[256];
+    static uint32_t sums[256];
+    for (uint16_t v = 0; v < 256; v++) {
+        ramp[v] = {(uint16_t)(v << 8), 0, 0};
+        sums[v] = 0;
+    }
+    for (int frame = 0; frame < 256; frame++) {
+        stage.applyDithered<RGB>(out, ramp, residue, 256);
+        for (uint16_t v = 0; v < 256; v++) {
+            sums[v] += out[v].r;
+        }
+    }
+
+    uint16_t undithered = 1;
+    uint16_t dithered = 1;
+    for (uint16_t v = 1; v < 256; v++) {
+        undithered += stage.lookup(v) != stage.lookup(v - 1);
+        dithered += sums[v] != sums[v - 1];
+        TEST_ASSERT_TRUE(sums[v] >= sums[v - 1]);
+    }
+    TEST_ASSERT_EQUAL_UINT16(21, undithered);  // 8-bit output bands into brightness + 1 levels
+    TEST_ASSERT_TRUE(dithered > 200);
+}
+
+// Test the controller's dithered path matches the 8-bit composite and backs off over budget
+void test_controller_dithering() {
+    LedController& dithered = sharedController(0);
+    LedController& plain = sharedController(1);
+    fakeNowUs = 2000000;
+    dithered.setTransition(TransitionType::CUT, 0);
+    plain.setTransition(TransitionType::CUT, 0);
+    dithered.setPattern(LedPattern::BRAINWAVE);
+    plain.setPattern(LedPattern::BRAINWAVE);
+    dithered.setBrightness(20);
+    plain.setBrightness(20);
+    dithered.setDithering(true);
+
+    dithered.update();
+    plain.update();
+    TEST_ASSERT_TRUE(dithered.getOutputStage().isDithering());
+    TEST_ASSERT_EQUAL_MEMORY(plain.getLeds(), dithered.getLeds(), NUM_LEDS * sizeof(CRGB));
+
+    OutputStage stage;
+    stage.setDithering(true);
+    stage.recordDitherCost(OUTPUT_DITHER_BUDGET_US);
+    TEST_ASSERT_TRUE(stage.isDithering());
+    stage.recordDitherCost(OUTPUT_DITHER_BUDGET_US + 1);
+    TEST_ASSERT_FALSE(stage.isDithering());
+    TEST_ASSERT_EQUAL_UINT32(1, stage.getDitherOverBudget());
+}
+
+// Benchmark the fused stage against scaling, gamma and reordering in separate passes
+void test_output_benchmark() {
+    static const uint16_t numLeds = 300;
+    static CRGB frame[numLeds];
+    static CRGB out[numLeds];
+    for (uint16_t i = 0; i < numLeds; i++) {
+        frame[i] = CRGB(i, 255 - (i & 0xFF), i * 7);
+    }
+    OutputStage stage;
+    stage.setBrightness(180);
+    OutputStage gammaOnly;  // Gamma table without brightness for the separate passes
+    const uint32_t iterations = 200;
+
+    // Separate passes: global nscale8, gamma table per channel, then color order
+    unsigned long start = micros();
+    for (uint32_t n = 0; n < iterations; n++) {
+        for (uint16_t i = 0; i < numLeds; i++) {
+            out[i] = frame[i];
+            out[i].nscale8(180);
+        }
+        for (uint16_t i = 0; i < numLeds; i++) {
+            out[i].r = gammaOnly.lookup(out[i].r);
+            out[i].g = gammaOnly.lookup(out[i].g);
+            out[i].b = gammaOnly.lookup(out[i].b);
+        }
+        for (uint16_t i = 0; i < numLeds; i++) {
+            uint8_t r = out[i].r;
+            out[i].r = out[i].g;
+            out[i].g = r;
+        }
+    }
+    unsigned long separateUs = micros() - start;
+
+    start = micros();
+    for (uint32_t n = 0; n < iterations; n++) {
+        stage.apply<GRB>(out, frame, numLeds);
+    }
+    unsigned long fusedUs = micros() - start;
+
+    Serial.printf("[BENCH] Output stage (%u LEDs): separate passes %lu ns/frame, fused %lu ns/frame\n",
+                  numLeds, separateUs * 1000 / iterations, fusedUs * 1000 / iterations);
+    TEST_ASSERT_TRUE(fusedUs < separateUs);
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Output stage tests
+    RUN_TEST(test_identity_and_brightness);
+    RUN_TEST(test_gamma_curve);
+    RUN_TEST(test_color_order);
+
+    // Controller integration
+    RUN_TEST(test_controller_output);
+    RUN_TEST(test_pattern_brightness_after_gamma);
+
+    // Dithering
+    RUN_TEST(test_dither_average);
+    RUN_TEST(test_dither_low_brightness_gradient);
+    RUN_TEST(test_controller_dithering);
+
+    // Performance
+    RUN_TEST(test_output_benchmark);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
@@ -0,0 +1,238 @@
+/**
+ * @file test_pattern_stack.cpp
+ * @brief Unit tests for pattern priority preemption and restore
+ *
+ * Verifies that:
+ * 1. Higher priority patterns preempt lower ones and expire after their TTL
+ * 2. Clearing a preemption restores the pattern below with its phase intact
+ * 3. Flight state updates during a preemption are shown once it ends, except that a
+ *    command without a priority ends an EMERGENCY also sent without one
+ * 4. Received commands are queued and applied in order by the next update(), and a
+ *    full queue still takes CRITICAL commands
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "pattern_stack.h"
+#include "led_controller.h"
+#include "shared_controller.h"
+
+void setUp() {
+    resetSharedControllers();
+}
+
+// Full brightness config so displayed colors compare exactly
+static PatternConfig fullBrightness(LedPattern pattern) {
+    PatternConfig config = PatternDefaults::getDefault(pattern);
+    config.brightness = 255;
+    return config;
+}
+
+static LedController& freshController() {
+    LedController& controller = sharedController();
+    fakeNowUs = 0;
+    controller.setTransition(TransitionType::CUT, 0);
+    controller.clearPattern(PatternPriority::CRITICAL);
+    controller.clearPattern(PatternPriority::HIGH);
+    controller.setPattern(fullBrightness(LedPattern::IDLE));
+    return controller;
+}
+
+// Test the highest active level is on top and NORMAL cannot be cleared
+void test_stack_top_level() {
+    PatternStack stack;
+    TEST_ASSERT_EQUAL_UINT8(0, stack.topLevel());
+
+    stack.set(PatternPriority::CRITICAL, PatternDefaults::getDefault(LedPattern::EMERGENCY), 0, 400000, 0);
+    stack.set(PatternPriority::HIGH, PatternDefaults::getDefault(LedPattern::FLYING), 0, 400000, 0);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)PatternPriority::CRITICAL, stack.topLevel());
+
+    stack.clear(PatternPriority::CRITICAL);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)PatternPriority::HIGH, stack.topLevel());
+
+    stack.clear(PatternPriority::HIGH);
+    stack.clear(PatternPriority::NORMAL);
+    TEST_ASSERT_EQUAL_UINT8(0, stack.topLevel());
+    TEST_ASSERT_TRUE(stack.slot(0).active);
+    TEST_ASSERT_EQUAL_UINT32(1, stack.getPreemptions());
+    TEST_ASSERT_EQUAL_UINT32(2, stack.getRestores());
+}
+
+// Test a TTL preemption expires on time
+void test_stack_ttl_expiry() {
+    PatternStack stack;
+    stack.set(PatternPriority::HIGH, PatternDefaults::getDefault(LedPattern::FLYING), 500, 400000, 1000);
+
+    stack.expire(1000 + 499999);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)PatternPriority::HIGH, stack.topLevel());
+
+    stack.expire(1000 + 500000);
+    TEST_ASSERT_EQUAL_UINT8(0, stack.topLevel());
+    TEST_ASSERT_EQUAL_UINT32(1, stack.getExpirations());
+
+    // A TTL too long for the microsecond timer is clamped, not wrapped to a short one
+    stack.set(PatternPriority::HIGH, PatternDefaults::getDefault(LedPattern::FLYING), 4294968, 400000, 0);
+    stack.expire(1000000);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)PatternPriority::HIGH, stack.topLevel());
+    TEST_ASSERT_EQUAL_UINT32(PATTERN_TTL_MAX_MS * 1000, stack.slot((uint8_t)PatternPriority::HIGH).ttlUs);
+    stack.expire(PATTERN_TTL_MAX_MS * 1000);
+    TEST_ASSERT_EQUAL_UINT8(0, stack.topLevel());
+}
+
+// Test EMERGENCY preempts by default and a flight state update at NORMAL waits underneath
+void test_emergency_preempts_flight_state() {
+    LedController& controller = freshController();
+
+    controller.setPattern(fullBrightness(LedPattern::EMERGENCY));
+    controller.update();
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == PatternDefaults::COLOR_RED);
+
+    // Flight state changes while EMERGENCY is shown
+    controller.setPattern(fullBrightness(LedPattern::HOVERING), PatternPriority::NORMAL);
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::EMERGENCY, controller.getCurrentConfig().pattern);
+
+    // Clearing EMERGENCY shows the latest flight state on the next frame
+    controller.clearPattern(PatternPriority::CRITICAL);
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::HOVERING, controller.getCurrentConfig().pattern);
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == PatternDefaults::COLOR_GREEN);
+}
+
+// Test a command without a priority ends an EMERGENCY sent without one, as hosts
+// that predate priorities expect, but not one sent at an explicit priority
+void test_plain_command_ends_implicit_emergency() {
+    LedController& controller = freshController();
+    controller.setPattern(fullBrightness(LedPattern::EMERGENCY));
+    controller.update();
+    controller.setPattern(fullBrightness(LedPattern::HOVERING));
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::HOVERING, controller.getCurrentConfig().pattern);
+    TEST_ASSERT_FALSE(controller.getPatternStack().slot((uint8_t)PatternPriority::CRITICAL).active);
+
+    // Through the command queue, as received
+    const LayerSettings base = {LayerId::BASE, BlendMode::NORMAL, 255, SEGMENT_MAIN};
+    controller.queueCommand(fullBrightness(LedPattern::EMERGENCY), base, {PatternPriority::CRITICAL, 0, false, true});
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::EMERGENCY, controller.getCurrentConfig().pattern);
+    controller.queueCommand(fullBrightness(LedPattern::FLYING), base, {PatternPriority::NORMAL, 0, false, true});
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::FLYING, controller.getCurrentConfig().pattern);
+
+    // An explicitly CRITICAL EMERGENCY stays
+    controller.setPattern(fullBrightness(LedPattern::EMERGENCY), PatternPriority::CRITICAL);
+    controller.setPattern(fullBrightness(LedPattern::HOVERING));
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::EMERGENCY, controller.getCurrentConfig().pattern);
+    TEST_ASSERT_EQUAL(LedPattern::HOVERING, controller.getPatternStack().slot(0).config.pattern);
+}
+
+// Test the restored pattern continues from the phase it was preempted at
+void test_restore_keeps_phase() {
+    LedController& controller = freshController();
+    controller.setPattern(fullBrightness(LedPattern::HOVERING));  // 1 s on, 1 s off
+
+    // 0.9 s into the on half
+    fakeNowUs += 900000;
+    controller.update();
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == PatternDefaults::COLOR_GREEN);
+
+    // Preempted for 5 s by a TTL pattern
+    controller.setPattern(fullBrightness(LedPattern::FLYING), PatternPriority::HIGH, 5000);
+    fakeNowUs += 4000000;
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::FLYING, controller.getCurrentConfig().pattern);
+
+    // Expires without any new command; HOVERING resumes at 0.9 s, still on
+    fakeNowUs += 1000000;
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::HOVERING, controller.getCurrentConfig().pattern);
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == PatternDefaults::COLOR_GREEN);
+
+    // And turns off 0.1 s later, as if it had never been interrupted
+    fakeNowUs += 100000;
+    controller.update();
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == CRGB(0, 0, 0));
+}
+
+// Test a lower priority TTL pattern does not displace EMERGENCY
+void test_lower_priority_waits() {
+    LedController& controller = freshController();
+    controller.setPattern(fullBrightness(LedPattern::EMERGENCY));
+    controller.setPattern(fullBrightness(LedPattern::FLYING), PatternPriority::HIGH, 1000);
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::EMERGENCY, controller.getCurrentConfig().pattern);
+
+    // Still waiting when EMERGENCY clears before its TTL
+    controller.clearPattern(PatternPriority::CRITICAL);
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::FLYING, controller.getCurrentConfig().pattern);
+}
+
+// Test queued commands only take effect at the next frame, in arrival order
+void test_queued_commands_apply_in_update() {
+    LedController& controller = freshController();
+    controller.update();
+    const LayerSettings base = {LayerId::BASE, BlendMode::NORMAL, 255, SEGMENT_MAIN};
+    const LayerSettings alert = {LayerId::ALERT, BlendMode::NORMAL, 255, SEGMENT_MAIN};
+    const uint32_t applied = controller.getCommandLatency().getCount();  // Shared controller
+
+    TEST_ASSERT_TRUE(controller.queueCommand(fullBrightness(LedPattern::HOVERING), base,
+                                             {PatternPriority::NORMAL, 0, false}));
+    TEST_ASSERT_TRUE(controller.queueCommand(fullBrightness(LedPattern::EMERGENCY), base,
+                                             {PatternPriority::CRITICAL, 0, false}));
+    TEST_ASSERT_TRUE(controller.queueCommand(fullBrightness(LedPattern::LOW_BATTERY), alert,
+                                             {PatternPriority::NORMAL, 0, false}));
+    TEST_ASSERT_EQUAL(LedPattern::IDLE, controller.getPatternStack().slot(0).config.pattern);
+    TEST_ASSERT_EQUAL_UINT8(0, controller.getLayer(LayerId::ALERT).opacity);
+
+    fakeNowUs += 10000;
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::EMERGENCY, controller.getCurrentConfig().pattern);
+    TEST_ASSERT_EQUAL(LedPattern::HOVERING, controller.getPatternStack().slot(0).config.pattern);
+    TEST_ASSERT_EQUAL_UINT8(255, controller.getLayer(LayerId::ALERT).opacity);
+    TEST_ASSERT_EQUAL_UINT32(applied + 3, controller.getCommandLatency().getCount());
+
+    // Clearing goes through the queue too
+    controller.queueCommand(fullBrightness(LedPattern::EMERGENCY), base, {PatternPriority::CRITICAL, 0, true});
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::HOVERING, controller.getCurrentConfig().pattern);
+
+    // A full queue drops (and counts) further commands until the next frame,
+    // but keeps room for CRITICAL ones
+    for (uint8_t i = 0; i < COMMAND_QUEUE_SLOTS - COMMAND_QUEUE_CRITICAL_SLOTS; i++) {
+        TEST_ASSERT_TRUE(controller.queueCommand(fullBrightness(LedPattern::FLYING), base,
+                                                 {PatternPriority::NORMAL, 0, false}));
+    }
+    TEST_ASSERT_FALSE(controller.queueCommand(fullBrightness(LedPattern::IDLE), base,
+                                              {PatternPriority::NORMAL, 0, false}));
+    TEST_ASSERT_EQUAL_UINT32(1, controller.getCommandsDropped());
+    TEST_ASSERT_TRUE(controller.queueCommand(fullBrightness(LedPattern::EMERGENCY), base,
+                                             {PatternPriority::CRITICAL, 0, false}));
+    controller.update();
+    TEST_ASSERT_EQUAL(LedPattern::EMERGENCY, controller.getCurrentConfig().pattern);
+    TEST_ASSERT_EQUAL(LedPattern::FLYING, controller.getPatternStack().slot(0).config.pattern);
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Priority stack tests
+    RUN_TEST(test_stack_top_level);
+    RUN_TEST(test_stack_ttl_expiry);
+
+    // Controller preemption tests
+    RUN_TEST(test_emergency_preempts_flight_state);
+    RUN_TEST(test_plain_command_ends_implicit_emergency);
+    RUN_TEST(test_restore_keeps_phase);
+    RUN_TEST(test_lower_priority_waits);
+    RUN_TEST(test_queued_commands_apply_in_update);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
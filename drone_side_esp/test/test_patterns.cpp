@@ -6,6 +6,7 @@
  * 1. Define expected behavior through tests
  * 2. Verify implementation matches specifications
  * 3. Include edge cases and error handling
+ * 4. Benchmark name lookup against the previous strcmp chain
  */
 
 #include <Arduino.h>
@@ -218,6 +219,75 @@ void test_color_definitions() {
     }
 }
 
+// Test the registry has one renderable entry per pattern, in enum order
+void test_registry_entries() {
+    for (uint8_t i = 0; i < PATTERN_COUNT; i++) {
+        const PatternInfo& info = patternInfo((LedPattern)i);
+        TEST_ASSERT_EQUAL((LedPattern)i, info.defaults.pattern);
+        TEST_ASSERT_EQUAL_STRING(patternToString((LedPattern)i), info.name);
+        TEST_ASSERT_NOT_NULL(info.render);
+    }
+
+    // Out-of-range values fall back to IDLE
+    TEST_ASSERT_EQUAL(LedPattern::IDLE, patternInfo((LedPattern)PATTERN_COUNT).defaults.pattern);
+    TEST_ASSERT_EQUAL_STRING("UNKNOWN", patternToString((LedPattern)PATTERN_COUNT));
+}
+
+// Previous sequential strcmp lookup, kept as the benchmark reference
+static LedPattern legacyStringToPattern(const char* str) {
+    if (strcmp(str, "IDLE") == 0) return LedPattern::IDLE;
+    if (strcmp(str, "TAKING_OFF") == 0) return LedPattern::TAKING_OFF;
+    if (strcmp(str, "HOVERING") == 0) return LedPattern::HOVERING;
+    if (strcmp(str, "FLYING") == 0) return LedPattern::FLYING;
+    if (strcmp(str, "LANDING") == 0) return LedPattern::LANDING;
+    if (strcmp(str, "EMERGENCY") == 0) return LedPattern::EMERGENCY;
+    if (strcmp(str, "LOW_BATTERY") == 0) return LedPattern::LOW_BATTERY;
+    if (strcmp(str, "BRAINWAVE") == 0) return LedPattern::BRAINWAVE;
+    return LedPattern::IDLE;
+}
+
+// Test hashed lookup agrees with the sequential lookup on valid and invalid names
+void test_stringToPattern_matches_legacy() {
+    const char* names[] = {
+        "IDLE", "TAKING_OFF", "HOVERING", "FLYING", "LANDING", "EMERGENCY", "LOW_BATTERY", "BRAINWAVE",
+        "", "INVALID", "idle", "EMERGENCZ", "BRAINWAVES", "I", "LOW_BATTERY_LOW_BATTERY", "FLYINGX"
+    };
+    for (const char* name : names) {
+        TEST_ASSERT_EQUAL_MESSAGE(legacyStringToPattern(name), stringToPattern(name), name);
+    }
+}
+
+// Benchmark: hashed lookup vs sequential strcmp over valid and invalid names
+void test_stringToPattern_benchmark() {
+    const char* names[] = {
+        "IDLE", "TAKING_OFF", "HOVERING", "FLYING", "LANDING", "EMERGENCY", "LOW_BATTERY", "BRAINWAVE",
+        "INVALID", "BRAINWAVX", "LOW_BATTERZ", "UNKNOWN_PATTERN"
+    };
+    const uint8_t nameCount = sizeof(names) / sizeof(names[0]);
+    const uint32_t iterations = 100000;
+    volatile uint32_t sink = 0;
+
+    uint32_t start = micros();
+    for (uint32_t n = 0; n < iterations; n++) {
+        sink += (uint32_t)legacyStringToPattern(names[n % nameCount]);
+    }
+    uint32_t legacyUs = micros() - start;
+
+    start = micros();
+    for (uint32_t n = 0; n < iterations; n++) {
+        sink += (uint32_t)stringToPattern(names[n % nameCount]);
+    }
+    uint32_t hashedUs = micros() - start;
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "strcmp chain: %lu ns/lookup, perfect hash: %lu ns/lookup",
+             (unsigned long)((uint64_t)legacyUs * 1000 / iterations),
+             (unsigned long)((uint64_t)hashedUs * 1000 / iterations));
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_LESS_OR_EQUAL(legacyUs + 1000, hashedUs);
+}
+
 void setup() {
     delay(2000); // Wait for serial monitor
 
@@ -228,6 +298,8 @@ void setup() {
     RUN_TEST(test_stringToPattern_invalid_names);
     RUN_TEST(test_stringToPattern_edge_cases);
 
+    RUN_TEST(test_stringToPattern_matches_legacy);
+
     // Pattern to String conversion tests
     RUN_TEST(test_patternToString_all_patterns);
 
@@ -245,6 +317,12 @@ void setup() {
     RUN_TEST(test_pattern_defaults_brainwave);
     RUN_TEST(test_all_patterns_have_defaults);
 
+    // Registry tests
+    RUN_TEST(test_registry_entries);
+
+    // Performance
+    RUN_TEST(test_stringToPattern_benchmark);
+
     // Value range tests
     RUN_TEST(test_default_brightness_in_range);
     RUN_TEST(test_color_definitions);
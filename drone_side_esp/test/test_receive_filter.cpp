@@ -0,0 +1,91 @@
+/**
+ * @file test_receive_filter.cpp
+ * @brief Unit tests for the ESP-NOW receive pre-filter
+ *
+ * Verifies that:
+ * 1. JSON (including whitespace-led JSON) and well-formed binary packets pass, and any
+ *    sender passes with an empty allow-list
+ * 2. Packets from senders off the allow-list are dropped
+ * 3. Bad lengths and unknown magic or message types are dropped with their own counters
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "receive_filter.h"
+
+static const uint8_t BASE_MAC[6] = {0x24, 0x6F, 0x28, 0x01, 0x02, 0x03};
+static const uint8_t OTHER_MAC[6] = {0x24, 0x6F, 0x28, 0x09, 0x09, 0x09};
+static const char JSON[] = R"({"type":"led_command","data":{"pattern":"FLYING"}})";
+
+// Test valid traffic passes an empty allow-list
+void test_filter_accepts_valid() {
+    ReceiveFilter filter;
+    uint8_t sample[sizeof(ParamSampleMessage)] = {PROTOCOL_MAGIC, (uint8_t)MessageType::PARAM_SAMPLE};
+    uint8_t fragment[sizeof(FragmentHeader) + 10] = {PROTOCOL_MAGIC, (uint8_t)MessageType::FRAGMENT};
+
+    TEST_ASSERT_TRUE(filter.accept(OTHER_MAC, (const uint8_t*)JSON, strlen(JSON)));
+    TEST_ASSERT_TRUE(filter.accept(OTHER_MAC, sample, sizeof(sample)));
+    TEST_ASSERT_TRUE(filter.accept(OTHER_MAC, fragment, sizeof(fragment)));
+
+    // JSON allows whitespace before the root object
+    static const char indented[] = " \r\n\t{\"type\":\"led_command\"}";
+    TEST_ASSERT_TRUE(filter.accept(OTHER_MAC, (const uint8_t*)indented, strlen(indented)));
+    TEST_ASSERT_EQUAL_UINT32(4, filter.getAccepted());
+}
+
+// Test only allow-listed senders pass once the list is set
+void test_filter_sender_allow_list() {
+    ReceiveFilter filter;
+    TEST_ASSERT_TRUE(filter.allowSender(BASE_MAC));
+
+    TEST_ASSERT_TRUE(filter.accept(BASE_MAC, (const uint8_t*)JSON, strlen(JSON)));
+    TEST_ASSERT_FALSE(filter.accept(OTHER_MAC, (const uint8_t*)JSON, strlen(JSON)));
+    TEST_ASSERT_EQUAL_UINT32(1, filter.getDropped(DropReason::SENDER));
+
+    // The list is bounded
+    for (uint8_t i = 1; i < RECEIVE_MAX_SENDERS; i++) {
+        TEST_ASSERT_TRUE(filter.allowSender(OTHER_MAC));
+    }
+    TEST_ASSERT_FALSE(filter.allowSender(OTHER_MAC));
+}
+
+// Test malformed packets are counted by reason
+void test_filter_drop_reasons() {
+    ReceiveFilter filter;
+    uint8_t oversized[ESPNOW_MAX_PAYLOAD + 1] = {'{'};
+    uint8_t foreign[8] = {0x12, 0x34};
+    uint8_t unknownType[8] = {PROTOCOL_MAGIC, 0x7F};
+    uint8_t shortFrame[sizeof(FrameMessageHeader) - 1] = {PROTOCOL_MAGIC, (uint8_t)MessageType::FRAME};
+    uint8_t blank[4] = {' ', '\n', ' ', '{'};
+
+    TEST_ASSERT_FALSE(filter.accept(BASE_MAC, oversized, 0));
+    TEST_ASSERT_FALSE(filter.accept(BASE_MAC, oversized, sizeof(oversized)));
+    TEST_ASSERT_FALSE(filter.accept(BASE_MAC, oversized, 1));
+    TEST_ASSERT_FALSE(filter.accept(BASE_MAC, shortFrame, sizeof(shortFrame)));
+    TEST_ASSERT_FALSE(filter.accept(BASE_MAC, foreign, sizeof(foreign)));
+    TEST_ASSERT_FALSE(filter.accept(BASE_MAC, unknownType, sizeof(unknownType)));
+    TEST_ASSERT_FALSE(filter.accept(BASE_MAC, blank, 3));                // Whitespace only
+    TEST_ASSERT_FALSE(filter.accept(BASE_MAC, blank, sizeof(blank)));    // Too short after it
+
+    TEST_ASSERT_EQUAL_UINT32(5, filter.getDropped(DropReason::LENGTH));
+    TEST_ASSERT_EQUAL_UINT32(3, filter.getDropped(DropReason::MAGIC));
+    TEST_ASSERT_EQUAL_UINT32(0, filter.getDropped(DropReason::SENDER));
+    TEST_ASSERT_EQUAL_UINT32(0, filter.getAccepted());
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Receive filter tests
+    RUN_TEST(test_filter_accepts_valid);
+    RUN_TEST(test_filter_sender_allow_list);
+    RUN_TEST(test_filter_drop_reasons);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
@@ -0,0 +1,234 @@
+/**
+ * @file test_segments.cpp
+ * @brief Unit tests for strip segments with independent patterns
+ *
+ * Verifies that:
+ * 1. Segment ranges are validated (bounds, overlap, id) and can be removed
+ * 2. Each segment shows its own pattern and brightness, the flight state the rest
+ * 3. Segments animate on their own timing
+ * 4. CRITICAL patterns cover the segments until cleared
+ * 5. The dithered path composites segment brightness like the 8-bit path
+ * 6. A flow in a segment runs along the segment when a layout is loaded
+ * 7. Rendering cost tracks LEDs drawn, not segment count (benchmark)
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "led_controller.h"
+#define SHARED_CONTROLLERS 2
+#include "shared_controller.h"
+
+void setUp() {
+    resetSharedControllers();
+}
+
+static const uint16_t HALF = NUM_LEDS / 2;
+
+static PatternConfig staticColor(CRGB color, uint8_t brightness) {
+    PatternConfig config = PatternDefaults::getDefault(LedPattern::IDLE);
+    config.color = color;
+    config.brightness = brightness;
+    return config;
+}
+
+static void step(LedController& controller, uint32_t us) {
+    fakeNowUs += us;
+    controller.update();
+}
+
+// Test range validation
+void test_segment_ranges() {
+    LedController& controller = sharedController();
+    TEST_ASSERT_TRUE(controller.setSegment(1, 0, HALF));
+    TEST_ASSERT_TRUE(controller.setSegment(2, HALF, NUM_LEDS - HALF));
+    TEST_ASSERT_FALSE(controller.setSegment(3, HALF - 1, 2));       // Overlaps both
+    TEST_ASSERT_FALSE(controller.setSegment(3, NUM_LEDS - 1, 2));   // Past the end
+    TEST_ASSERT_FALSE(controller.setSegment(SEGMENT_MAIN, 0, 1));   // MAIN is the whole strip
+    TEST_ASSERT_FALSE(controller.setSegment(SEGMENT_COUNT, 0, 1));
+    TEST_ASSERT_TRUE(controller.setSegment(1, 2, HALF - 2));        // Moving within its own range
+    TEST_ASSERT_EQUAL_UINT16(2, controller.getSegment(1).range.start);
+
+    TEST_ASSERT_TRUE(controller.setSegment(2, 0, 0));  // Removed
+    TEST_ASSERT_TRUE(controller.setSegment(3, HALF, 4));
+    TEST_ASSERT_EQUAL_UINT16(0, controller.getSegment(2).range.length);
+}
+
+// Test segments show their own pattern and brightness over the flight state
+void test_segment_patterns() {
+    LedController& controller = sharedController();
+    controller.setGamma(1.0f);  // Composited values then equal pattern brightness
+    controller.setTransition(TransitionType::CUT, 0);
+    controller.setPattern(staticColor(CRGB(0, 0, 255), 255));
+    TEST_ASSERT_TRUE(controller.setSegment(1, 4, 6));
+    controller.setSegmentPattern(1, staticColor(CRGB(255, 0, 0), 127));
+    controller.setSegmentPattern(2, staticColor(CRGB(0, 255, 0), 255));  // Not placed: not shown
+    step(controller, 10000);
+
+    const CRGB* leds = controller.getLeds();
+    for (uint16_t i = 0; i < NUM_LEDS; i++) {
+        CRGB expected = (i >= 4 && i < 10) ? CRGB(127, 0, 0) : CRGB(0, 0, 255);
+        TEST_ASSERT_TRUE(leds[i] == expected);
+    }
+
+    // Segment 0 addresses the flight state
+    controller.setSegmentPattern(SEGMENT_MAIN, staticColor(CRGB(0, 255, 0), 255));
+    step(controller, 10000);
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == CRGB(0, 255, 0));
+    TEST_ASSERT_TRUE(controller.getLeds()[4] == CRGB(127, 0, 0));
+}
+
+// Test a segment blinks on its own period while the rest of the strip blinks on another
+void test_segment_timing() {
+    LedController& controller = sharedController();
+    controller.setTransition(TransitionType::CUT, 0);
+    PatternConfig slow = PatternDefaults::getDefault(LedPattern::HOVERING);
+    PatternConfig fast = PatternDefaults::getDefault(LedPattern::FLYING);
+    slow.speed = 400;  // On 400 ms, off 400 ms
+    fast.speed = 100;
+    controller.setPattern(slow);
+    TEST_ASSERT_TRUE(controller.setSegment(1, HALF, NUM_LEDS - HALF));
+    controller.setSegmentPattern(1, fast);
+
+    uint16_t mainToggles = 0;
+    uint16_t segmentToggles = 0;
+    bool mainOn = true;
+    bool segmentOn = true;
+    for (uint16_t ms = 10; ms <= 1600; ms += 10) {
+        step(controller, 10000);
+        bool nowMainOn = (bool)controller.getLeds()[0];
+        bool nowSegmentOn = (bool)controller.getLeds()[NUM_LEDS - 1];
+        mainToggles += nowMainOn != mainOn;
+        segmentToggles += nowSegmentOn != segmentOn;
+        mainOn = nowMainOn;
+        segmentOn = nowSegmentOn;
+    }
+    TEST_ASSERT_EQUAL_UINT16(4, mainToggles);      // 1.6 s / 400 ms
+    TEST_ASSERT_EQUAL_UINT16(16, segmentToggles);  // 1.6 s / 100 ms
+}
+
+// Test EMERGENCY covers the whole strip and segments return after it is cleared
+void test_critical_covers_segments() {
+    LedController& controller = sharedController();
+    controller.setGamma(1.0f);  // Composited values then equal pattern brightness
+    controller.setTransition(TransitionType::CUT, 0);
+    controller.setPattern(staticColor(CRGB(0, 0, 255), 255));
+    TEST_ASSERT_TRUE(controller.setSegment(1, 0, NUM_LEDS));  // Covers everything
+    controller.setSegmentPattern(1, staticColor(CRGB(255, 0, 0), 255));
+    step(controller, 10000);
+    TEST_ASSERT_TRUE(controller.getLeds()[NUM_LEDS / 2] == CRGB(255, 0, 0));
+
+    PatternConfig emergency = PatternDefaults::getDefault(LedPattern::EMERGENCY);
+    emergency.brightness = 255;
+    controller.setPattern(emergency);
+    step(controller, 1000);
+    TEST_ASSERT_TRUE(controller.getLeds()[NUM_LEDS / 2] == emergency.color);
+
+    controller.clearPattern(PatternPriority::CRITICAL);
+    step(controller, 1000);
+    TEST_ASSERT_TRUE(controller.getLeds()[NUM_LEDS / 2] == CRGB(255, 0, 0));
+}
+
+// Test the 16-bit composite gives each segment its brightness like the 8-bit path
+void test_dithered_segments_match() {
+    LedController& controller = sharedController();
+    controller.setGamma(1.0f);  // Composited values then equal pattern brightness
+    controller.setTransition(TransitionType::CUT, 0);
+    controller.setPattern(staticColor(CRGB(200, 100, 50), 180));
+    TEST_ASSERT_TRUE(controller.setSegment(1, 3, 5));
+    TEST_ASSERT_TRUE(controller.setSegment(2, NUM_LEDS - 6, 6));
+    controller.setSegmentPattern(1, staticColor(CRGB(255, 255, 255), 60));
+    controller.setSegmentPattern(2, staticColor(CRGB(10, 250, 90), 255));
+    step(controller, 10000);
+    CRGB plain[NUM_LEDS];
+    memcpy(plain, controller.getLeds(), sizeof(plain));
+
+    controller.setDithering(true);
+    step(controller, 10000);
+    TEST_ASSERT_EQUAL_MEMORY(plain, controller.getLeds(), sizeof(plain));
+}
+
+// Test a flow in a segment runs along the segment, not at the layout heights
+// of its LEDs, with a layout loaded as main.cpp does
+void test_segment_flow_follows_range() {
+    const LayoutRun straight[] = {
+        {0, NUM_LEDS, false, LayoutShape::LINE, {0, 0, 0}, {0, NUM_LEDS * 16, 0}},
+    };
+    LedController& controller = sharedController();
+    TEST_ASSERT_TRUE(controller.setLayout(straight, 1));
+    controller.setGamma(1.0f);
+    controller.setTransition(TransitionType::CUT, 0);
+    controller.setPattern(staticColor(CRGB(0, 0, 0), 255));
+    TEST_ASSERT_TRUE(controller.setSegment(1, HALF, NUM_LEDS - HALF));  // The upper half
+    PatternConfig flow = PatternDefaults::getDefault(LedPattern::TAKING_OFF);
+    flow.brightness = 255;
+    controller.setSegmentPattern(1, flow);
+    const uint32_t ledUs = flow.speed * 1000UL / (NUM_LEDS - HALF + FLOW_GAP_STEPS);
+
+    // Two LEDs into the cycle the comet is at the bottom of the segment
+    step(controller, 2 * ledUs);
+    const CRGB* leds = controller.getLeds();
+    TEST_ASSERT_TRUE(leds[HALF].g > 0);
+    TEST_ASSERT_TRUE(leds[HALF + 1].g > 0);
+    TEST_ASSERT_TRUE(leds[NUM_LEDS - 1] == CRGB(0, 0, 0));
+    TEST_ASSERT_TRUE(leds[HALF - 1] == CRGB(0, 0, 0));
+
+    // And it reaches the top of the segment within the segment's own length
+    step(controller, (NUM_LEDS - HALF - 2) * ledUs);
+    TEST_ASSERT_TRUE(controller.getLeds()[NUM_LEDS - 1].g > 0);
+}
+
+// Benchmark a frame with and without segments covering the strip
+void test_segment_render_benchmark() {
+    LedController& plain = sharedController(0);
+    LedController& segmented = sharedController(1);
+    const uint32_t iterations = 500;
+    plain.setFrameCacheEnabled(false);
+    segmented.setFrameCacheEnabled(false);
+    plain.setPattern(LedPattern::BRAINWAVE);
+    segmented.setPattern(LedPattern::BRAINWAVE);
+    for (uint8_t id = 1; id < SEGMENT_COUNT; id++) {
+        uint16_t start = (id - 1) * NUM_LEDS / (SEGMENT_COUNT - 1);
+        uint16_t end = id * NUM_LEDS / (SEGMENT_COUNT - 1);
+        TEST_ASSERT_TRUE(segmented.setSegment(id, start, end - start));
+        segmented.setSegmentPattern(id, PatternDefaults::getDefault(LedPattern::BRAINWAVE));
+    }
+
+    unsigned long start = micros();
+    for (uint32_t n = 0; n < iterations; n++) {
+        step(plain, 10000);
+    }
+    unsigned long plainUs = micros() - start;
+
+    start = micros();
+    for (uint32_t n = 0; n < iterations; n++) {
+        step(segmented, 10000);
+    }
+    unsigned long segmentedUs = micros() - start;
+
+    Serial.printf("[BENCH] Frame (%u LEDs, BRAINWAVE): whole strip %lu ns, %u segments %lu ns\n", NUM_LEDS,
+                  plainUs * 1000 / iterations, SEGMENT_COUNT - 1, segmentedUs * 1000 / iterations);
+    TEST_ASSERT_TRUE(segmentedUs < plainUs * 3 / 2 + 1000);
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Segment configuration and rendering
+    RUN_TEST(test_segment_ranges);
+    RUN_TEST(test_segment_patterns);
+    RUN_TEST(test_segment_timing);
+    RUN_TEST(test_critical_covers_segments);
+    RUN_TEST(test_dithered_segments_match);
+    RUN_TEST(test_segment_flow_follows_range);
+
+    // Performance
+    RUN_TEST(test_segment_render_benchmark);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
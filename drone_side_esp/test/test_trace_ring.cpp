@@ -0,0 +1,79 @@
+/**
+ * @file test_trace_ring.cpp
+ * @brief Unit tests for the binary event trace ring
+ *
+ * Verifies that:
+ * 1. Events are recorded with their id, phase and argument, oldest first
+ * 2. A full ring keeps only the most recent events
+ * 3. Recording is cheap enough to leave enabled (benchmark)
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "trace_ring.h"
+
+// Test events come back in order with their fields intact
+void test_trace_records_events() {
+    static TraceRing ring;
+    ring.record(TraceEventId::RX_CALLBACK, TracePhase::INSTANT, 42);
+    ring.record(TraceEventId::PARSE, TracePhase::BEGIN, 0);
+    ring.record(TraceEventId::PARSE, TracePhase::END, 3);
+
+    TraceEvent events[4];
+    TEST_ASSERT_EQUAL_UINT32(3, ring.snapshot(events, 4));
+    TEST_ASSERT_EQUAL(TraceEventId::RX_CALLBACK, events[0].id);
+    TEST_ASSERT_EQUAL(TracePhase::INSTANT, events[0].phase);
+    TEST_ASSERT_EQUAL_UINT16(42, events[0].arg);
+    TEST_ASSERT_EQUAL(TracePhase::BEGIN, events[1].phase);
+    TEST_ASSERT_EQUAL(TracePhase::END, events[2].phase);
+    TEST_ASSERT_EQUAL_UINT16(3, events[2].arg);
+    TEST_ASSERT_TRUE(events[2].timestampUs - events[0].timestampUs < 1000);
+}
+
+// Test the ring overwrites the oldest events
+void test_trace_keeps_latest() {
+    static TraceRing ring;
+    for (uint32_t i = 0; i < TRACE_RING_EVENTS + 10; i++) {
+        ring.record(TraceEventId::RENDER, TracePhase::INSTANT, (uint16_t)i);
+    }
+
+    static TraceEvent events[TRACE_RING_EVENTS];
+    TEST_ASSERT_EQUAL_UINT32(TRACE_RING_EVENTS, ring.snapshot(events, TRACE_RING_EVENTS));
+    TEST_ASSERT_EQUAL_UINT16(10, events[0].arg);
+    TEST_ASSERT_EQUAL_UINT16(TRACE_RING_EVENTS + 9, events[TRACE_RING_EVENTS - 1].arg);
+    TEST_ASSERT_EQUAL_UINT32(TRACE_RING_EVENTS + 10, ring.getEventsRecorded());
+}
+
+// Benchmark the cost of one recorded event
+void test_trace_record_benchmark() {
+    static TraceRing ring;
+    const uint32_t iterations = 10000;
+
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < iterations; i++) {
+        ring.record(TraceEventId::SHOW, TracePhase::INSTANT, (uint16_t)i);
+    }
+    unsigned long elapsedUs = micros() - start;
+
+    Serial.printf("[BENCH] Trace record: %lu ns/event\n", elapsedUs * 1000 / iterations);
+    TEST_ASSERT_TRUE(elapsedUs * 1000 / iterations < 2000);
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Trace ring tests
+    RUN_TEST(test_trace_records_events);
+    RUN_TEST(test_trace_keeps_latest);
+
+    // Performance
+    RUN_TEST(test_trace_record_benchmark);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
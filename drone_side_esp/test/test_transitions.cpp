@@ -0,0 +1,196 @@
+/**
+ * @file test_transitions.cpp
+ * @brief Unit tests and benchmark for pattern transitions
+ *
+ * Verifies that:
+ * 1. Transition progress follows wall time, not frame count
+ * 2. Crossfade and wipe blend the outgoing and incoming frames correctly
+ * 3. A frame over the cost budget ends the transition
+ * 4. LedController crossfades between patterns and cuts straight to EMERGENCY
+ * 5. Blend cost per frame stays well inside the budget
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "transition.h"
+#include "led_controller.h"
+#include "shared_controller.h"
+
+void setUp() {
+    resetSharedControllers();
+}
+
+#define TEST_NUM_LEDS 30
+
+// Color as displayed at the default pattern brightness
+static CRGB atDefaultBrightness(CRGB color) {
+    return color.nscale8(PatternDefaults::DEFAULT_BRIGHTNESS);
+}
+
+// Test progress is a fraction of the duration and ends the transition
+void test_progress_follows_time() {
+    Transition transition;
+    transition.start(TransitionType::CROSSFADE, 200, 1000);
+
+    TEST_ASSERT_TRUE(transition.isActive());
+    TEST_ASSERT_EQUAL_UINT8(0, transition.progress(1000));
+    TEST_ASSERT_EQUAL_UINT8(128, transition.progress(101000));
+    TEST_ASSERT_TRUE(transition.isActive());
+
+    TEST_ASSERT_EQUAL_UINT8(255, transition.progress(201000));
+    TEST_ASSERT_FALSE(transition.isActive());
+    TEST_ASSERT_EQUAL_UINT32(1, transition.getTransitionsCompleted());
+}
+
+// Test CUT and zero-length transitions switch instantly
+void test_cut_is_instant() {
+    Transition transition;
+    transition.start(TransitionType::CUT, 200, 0);
+    TEST_ASSERT_FALSE(transition.isActive());
+
+    transition.start(TransitionType::CROSSFADE, 0, 0);
+    TEST_ASSERT_FALSE(transition.isActive());
+    TEST_ASSERT_EQUAL_UINT32(0, transition.getTransitionsStarted());
+}
+
+// Test crossfade lerps every LED
+void test_crossfade_blend() {
+    CRGB from[TEST_NUM_LEDS];
+    CRGB to[TEST_NUM_LEDS];
+    CRGB out[TEST_NUM_LEDS];
+    fill_solid(from, TEST_NUM_LEDS, CRGB(0, 0, 0));
+    fill_solid(to, TEST_NUM_LEDS, CRGB(200, 100, 0));
+
+    Transition transition;
+    transition.start(TransitionType::CROSSFADE, 100, 0);
+
+    transition.blendFrames(out, from, to, TEST_NUM_LEDS, 0);
+    TEST_ASSERT_TRUE(out[0] == from[0]);
+
+    transition.blendFrames(out, from, to, TEST_NUM_LEDS, 128);
+    for (int i = 0; i < TEST_NUM_LEDS; i++) {
+        TEST_ASSERT_UINT8_WITHIN(1, 100, out[i].r);
+        TEST_ASSERT_UINT8_WITHIN(1, 50, out[i].g);
+        TEST_ASSERT_EQUAL_UINT8(0, out[i].b);
+    }
+}
+
+// Test wipe shows the incoming frame behind the edge and the outgoing one ahead
+void test_wipe_blend() {
+    CRGB from[TEST_NUM_LEDS];
+    CRGB to[TEST_NUM_LEDS];
+    CRGB out[TEST_NUM_LEDS];
+    fill_solid(from, TEST_NUM_LEDS, CRGB(255, 0, 0));
+    fill_solid(to, TEST_NUM_LEDS, CRGB(0, 0, 255));
+
+    Transition transition;
+    transition.start(TransitionType::WIPE, 100, 0);
+    transition.blendFrames(out, from, to, TEST_NUM_LEDS, 128);
+
+    for (int i = 0; i < TEST_NUM_LEDS / 2; i++) {
+        TEST_ASSERT_TRUE(out[i] == to[i]);
+    }
+    for (int i = TEST_NUM_LEDS / 2; i < TEST_NUM_LEDS; i++) {
+        TEST_ASSERT_TRUE(out[i] == from[i]);
+    }
+}
+
+// Test a frame over budget ends the transition
+void test_over_budget_cuts_short() {
+    Transition transition;
+    transition.start(TransitionType::CROSSFADE, 500, 0);
+
+    transition.recordFrameCost(TRANSITION_FRAME_BUDGET_US / 2);
+    TEST_ASSERT_TRUE(transition.isActive());
+
+    transition.recordFrameCost(TRANSITION_FRAME_BUDGET_US + 1);
+    TEST_ASSERT_FALSE(transition.isActive());
+    TEST_ASSERT_EQUAL_UINT32(1, transition.getTransitionsOverBudget());
+    TEST_ASSERT_EQUAL_UINT32(TRANSITION_FRAME_BUDGET_US + 1, transition.getFrameCostMaxUs());
+}
+
+// Test the controller crossfades to a new pattern and cuts to EMERGENCY
+void test_controller_crossfade_and_emergency_cut() {
+    LedController& controller = sharedController();
+    controller.setGamma(1.0f);  // Composited values then equal pattern brightness
+    fakeNowUs = 0;
+    controller.setTransition(TransitionType::CROSSFADE, 200);
+    controller.begin();
+    fakeNowUs += 1000000;
+    controller.update();
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == atDefaultBrightness(PatternDefaults::COLOR_BLUE));
+
+    // Halfway from static blue to blink green (on for the first second)
+    controller.setPattern(LedPattern::HOVERING);
+    fakeNowUs += 100000;
+    controller.update();
+    TEST_ASSERT_TRUE(controller.getTransition().isActive());
+    TEST_ASSERT_EQUAL_UINT8(0, controller.getLeds()[0].r);
+    TEST_ASSERT_UINT8_WITHIN(2, 64, controller.getLeds()[0].g);
+    TEST_ASSERT_UINT8_WITHIN(2, 64, controller.getLeds()[0].b);
+
+    // EMERGENCY shows on the very next frame
+    controller.setPattern(LedPattern::EMERGENCY);
+    controller.update();
+    TEST_ASSERT_FALSE(controller.getTransition().isActive());
+    TEST_ASSERT_TRUE(controller.getLeds()[0] == atDefaultBrightness(PatternDefaults::COLOR_RED));
+}
+
+// Benchmark: crossfade cost per frame on the default strip and a long strip
+void test_benchmark_blend_cost() {
+    const uint32_t iterations = 5000;
+    static CRGB from[300];
+    static CRGB to[300];
+    static CRGB out[300];
+    fill_solid(from, 300, CRGB(255, 0, 0));
+    fill_solid(to, 300, CRGB(0, 0, 255));
+
+    Transition transition;
+    transition.start(TransitionType::CROSSFADE, 100, 0);
+
+    uint32_t start = micros();
+    for (uint32_t n = 0; n < iterations; n++) {
+        transition.blendFrames(out, from, to, TEST_NUM_LEDS, n & 0xFF);
+    }
+    uint32_t shortUs = micros() - start;
+
+    start = micros();
+    for (uint32_t n = 0; n < iterations; n++) {
+        transition.blendFrames(out, from, to, 300, n & 0xFF);
+    }
+    uint32_t longUs = micros() - start;
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "crossfade: %d LEDs %lu ns/frame, 300 LEDs %lu ns/frame", TEST_NUM_LEDS,
+             (unsigned long)((uint64_t)shortUs * 1000 / iterations),
+             (unsigned long)((uint64_t)longUs * 1000 / iterations));
+    TEST_MESSAGE(msg);
+
+    // Blending a long strip uses at most a quarter of the per-frame budget
+    TEST_ASSERT_LESS_OR_EQUAL(TRANSITION_FRAME_BUDGET_US / 4, longUs / iterations);
+}
+
+void setup() {
+    delay(2000); // Wait for serial monitor
+
+    UNITY_BEGIN();
+
+    // Transition timing tests
+    RUN_TEST(test_progress_follows_time);
+    RUN_TEST(test_cut_is_instant);
+    RUN_TEST(test_over_budget_cuts_short);
+
+    // Blend tests
+    RUN_TEST(test_crossfade_blend);
+    RUN_TEST(test_wipe_blend);
+    RUN_TEST(test_controller_crossfade_and_emergency_cut);
+
+    // Performance
+    RUN_TEST(test_benchmark_blend_cost);
+
+    UNITY_END();
+}
+
+void loop() {
+    // Tests run once in setup()
+}
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""Convert TRACE dumps from the base and drone serial consoles to Chrome trace JSON.
+
+Capture the serial output after sending TRACE to each ESP32 (e.g. with
+`pio device monitor | tee drone.log`), then:
+
+    tools/trace_to_chrome.py drone.log base.log -o trace.json
+
+and open trace.json in chrome://tracing or https://ui.perfetto.dev. Each device
+is shown as a process, with its WiFi callback and loop task as threads. Device
+clocks are independent, so timestamps are only comparable within one device.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+# Keep in sync with TraceEventId in trace_ring.h: id -> (name, thread)
+EVENT_NAMES = {
+    1: ("rx_callback", "wifi"),
+    2: ("parse", "wifi"),
+    3: ("apply", "wifi"),
+    4: ("render", "loop"),
+    5: ("show", "loop"),
+    16: ("serial_in", "loop"),
+    17: ("send", "loop"),
+    18: ("send_callback", "wifi"),
+}
+PHASES = {ord("B"): "B", ord("E"): "E", ord("i"): "i"}
+EVENT_FORMAT = "<IBBH"  # TraceEvent: timestampUs, id, phase, arg
+EVENT_SIZE = struct.calcsize(EVENT_FORMAT)
+THREAD_IDS = {"wifi": 1, "loop": 2}
+
+
+def parse_dumps(lines):
+    """Yield (device, [raw events]) for every complete TRACE dump in the log."""
+    device = None
+    data = bytearray()
+    for line in lines:
+        start = line.find("[TRACE] ")
+        if start < 0:
+            continue
+        fields = line[start + len("[TRACE] "):].split()
+        if not fields:
+            continue
+        if fields[0] == "BEGIN" and len(fields) >= 2:
+            device, data = fields[1], bytearray()
+        elif fields[0] == "END":
+            if device is not None:
+                usable = len(data) - len(data) % EVENT_SIZE
+                yield device, [struct.unpack_from(EVENT_FORMAT, data, i) for i in range(0, usable, EVENT_SIZE)]
+            device = None
+        elif device is not None:
+            try:
+                data.extend(bytes.fromhex(fields[0]))
+            except ValueError:
+                pass  # Line garbled by interleaved output
+
+
+def to_chrome_events(device, pid, raw_events):
+    """Convert one device's events (oldest first) to Chrome trace events."""
+    events = [
+        {"name": "process_name", "ph": "M", "pid": pid, "args": {"name": device}},
+    ]
+    for thread, tid in THREAD_IDS.items():
+        events.append({"name": "thread_name", "ph": "M", "pid": pid, "tid": tid, "args": {"name": thread}})
+
+    offset = 0
+    previous = None
+    open_slices = {}
+    for timestamp, event_id, phase, arg in raw_events:
+        if event_id not in EVENT_NAMES or phase not in PHASES:
+            continue  # Slot overwritten while dumping
+        # Unwrap the 32-bit microsecond clock (wraps every ~71 minutes)
+        if previous is not None and timestamp + offset < previous - (1 << 31):
+            offset += 1 << 32
+        ts = timestamp + offset
+        previous = ts
+
+        name, thread = EVENT_NAMES[event_id]
+        ph = PHASES[phase]
+        key = (name, thread)
+        if ph == "B":
+            open_slices[key] = open_slices.get(key, 0) + 1
+        elif ph == "E":
+            if not open_slices.get(key):
+                continue  # Its BEGIN was overwritten
+            open_slices[key] -= 1
+
+        event = {"name": name, "ph": ph, "ts": ts, "pid": pid, "tid": THREAD_IDS[thread], "args": {"arg": arg}}
+        if ph == "i":
+            event["s"] = "t"
+        events.append(event)
+
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("logs", nargs="+", help="Serial captures containing TRACE dumps")
+    parser.add_argument("-o", "--output", default="-", help="Output JSON file (default: stdout)")
+    args = parser.parse_args()
+
+    # The last dump of each device wins
+    dumps = {}
+    for path in args.logs:
+        with open(path, errors="replace") as f:
+            for device, raw_events in parse_dumps(f):
+                dumps[device] = raw_events
+    if not dumps:
+        sys.exit("No complete TRACE dump found")
+
+    trace = []
+    for pid, (device, raw_events) in enumerate(sorted(dumps.items()), start=1):
+        trace.extend(to_chrome_events(device, pid, raw_events))
+        print(f"{device}: {len(raw_events)} events", file=sys.stderr)
+
+    output = json.dumps({"traceEvents": trace, "displayTimeUnit": "ms"}, indent=1)
+    if args.output == "-":
+        print(output)
+    else:
+        with open(args.output, "w") as f:
+            f.write(output)
+
+
+if __name__ == "__main__":
+    main()